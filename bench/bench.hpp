@@ -0,0 +1,95 @@
+#ifndef OASIS_BENCH_BENCH_H
+#define OASIS_BENCH_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace oasis {
+namespace bench {
+
+/// Keeps the compiler from optimizing away a value computed by a benchmark
+template <typename T> inline void doNotOptimize(const T& val) {
+  asm volatile("" : : "r,m"(val) : "memory");
+}
+
+/// Handed to each benchmark. A benchmark calls `run` with the body it wants
+/// measured; the body is repeated, doubling the iteration count, until a run
+/// takes at least `minDuration`.
+class Bencher {
+private:
+  static constexpr std::chrono::milliseconds minDuration{200};
+
+  double nanosPerIter = 0;
+  uint64_t itemsPerIter = 1;
+  uint64_t bytesPerIter = 0;
+
+public:
+  /// How many logical items (ids, messages, ...) one iteration processes
+  void setItemsPerIter(uint64_t items) { this->itemsPerIter = items; }
+
+  /// How many bytes one iteration processes, used to report throughput
+  void setBytesPerIter(uint64_t bytes) { this->bytesPerIter = bytes; }
+
+  template <typename F> void run(F&& body) {
+    uint64_t iterations = 1;
+    while (true) {
+      auto start = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < iterations; i++) {
+        body();
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      if (elapsed >= minDuration) {
+        auto nanos = std::chrono::duration<double, std::nano>(elapsed).count();
+        this->nanosPerIter = nanos / iterations;
+        return;
+      }
+      iterations *= 2;
+    }
+  }
+
+  double getNanosPerItem() const {
+    return this->nanosPerIter / this->itemsPerIter;
+  }
+
+  double getItemsPerSecond() const {
+    return this->itemsPerIter * 1e9 / this->nanosPerIter;
+  }
+
+  double getBytesPerSecond() const {
+    return this->bytesPerIter * 1e9 / this->nanosPerIter;
+  }
+};
+
+using BenchFn = std::function<void(Bencher&)>;
+
+struct Benchmark {
+  std::string name;
+  BenchFn fn;
+};
+
+inline std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+inline bool registerBenchmark(std::string name, BenchFn fn) {
+  registry().push_back(Benchmark{std::move(name), std::move(fn)});
+  return true;
+}
+
+}; // namespace bench
+}; // namespace oasis
+
+/// Defines and registers a benchmark named "group/name"
+#define OASIS_BENCH(group, name)                                               \
+  static void group##_##name##_bench(oasis::bench::Bencher&);                  \
+  static const bool group##_##name##_registered =                              \
+      oasis::bench::registerBenchmark(#group "/" #name,                        \
+                                      group##_##name##_bench);                 \
+  static void group##_##name##_bench(oasis::bench::Bencher& b)
+
+#endif // OASIS_BENCH_BENCH_H
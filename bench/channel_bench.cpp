@@ -0,0 +1,237 @@
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "sync/broadcast.hpp"
+#include "sync/channel.hpp"
+#include "sync/mpmc.hpp"
+#include "sync/spsc.hpp"
+
+static const size_t messagesPerIter = 1 << 20;
+static const size_t batch = 1 << 10;
+
+// one thread alternately filling and draining a batch, the cost of the
+// operations themselves without any cross thread traffic
+template <typename S, typename R>
+static void benchSameThread(oasis::bench::Bencher& b, S& tx, R& rx) {
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < messagesPerIter; i += batch) {
+      for (size_t j = 0; j < batch; j++) {
+        tx.send(j);
+      }
+      for (size_t j = 0; j < batch; j++) {
+        oasis::bench::doNotOptimize(rx.recv().value());
+      }
+    }
+  });
+}
+
+// a producer thread streaming to a consumer thread
+template <typename S, typename R>
+static void benchStream(oasis::bench::Bencher& b, S& tx, R& rx) {
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    std::thread producer([&]() {
+      for (size_t i = 0; i < messagesPerIter; i++) {
+        tx.send(i);
+      }
+    });
+    for (size_t i = 0; i < messagesPerIter; i++) {
+      oasis::bench::doNotOptimize(rx.recv().value());
+    }
+    producer.join();
+  });
+}
+
+OASIS_BENCH(Channel, SameThread) {
+  auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();
+  benchSameThread(b, tx, rx);
+}
+
+OASIS_BENCH(Channel, Stream) {
+  auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();
+  benchStream(b, tx, rx);
+}
+
+// the same with a receiver that spins and yields before it parks, so a
+// sender rarely has a futex wake to do
+OASIS_BENCH(Channel, StreamSpinning) {
+  auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();
+  rx.setWaitStrategy({.spins = 1 << 12, .yields = 16});
+  benchStream(b, tx, rx);
+}
+
+OASIS_BENCH(SpscChannel, SameThread) {
+  auto [tx, rx] = oasis::sync::channel::mkSpscChannel< uint64_t >(batch);
+  benchSameThread(b, tx, rx);
+}
+
+// the same with the ready fd on, each batch being a burst that signals it
+// once and a receive finding the ring empty that rearms it
+OASIS_BENCH(SpscChannel, SameThreadReadyFd) {
+  auto [tx, rx] = oasis::sync::channel::mkSpscChannel< uint64_t >(batch);
+  oasis::bench::doNotOptimize(rx.readyFd());
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < messagesPerIter; i += batch) {
+      for (size_t j = 0; j < batch; j++) {
+        tx.send(j);
+      }
+      while (rx.tryRecv().value().has_value()) {
+      }
+    }
+  });
+}
+
+OASIS_BENCH(SpscChannel, Stream) {
+  auto [tx, rx] = oasis::sync::channel::mkSpscChannel< uint64_t >(batch);
+  benchStream(b, tx, rx);
+}
+
+OASIS_BENCH(MpmcChannel, SameThread) {
+  auto [tx, rx] = oasis::sync::channel::mkMpmcChannel< uint64_t >(batch);
+  benchSameThread(b, tx, rx);
+}
+
+// `threads` producers sending to `threads` consumers through one channel
+template <typename S, typename R>
+static void benchFanInOut(oasis::bench::Bencher& b, S& tx, R& rx, size_t threads) {
+  const size_t perThread = messagesPerIter / threads;
+  b.setItemsPerIter(perThread * threads);
+  b.run([&]() {
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < threads; t++) {
+      workers.emplace_back([&]() {
+        for (size_t i = 0; i < perThread; i++) {
+          tx.send(i);
+        }
+      });
+      workers.emplace_back([&]() {
+        for (size_t i = 0; i < perThread; i++) {
+          oasis::bench::doNotOptimize(rx.recv().value());
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  });
+}
+
+#define CHANNEL_SCALING_BENCH(threads)                                         \
+  OASIS_BENCH(Channel, FanInOut##threads) {                                    \
+    auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();             \
+    benchFanInOut(b, tx, rx, threads);                                         \
+  }                                                                            \
+  OASIS_BENCH(MpmcChannel, FanInOut##threads) {                                \
+    auto [tx, rx] = oasis::sync::channel::mkMpmcChannel< uint64_t >(batch);    \
+    benchFanInOut(b, tx, rx, threads);                                         \
+  }
+
+CHANNEL_SCALING_BENCH(1)
+CHANNEL_SCALING_BENCH(2)
+CHANNEL_SCALING_BENCH(4)
+CHANNEL_SCALING_BENCH(8)
+CHANNEL_SCALING_BENCH(16)
+CHANNEL_SCALING_BENCH(32)
+
+// the same traffic as Channel/SameThread, a batch per lock
+OASIS_BENCH(Channel, SameThreadBatched) {
+  auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();
+  std::vector< uint64_t > in(batch);
+  std::vector< uint64_t > out;
+  out.reserve(batch);
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < messagesPerIter; i += batch) {
+      tx.sendMany(in);
+      out.clear();
+      oasis::bench::doNotOptimize(rx.drainInto(out).value());
+    }
+  });
+}
+
+// a short lived channel per item, as for a request/response pair: create,
+// send one message, receive it and drop both ends
+OASIS_BENCH(Channel, CreateSendDrop) {
+  const size_t channels = 1 << 14;
+  b.setItemsPerIter(channels);
+  b.run([&]() {
+    for (size_t i = 0; i < channels; i++) {
+      auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();
+      tx.send(i);
+      oasis::bench::doNotOptimize(rx.recv().value());
+    }
+  });
+}
+
+// one message to each of 4 consumers, as a copy into a Channel per consumer
+// and as one write to a broadcast ring they all read
+static const size_t fanOut = 4;
+
+OASIS_BENCH(Channel, FanOut4Copies) {
+  std::vector< oasis::sync::channel::Sender< uint64_t > > txs;
+  std::vector< oasis::sync::channel::Receiver< uint64_t > > rxs;
+  for (size_t i = 0; i < fanOut; i++) {
+    auto [tx, rx] = oasis::sync::channel::mkChannel< uint64_t >();
+    txs.push_back(std::move(tx));
+    rxs.push_back(std::move(rx));
+  }
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < messagesPerIter; i += batch) {
+      for (size_t j = 0; j < batch; j++) {
+        for (auto& tx : txs) {
+          tx.send(j);
+        }
+      }
+      for (auto& rx : rxs) {
+        for (size_t j = 0; j < batch; j++) {
+          oasis::bench::doNotOptimize(rx.recv().value());
+        }
+      }
+    }
+  });
+}
+
+OASIS_BENCH(Broadcast, FanOut4) {
+  auto [publisher, first] = oasis::sync::channel::mkBroadcast< uint64_t >(batch);
+  std::vector< oasis::sync::channel::Subscriber< uint64_t > > subscribers;
+  subscribers.push_back(std::move(first));
+  for (size_t i = 1; i < fanOut; i++) {
+    subscribers.push_back(publisher.subscribe());
+  }
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < messagesPerIter; i += batch) {
+      for (size_t j = 0; j < batch; j++) {
+        publisher.publish(j);
+      }
+      for (auto& subscriber : subscribers) {
+        for (size_t j = 0; j < batch; j++) {
+          oasis::bench::doNotOptimize(subscriber.recv().value());
+        }
+      }
+    }
+  });
+}
+
+OASIS_BENCH(Broadcast, FanOut4Batched) {
+  auto [publisher, first] = oasis::sync::channel::mkBroadcast< uint64_t >(batch);
+  std::vector< oasis::sync::channel::Subscriber< uint64_t > > subscribers;
+  subscribers.push_back(std::move(first));
+  for (size_t i = 1; i < fanOut; i++) {
+    subscribers.push_back(publisher.subscribe());
+  }
+  std::vector< uint64_t > in(batch);
+  b.setItemsPerIter(messagesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < messagesPerIter; i += batch) {
+      publisher.publishMany(in);
+      for (auto& subscriber : subscribers) {
+        subscriber.poll([](const uint64_t& val) { oasis::bench::doNotOptimize(val); });
+      }
+    }
+  });
+}
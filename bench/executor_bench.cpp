@@ -0,0 +1,117 @@
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "sync/channel.hpp"
+#include "sync/executor.hpp"
+
+using oasis::sync::Executor;
+using oasis::sync::TaskGroup;
+
+static const size_t workerThreads = 4;
+static const size_t tasksPerIter = 1 << 16;
+
+static uint64_t fib(Executor& exec, uint32_t n) {
+  if (n < 2) {
+    return n;
+  }
+  uint64_t left = 0;
+  TaskGroup group(exec);
+  group.spawn([&]() { left = fib(exec, n - 1); });
+  uint64_t right = fib(exec, n - 2);
+  group.wait();
+  return left + right;
+}
+
+// naive recursive fibonacci with a task per call, all overhead and no work:
+// the cost of a fork and a join when nearly every task runs on the worker
+// that spawned it
+OASIS_BENCH(Executor, ForkJoinFib) {
+  const uint32_t n = 22;
+  Executor exec(workerThreads);
+  // one spawn per call that doesn't bottom out, fib(n + 1) - 1 of them
+  b.setItemsPerIter(28656);
+  b.run([&]() {
+    uint64_t result = 0;
+    TaskGroup group(exec);
+    group.spawn([&]() { result = fib(exec, n); });
+    group.wait();
+    oasis::bench::doNotOptimize(result);
+  });
+}
+
+// one outside thread handing out a burst of small independent tasks, through
+// the injection queue
+OASIS_BENCH(Executor, FanOut) {
+  Executor exec(workerThreads);
+  std::atomic<uint64_t> sum = 0;
+  b.setItemsPerIter(tasksPerIter);
+  b.run([&]() {
+    TaskGroup group(exec);
+    for (size_t i = 0; i < tasksPerIter; i++) {
+      group.spawn([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); });
+    }
+    group.wait();
+  });
+  oasis::bench::doNotOptimize(sum.load());
+}
+
+// a task fanning out to many more from inside the pool, onto its own deque
+// for the other workers to steal
+OASIS_BENCH(Executor, FanOutFromWorker) {
+  Executor exec(workerThreads);
+  std::atomic<uint64_t> sum = 0;
+  b.setItemsPerIter(tasksPerIter);
+  b.run([&]() {
+    TaskGroup outer(exec);
+    outer.spawn([&]() {
+      TaskGroup group(exec);
+      for (size_t i = 0; i < tasksPerIter; i++) {
+        group.spawn([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); });
+      }
+      group.wait();
+    });
+    outer.wait();
+  });
+  oasis::bench::doNotOptimize(sum.load());
+}
+
+// the same burst as Executor/FanOut on the pool it replaces: threads all
+// receiving std::function tasks from one shared channel
+OASIS_BENCH(Executor, FanOutChannelPool) {
+  using Task = std::function<void()>;
+  auto [tx, rx] = oasis::sync::channel::mkChannel< Task >();
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < workerThreads; t++) {
+    pool.emplace_back([rx = rx]() mutable {
+      while (auto task = rx.recv()) {
+        (*task)();
+      }
+    });
+  }
+
+  std::atomic<uint64_t> sum = 0;
+  std::atomic<size_t> done = 0;
+  b.setItemsPerIter(tasksPerIter);
+  b.run([&]() {
+    done.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < tasksPerIter; i++) {
+      tx.send([&sum, &done, i]() {
+        sum.fetch_add(i, std::memory_order_relaxed);
+        done.fetch_add(1, std::memory_order_release);
+      });
+    }
+    while (done.load(std::memory_order_acquire) < tasksPerIter) {
+      std::this_thread::yield();
+    }
+  });
+  oasis::bench::doNotOptimize(sum.load());
+
+  tx.shutdown();
+  for (auto& t : pool) {
+    t.join();
+  }
+}
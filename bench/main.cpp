@@ -0,0 +1,31 @@
+#include <cstdio>
+#include <string_view>
+
+#include "bench.hpp"
+
+// usage: oasis_bench [filter]
+//
+// runs every registered benchmark whose name contains `filter`
+int main(int argc, char** argv) {
+  std::string_view filter = argc > 1 ? argv[1] : "";
+
+  std::printf("%-48s %14s %16s %12s\n", "benchmark", "ns/item", "items/s",
+              "GB/s");
+  for (auto& benchmark : oasis::bench::registry()) {
+    if (benchmark.name.find(filter) == std::string::npos) {
+      continue;
+    }
+
+    oasis::bench::Bencher bencher;
+    benchmark.fn(bencher);
+
+    std::printf("%-48s %14.2f %16.0f", benchmark.name.c_str(),
+                bencher.getNanosPerItem(), bencher.getItemsPerSecond());
+    if (bencher.getBytesPerSecond() > 0) {
+      std::printf(" %12.3f\n", bencher.getBytesPerSecond() / 1e9);
+    } else {
+      std::printf(" %12s\n", "-");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include <chrono>
+
+#include "bench.hpp"
+#include "time.hpp"
+
+static const size_t readsPerIter = 1'000;
+
+template <typename C>
+static void benchClock(oasis::bench::Bencher& b) {
+  b.setItemsPerIter(readsPerIter);
+  b.run([]() {
+    for (size_t i = 0; i < readsPerIter; i++) {
+      oasis::bench::doNotOptimize(C::nowNanos());
+    }
+  });
+}
+
+OASIS_BENCH(Time, RealtimeClock) {
+  benchClock< oasis::time::RealtimeClock >(b);
+}
+
+OASIS_BENCH(Time, CoarseRealtimeClock) {
+  benchClock< oasis::time::CoarseRealtimeClock >(b);
+}
+
+OASIS_BENCH(Time, MonotonicClock) {
+  benchClock< oasis::time::MonotonicClock >(b);
+}
+
+OASIS_BENCH(Time, TscClock) {
+  oasis::time::TscClock::calibrate();
+  benchClock< oasis::time::TscClock >(b);
+}
+
+OASIS_BENCH(Time, CachedClockMillis) {
+  oasis::time::CachedClock::Session session;
+  b.setItemsPerIter(readsPerIter);
+  b.run([]() {
+    for (size_t i = 0; i < readsPerIter; i++) {
+      oasis::bench::doNotOptimize(oasis::time::CachedClock::nowMillis());
+    }
+  });
+}
+
+// what millisSinceEpoch() used to do
+OASIS_BENCH(Time, StdSystemClockMillis) {
+  b.setItemsPerIter(readsPerIter);
+  b.run([]() {
+    for (size_t i = 0; i < readsPerIter; i++) {
+      auto now = std::chrono::system_clock::now().time_since_epoch();
+      oasis::bench::doNotOptimize(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+    }
+  });
+}
+
+OASIS_BENCH(Time, MillisSinceEpoch) {
+  b.setItemsPerIter(readsPerIter);
+  b.run([]() {
+    for (size_t i = 0; i < readsPerIter; i++) {
+      oasis::bench::doNotOptimize(oasis::time::millisSinceEpoch());
+    }
+  });
+}
@@ -0,0 +1,67 @@
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "time/histogram.hpp"
+
+static const size_t valuesPerIter = 1 << 16;
+
+static std::vector< uint64_t > mkLatencies() {
+  std::mt19937_64 rng(1);
+  std::lognormal_distribution< double > latency(10, 1.5);
+  std::vector< uint64_t > values(valuesPerIter);
+  for (auto& value : values) {
+    value = static_cast<uint64_t>(latency(rng));
+  }
+  return values;
+}
+
+OASIS_BENCH(Histogram, Record) {
+  auto values = mkLatencies();
+  oasis::time::Histogram histogram;
+  b.setItemsPerIter(valuesPerIter);
+  b.run([&]() {
+    for (uint64_t value : values) {
+      histogram.record(value);
+    }
+  });
+  oasis::bench::doNotOptimize(histogram.count());
+}
+
+OASIS_BENCH(LatencyRecorder, Record) {
+  auto values = mkLatencies();
+  oasis::time::LatencyRecorder recorder;
+  b.setItemsPerIter(valuesPerIter);
+  b.run([&]() {
+    for (uint64_t value : values) {
+      recorder.record(value);
+    }
+  });
+}
+
+// recording as it's typically used, around a timed section
+OASIS_BENCH(LatencyRecorder, ScopedLatency) {
+  oasis::time::TscClock::calibrate();
+  oasis::time::LatencyRecorder recorder;
+  b.setItemsPerIter(valuesPerIter);
+  b.run([&]() {
+    for (size_t i = 0; i < valuesPerIter; i++) {
+      oasis::time::ScopedLatency timed(recorder);
+    }
+  });
+}
+
+OASIS_BENCH(LatencyRecorder, SnapshotPercentiles) {
+  auto values = mkLatencies();
+  oasis::time::LatencyRecorder recorder;
+  for (uint64_t value : values) {
+    recorder.record(value);
+  }
+  oasis::time::Histogram histogram;
+  b.setItemsPerIter(1);
+  b.run([&]() {
+    histogram.reset();
+    recorder.snapshotInto(histogram);
+    oasis::bench::doNotOptimize(histogram.percentile(99.9));
+  });
+}
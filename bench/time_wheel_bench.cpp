@@ -0,0 +1,94 @@
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "time/wheel.hpp"
+
+static const size_t numTimers = 1 << 20;
+
+static void noop(oasis::time::Timer&, void*) {}
+
+// timers can't move, a deque constructs them in place
+static std::deque< oasis::time::Timer > mkTimers() {
+  std::deque< oasis::time::Timer > timers;
+  for (size_t i = 0; i < numTimers; i++) {
+    timers.emplace_back(noop, nullptr);
+  }
+  return timers;
+}
+
+static std::vector< uint64_t > mkDelays(uint64_t maxDelay) {
+  std::mt19937_64 rng(1);
+  std::vector< uint64_t > delays(numTimers);
+  for (auto& delay : delays) {
+    delay = 1 + rng() % maxDelay;
+  }
+  return delays;
+}
+
+// the idle timeout pattern, every timer is pushed back before it fires
+OASIS_BENCH(TimerWheel, ScheduleCancel) {
+  auto delays = mkDelays(30'000);
+  auto timers = mkTimers();
+  oasis::time::TimerWheel wheel(0);
+  b.setItemsPerIter(numTimers);
+  b.run([&]() {
+    for (size_t i = 0; i < numTimers; i++) {
+      wheel.scheduleAfter(timers[i], delays[i]);
+    }
+    for (size_t i = 0; i < numTimers; i++) {
+      wheel.cancel(timers[i]);
+    }
+  });
+}
+
+OASIS_BENCH(StdMultimap, ScheduleCancel) {
+  auto delays = mkDelays(30'000);
+  std::multimap< uint64_t, size_t > timers;
+  std::vector< std::multimap< uint64_t, size_t >::iterator > handles(numTimers);
+  b.setItemsPerIter(numTimers);
+  b.run([&]() {
+    for (size_t i = 0; i < numTimers; i++) {
+      handles[i] = timers.emplace(delays[i], i);
+    }
+    for (size_t i = 0; i < numTimers; i++) {
+      timers.erase(handles[i]);
+    }
+  });
+}
+
+// a million timers over 30s of 1ms ticks, every one firing
+OASIS_BENCH(TimerWheel, ScheduleAndExpire) {
+  auto delays = mkDelays(30'000);
+  auto timers = mkTimers();
+  b.setItemsPerIter(numTimers);
+  b.run([&]() {
+    oasis::time::TimerWheel wheel(0);
+    for (size_t i = 0; i < numTimers; i++) {
+      wheel.schedule(timers[i], delays[i]);
+    }
+    size_t fired = 0;
+    for (uint64_t tick = 1; tick <= 30'000; tick++) {
+      fired += wheel.advance(tick);
+    }
+    oasis::bench::doNotOptimize(fired);
+  });
+}
+
+// the per tick cost with a million timers pending and none due
+OASIS_BENCH(TimerWheel, IdleTick) {
+  auto timers = mkTimers();
+  oasis::time::TimerWheel wheel(0);
+  for (size_t i = 0; i < numTimers; i++) {
+    wheel.schedule(timers[i], 1'000'000'000 + i);
+  }
+  uint64_t tick = 0;
+  b.setItemsPerIter(1'000);
+  b.run([&]() {
+    for (int i = 0; i < 1'000; i++) {
+      oasis::bench::doNotOptimize(wheel.advance(++tick));
+    }
+  });
+}
@@ -0,0 +1,39 @@
+#include "bench.hpp"
+#include "trace.hpp"
+
+static const size_t spansPerIter = 1 << 16;
+
+static void benchSpans(oasis::bench::Bencher& b) {
+  b.setItemsPerIter(spansPerIter);
+  b.run([]() {
+    for (size_t i = 0; i < spansPerIter; i++) {
+      oasis::trace::Span span("bench");
+      oasis::bench::doNotOptimize(i);
+    }
+  });
+}
+
+OASIS_BENCH(Trace, SpanDisabled) {
+  oasis::trace::disable();
+  benchSpans(b);
+}
+
+OASIS_BENCH(Trace, SpanEnabled) {
+  oasis::time::TscClock::calibrate();
+  oasis::trace::enable();
+  benchSpans(b);
+  oasis::trace::disable();
+  oasis::trace::clear();
+}
+
+OASIS_BENCH(Trace, InstantEnabled) {
+  oasis::trace::enable();
+  b.setItemsPerIter(spansPerIter);
+  b.run([]() {
+    for (size_t i = 0; i < spansPerIter; i++) {
+      oasis::trace::instant("bench", i);
+    }
+  });
+  oasis::trace::disable();
+  oasis::trace::clear();
+}
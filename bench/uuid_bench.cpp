@@ -0,0 +1,157 @@
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "uuid.hpp"
+
+static const size_t batchSize = 64 * 1024;
+
+OASIS_BENCH(Uuid, V7PerCall) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  b.setItemsPerIter(batchSize);
+  b.run([&]() {
+    for (auto& uuid : uuids) {
+      uuid = oasis::uuid::Uuid::v7();
+    }
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(Uuid, V7PerCallCoarseClock) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  b.setItemsPerIter(batchSize);
+  b.run([&]() {
+    for (auto& uuid : uuids) {
+      uuid = oasis::uuid::Uuid::v7< oasis::time::CoarseRealtimeClock >();
+    }
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(Uuid, V7PerCallCachedClock) {
+  oasis::time::CachedClock::Session session;
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  b.setItemsPerIter(batchSize);
+  b.run([&]() {
+    for (auto& uuid : uuids) {
+      uuid = oasis::uuid::Uuid::v7< oasis::time::CachedClock >();
+    }
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(Uuid, V7Batch) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  b.setItemsPerIter(batchSize);
+  b.run([&]() {
+    oasis::uuid::Uuid::v7Batch(uuids);
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(Uuid, V4PerCall) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  b.setItemsPerIter(batchSize);
+  b.run([&]() {
+    for (auto& uuid : uuids) {
+      uuid = oasis::uuid::Uuid::v4();
+    }
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(Uuid, V4Batch) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  b.setItemsPerIter(batchSize);
+  b.setBytesPerIter(batchSize * sizeof(oasis::uuid::Uuid));
+  b.run([&]() {
+    oasis::uuid::Uuid::v4Batch(uuids);
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(Uuid, FormatOstream) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  b.setItemsPerIter(batchSize);
+  b.run([&]() {
+    std::stringstream ss;
+    for (auto& uuid : uuids) {
+      ss << uuid;
+    }
+    oasis::bench::doNotOptimize(ss);
+  });
+}
+
+OASIS_BENCH(Uuid, ToChars) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  std::vector< char > out(oasis::uuid::Uuid::stringLength * batchSize);
+  b.setItemsPerIter(batchSize);
+  b.setBytesPerIter(out.size());
+  b.run([&]() {
+    char* dst = out.data();
+    for (auto& uuid : uuids) {
+      uuid.toChars(*reinterpret_cast<char(*)[oasis::uuid::Uuid::stringLength]>(dst));
+      dst += oasis::uuid::Uuid::stringLength;
+    }
+    oasis::bench::doNotOptimize(out.data());
+  });
+}
+
+OASIS_BENCH(Uuid, ToCharsMany) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  std::vector< char > out(oasis::uuid::Uuid::stringLength * batchSize);
+  b.setItemsPerIter(batchSize);
+  b.setBytesPerIter(out.size());
+  b.run([&]() {
+    oasis::uuid::toCharsMany(uuids, out);
+    oasis::bench::doNotOptimize(out.data());
+  });
+}
+
+OASIS_BENCH(Uuid, FromCharsMany) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  std::vector< char > str(oasis::uuid::Uuid::stringLength * batchSize);
+  oasis::uuid::toCharsMany(uuids, str);
+  b.setItemsPerIter(batchSize);
+  b.setBytesPerIter(str.size());
+  b.run([&]() {
+    oasis::bench::doNotOptimize(oasis::uuid::fromCharsMany(str, uuids));
+  });
+}
+
+static void benchParseMany(oasis::bench::Bencher& b, size_t invalidEvery) {
+  std::vector< oasis::uuid::Uuid > uuids(batchSize);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  std::vector< char > str(oasis::uuid::Uuid::stringLength * batchSize);
+  oasis::uuid::toCharsMany(uuids, str);
+
+  std::vector< std::string_view > views;
+  for (size_t i = 0; i < batchSize; i++) {
+    char* start = str.data() + i * oasis::uuid::Uuid::stringLength;
+    if (invalidEvery != 0 && i % invalidEvery == 0) {
+      start[7] = 'x';
+    }
+    views.emplace_back(start, oasis::uuid::Uuid::stringLength);
+  }
+
+  std::vector< oasis::uuid::UuidParseFailure > failures;
+  b.setItemsPerIter(batchSize);
+  b.setBytesPerIter(str.size());
+  b.run([&]() {
+    failures.clear();
+    oasis::bench::doNotOptimize(oasis::uuid::parseMany(views, uuids, failures));
+  });
+}
+
+OASIS_BENCH(Uuid, ParseManyValid) {
+  benchParseMany(b, 0);
+}
+
+OASIS_BENCH(Uuid, ParseManyOnePercentInvalid) {
+  benchParseMany(b, 100);
+}
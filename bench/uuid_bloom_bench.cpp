@@ -0,0 +1,72 @@
+#include <memory>
+#include <vector>
+
+#include "bench.hpp"
+#include "uuid.hpp"
+#include "uuid/bloom.hpp"
+#include "uuid/map.hpp"
+
+static const size_t numIds = 1 << 22;
+
+static std::vector< oasis::uuid::Uuid > mkIds() {
+  std::vector< oasis::uuid::Uuid > uuids(numIds);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  return uuids;
+}
+
+// a 1% filter of 4M ids is ~5MB, bigger than the cache
+static oasis::uuid::UuidBloomFilter mkFilter(const std::vector< oasis::uuid::Uuid >& uuids) {
+  auto filter = oasis::uuid::UuidBloomFilter::forCapacity(numIds, 0.01);
+  filter.insertMany(uuids);
+  return filter;
+}
+
+OASIS_BENCH(UuidBloom, InsertMany) {
+  auto uuids = mkIds();
+  auto filter = oasis::uuid::UuidBloomFilter::forCapacity(numIds, 0.01);
+  b.setItemsPerIter(numIds);
+  b.run([&]() {
+    filter.insertMany(uuids);
+    oasis::bench::doNotOptimize(&filter);
+  });
+}
+
+OASIS_BENCH(UuidBloom, MayContainMiss) {
+  auto filter = mkFilter(mkIds());
+  auto others = mkIds();
+  b.setItemsPerIter(numIds);
+  b.run([&]() {
+    size_t positives = 0;
+    for (auto& uuid : others) {
+      positives += filter.mayContain(uuid);
+    }
+    oasis::bench::doNotOptimize(positives);
+  });
+}
+
+OASIS_BENCH(UuidBloom, MayContainManyMiss) {
+  auto filter = mkFilter(mkIds());
+  auto others = mkIds();
+  auto out = std::make_unique< bool[] >(numIds);
+  b.setItemsPerIter(numIds);
+  b.run([&]() {
+    oasis::bench::doNotOptimize(filter.mayContainMany(others, std::span(out.get(), numIds)));
+  });
+}
+
+// the exact alternative, for comparison
+OASIS_BENCH(UuidSet, ContainsMiss) {
+  oasis::uuid::UuidSet set;
+  for (auto& uuid : mkIds()) {
+    set.insert(uuid);
+  }
+  auto others = mkIds();
+  b.setItemsPerIter(numIds);
+  b.run([&]() {
+    size_t positives = 0;
+    for (auto& uuid : others) {
+      positives += set.contains(uuid);
+    }
+    oasis::bench::doNotOptimize(positives);
+  });
+}
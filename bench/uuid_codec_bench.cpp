@@ -0,0 +1,44 @@
+#include <vector>
+
+#include "bench.hpp"
+#include "uuid.hpp"
+#include "uuid/codec.hpp"
+
+static const size_t numIds = 1 << 20;
+
+OASIS_BENCH(UuidV7Column, Encode) {
+  std::vector< oasis::uuid::Uuid > uuids(numIds);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  b.setItemsPerIter(numIds);
+  b.setBytesPerIter(numIds * sizeof(oasis::uuid::Uuid));
+  b.run([&]() {
+    oasis::uuid::UuidV7Column column(uuids);
+    oasis::bench::doNotOptimize(column.bytes().data());
+  });
+}
+
+OASIS_BENCH(UuidV7Column, Decode) {
+  std::vector< oasis::uuid::Uuid > uuids(numIds);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::UuidV7Column column(uuids);
+  b.setItemsPerIter(numIds);
+  b.setBytesPerIter(numIds * sizeof(oasis::uuid::Uuid));
+  b.run([&]() {
+    column.decode(uuids);
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(UuidV7Column, RandomAccess) {
+  std::vector< oasis::uuid::Uuid > uuids(numIds);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::UuidV7Column column(uuids);
+  b.setItemsPerIter(1'000);
+  b.run([&]() {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < 1'000; i++) {
+      sum += column.at((i * 7919) % numIds).timestampMillis();
+    }
+    oasis::bench::doNotOptimize(sum);
+  });
+}
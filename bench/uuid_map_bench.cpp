@@ -0,0 +1,90 @@
+#include <unordered_map>
+#include <vector>
+
+#include "bench.hpp"
+#include "uuid.hpp"
+#include "uuid/map.hpp"
+
+static const size_t numKeys = 1 << 20;
+
+static std::vector< oasis::uuid::Uuid > mkKeys() {
+  std::vector< oasis::uuid::Uuid > keys(numKeys);
+  oasis::uuid::Uuid::v7Batch(keys);
+  return keys;
+}
+
+OASIS_BENCH(UuidMap, Insert) {
+  auto keys = mkKeys();
+  b.setItemsPerIter(numKeys);
+  b.run([&]() {
+    oasis::uuid::UuidMap< uint64_t > map;
+    for (uint64_t i = 0; i < keys.size(); i++) {
+      map.insert(keys[i], i);
+    }
+    oasis::bench::doNotOptimize(map.size());
+  });
+}
+
+OASIS_BENCH(StdUnorderedMap, Insert) {
+  auto keys = mkKeys();
+  b.setItemsPerIter(numKeys);
+  b.run([&]() {
+    std::unordered_map< oasis::uuid::Uuid, uint64_t > map;
+    for (uint64_t i = 0; i < keys.size(); i++) {
+      map.insert({keys[i], i});
+    }
+    oasis::bench::doNotOptimize(map.size());
+  });
+}
+
+OASIS_BENCH(UuidMap, FindHit) {
+  auto keys = mkKeys();
+  oasis::uuid::UuidMap< uint64_t > map;
+  for (uint64_t i = 0; i < keys.size(); i++) {
+    map.insert(keys[i], i);
+  }
+
+  b.setItemsPerIter(numKeys);
+  b.run([&]() {
+    uint64_t sum = 0;
+    for (auto& key : keys) {
+      sum += *map.find(key);
+    }
+    oasis::bench::doNotOptimize(sum);
+  });
+}
+
+OASIS_BENCH(StdUnorderedMap, FindHit) {
+  auto keys = mkKeys();
+  std::unordered_map< oasis::uuid::Uuid, uint64_t > map;
+  for (uint64_t i = 0; i < keys.size(); i++) {
+    map.insert({keys[i], i});
+  }
+
+  b.setItemsPerIter(numKeys);
+  b.run([&]() {
+    uint64_t sum = 0;
+    for (auto& key : keys) {
+      sum += map.find(key)->second;
+    }
+    oasis::bench::doNotOptimize(sum);
+  });
+}
+
+OASIS_BENCH(UuidMap, FindMiss) {
+  auto keys = mkKeys();
+  auto misses = mkKeys();
+  oasis::uuid::UuidMap< uint64_t > map;
+  for (uint64_t i = 0; i < keys.size(); i++) {
+    map.insert(keys[i], i);
+  }
+
+  b.setItemsPerIter(numKeys);
+  b.run([&]() {
+    size_t found = 0;
+    for (auto& key : misses) {
+      found += map.contains(key);
+    }
+    oasis::bench::doNotOptimize(found);
+  });
+}
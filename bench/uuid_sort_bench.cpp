@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "uuid.hpp"
+#include "uuid/sort.hpp"
+
+static const size_t numIds = 1 << 22;
+
+static std::vector< oasis::uuid::Uuid > shuffledIds() {
+  std::vector< oasis::uuid::Uuid > uuids(numIds);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  // a quarter of the ids show up twice
+  std::copy(uuids.begin(), uuids.begin() + numIds / 4, uuids.end() - numIds / 4);
+  std::shuffle(uuids.begin(), uuids.end(), std::mt19937_64(1));
+  return uuids;
+}
+
+// each iteration sorts a fresh copy, so the copy is part of every number
+static void benchSort(oasis::bench::Bencher& b,
+                      void (*sort)(std::vector< oasis::uuid::Uuid >&)) {
+  auto input = shuffledIds();
+  std::vector< oasis::uuid::Uuid > uuids(numIds);
+  b.setItemsPerIter(numIds);
+  b.run([&]() {
+    std::copy(input.begin(), input.end(), uuids.begin());
+    sort(uuids);
+    oasis::bench::doNotOptimize(uuids.data());
+  });
+}
+
+OASIS_BENCH(UuidSort, StdSort) {
+  benchSort(b, [](std::vector< oasis::uuid::Uuid >& uuids) {
+    std::sort(uuids.begin(), uuids.end());
+  });
+}
+
+OASIS_BENCH(UuidSort, RadixSortOneThread) {
+  benchSort(b, [](std::vector< oasis::uuid::Uuid >& uuids) {
+    oasis::uuid::radixSort(uuids, 1);
+  });
+}
+
+OASIS_BENCH(UuidSort, RadixSortAllThreads) {
+  benchSort(b, [](std::vector< oasis::uuid::Uuid >& uuids) {
+    oasis::uuid::radixSort(uuids);
+  });
+}
+
+OASIS_BENCH(UuidSort, StdSortThenUnique) {
+  benchSort(b, [](std::vector< oasis::uuid::Uuid >& uuids) {
+    std::sort(uuids.begin(), uuids.end());
+    oasis::bench::doNotOptimize(std::unique(uuids.begin(), uuids.end()));
+  });
+}
+
+OASIS_BENCH(UuidSort, SortUniqueAllThreads) {
+  benchSort(b, [](std::vector< oasis::uuid::Uuid >& uuids) {
+    oasis::bench::doNotOptimize(oasis::uuid::sortUnique(uuids));
+  });
+}
@@ -5,6 +5,8 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include "../trace.hpp"
+
 namespace oasis {
 namespace net {
 
@@ -22,7 +24,9 @@ public:
   bool isClosed() const { return is_closed; }
 
   int read(const char *buf, int size) {
+    trace::Span span("tcp.read");
     const int result = recv(connfd, (void *)buf, size, 0);
+    span.setArg(result > 0 ? result : 0);
     if (result == 0) {
       is_closed = true;
     }
@@ -30,7 +34,9 @@ public:
   }
 
   int readExact(char *buf, int size) {
+    trace::Span span("tcp.readExact");
     int result = recv(connfd, buf, size, MSG_WAITALL);
+    span.setArg(result > 0 ? result : 0);
     if (result == 0) {
       is_closed = true;
     }
@@ -38,6 +44,8 @@ public:
   }
 
   void write(const std::vector<uint8_t> &buf) {
+    trace::Span span("tcp.write");
+    span.setArg(buf.size());
     send(connfd, buf.data(), buf.size(), 0);
   }
 
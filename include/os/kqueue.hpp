@@ -14,6 +14,8 @@
 #include <thread>
 #include <unordered_map>
 
+#include "../trace.hpp"
+
 namespace oasis {
 namespace os {
 
@@ -174,7 +176,12 @@ inline std::expected< void, KqueuePollerError > KqueuePoller::mainLoop() {
   struct kevent events[maxEvents];
 
   while (!this->shutdownSignal.load(std::memory_order_relaxed)) {
-    uint32_t numEvents = kevent(this->kqfd, NULL, 0, events, maxEvents, &this->TIMEOUT);
+    uint32_t numEvents;
+    {
+      trace::Span span("kqueue.wait");
+      numEvents = kevent(this->kqfd, NULL, 0, events, maxEvents, &this->TIMEOUT);
+      span.setArg(numEvents);
+    }
 
     if (numEvents == -1) {
       // TODO [matthew-russo 09-02-2024] handle error
@@ -186,6 +193,8 @@ inline std::expected< void, KqueuePollerError > KqueuePoller::mainLoop() {
         struct kevent event = events[idx];
         KqueuePair pair(event.ident, event.filter);
         KqueuePollerHandle selfHandle(this);
+        trace::Span span("kqueue.handle");
+        span.setArg(event.ident);
         std::shared_lock guard(this->handlersGuard);
         this->handlers.at(pair).handle(&selfHandle, event);
       }
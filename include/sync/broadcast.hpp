@@ -0,0 +1,512 @@
+#ifndef OASIS_SYNC_BROADCAST_H
+#define OASIS_SYNC_BROADCAST_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include "channel.hpp"
+#include "fence.hpp"
+
+namespace oasis {
+namespace sync {
+namespace channel {
+
+/// What a broadcast publisher does when the slowest subscriber is a whole
+/// ring behind
+enum class Overflow {
+  /// wait for it to make room, so every subscriber sees every message
+  Block,
+  /// overwrite the oldest message anyway. the subscriber skips ahead past
+  /// what was overwritten and counts it in dropped()
+  DropOldest,
+};
+
+/// A ring that one publisher writes and every subscriber reads all of.
+///
+/// A message is written once, into a power of two ring, and each subscriber
+/// keeps its own cursor (the next sequence it reads) on a cache line of its
+/// own. Publishing is a slot write and a store of the published sequence; the
+/// publisher only looks at the cursors, under a lock, when a copy it keeps of
+/// the slowest one says the ring may be full, i.e. about once a lap.
+///
+/// With DropOldest a subscriber that falls a lap behind has its cursor moved
+/// forward by the publisher. To keep the publisher from overwriting a slot
+/// while it's being read, a subscriber marks its cursor busy (a CAS) for the
+/// time it reads, and the publisher waits that out.
+///
+/// Waiting on either side spins, then parks, with the fence handshake of the
+/// SPSC channel. Once the publisher is dropped subscribers read what's left,
+/// then get Shutdown.
+template <typename T, Overflow overflow> class Broadcast {
+private:
+  static constexpr uint32_t spinIterations = 1 << 8;
+  static constexpr WaitStrategy defaultWait = {.spins = spinIterations};
+  static constexpr uint64_t busy = uint64_t(1) << 63;
+
+  struct Slot {
+    alignas(T) unsigned char bytes[sizeof(T)];
+
+    T* get() { return std::launder(reinterpret_cast<T*>(this->bytes)); }
+  };
+
+  struct alignas(cacheLineSize) Cursor {
+    // the next sequence to read, with `busy` set while it's being read
+    std::atomic<uint64_t> next = 0;
+    // the subscriber's own: where it left `next`, which the publisher may
+    // have moved on since, and how many messages that has skipped
+    uint64_t read = 0;
+    uint64_t dropped = 0;
+    // under subscribersLock
+    bool active = false;
+  };
+
+  // the publisher's line
+  alignas(cacheLineSize) std::atomic<uint64_t> published = 0;
+  // no cursor is below this, so the publisher can fill the ring up to it
+  // without looking
+  uint64_t cachedSlowest = 0;
+
+  alignas(cacheLineSize) std::atomic<bool> isClosed = false;
+  std::atomic<bool> publisherParked = false;
+  std::atomic<uint32_t> subscribersParked = 0;
+  std::unique_ptr<Slot[]> slots;
+  uint64_t mask;
+
+  std::mutex lock;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+
+  // cursors are reused as subscribers come and go, and only freed with the
+  // ring so a subscriber's pointer stays good
+  std::mutex subscribersLock;
+  std::vector<std::unique_ptr<Cursor>> cursors;
+
+  void wakeSubscribers() {
+    lightFence();
+    if (this->subscribersParked.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notEmpty.notify_all();
+    }
+  }
+
+  void wakePublisher() {
+    lightFence();
+    if (this->publisherParked.load(std::memory_order_relaxed)) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notFull.notify_one();
+    }
+  }
+
+  // publisher side. the lowest cursor, or the published sequence when nobody
+  // subscribes
+  uint64_t slowest() {
+    std::lock_guard<std::mutex> guard(this->subscribersLock);
+    uint64_t lowest = this->published.load(std::memory_order_relaxed);
+    for (const std::unique_ptr<Cursor>& cursor : this->cursors) {
+      if (cursor->active) {
+        lowest = std::min(lowest, cursor->next.load(std::memory_order_acquire) & ~busy);
+      }
+    }
+    return lowest;
+  }
+
+  // DropOldest: moves every cursor below `floor` up to it, waiting for any
+  // that's being read, and returns the lowest cursor after
+  uint64_t overtake(uint64_t floor) {
+    std::lock_guard<std::mutex> guard(this->subscribersLock);
+    uint64_t lowest = this->published.load(std::memory_order_relaxed);
+    for (const std::unique_ptr<Cursor>& cursor : this->cursors) {
+      if (!cursor->active) {
+        continue;
+      }
+      uint64_t next = cursor->next.load(std::memory_order_acquire);
+      while ((next & ~busy) < floor) {
+        if (next & busy) {
+          cpuRelax();
+          next = cursor->next.load(std::memory_order_acquire);
+        } else if (cursor->next.compare_exchange_weak(next, floor, std::memory_order_acq_rel)) {
+          next = floor;
+        }
+      }
+      lowest = std::min(lowest, next & ~busy);
+    }
+    return lowest;
+  }
+
+  // makes room for every sequence below `end`: each subscriber has to be
+  // past `end - capacity` before those slots are overwritten
+  void reserve(uint64_t end) {
+    if (end <= this->capacity() || end - this->capacity() <= this->cachedSlowest) {
+      return;
+    }
+    uint64_t floor = end - this->capacity();
+    if constexpr (overflow == Overflow::DropOldest) {
+      this->cachedSlowest = this->overtake(floor);
+      return;
+    }
+
+    for (uint32_t spins = 0; (this->cachedSlowest = this->slowest()) < floor; spins++) {
+      if (spins < spinIterations) {
+        cpuRelax();
+        continue;
+      }
+
+      trace::Span span("broadcast.publish.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->publisherParked.store(true, std::memory_order_relaxed);
+      heavyFence();
+      this->notFull.wait(guard, [&]() { return this->slowest() >= floor; });
+      this->publisherParked.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  // writes sequence `seq`, which reserve() has made room for
+  template <typename... Args> void put(uint64_t seq, Args&&... args) {
+    Slot& slot = this->slots[seq & this->mask];
+    if (seq > this->mask) {
+      *slot.get() = T(std::forward<Args>(args)...);
+    } else {
+      new (slot.bytes) T(std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename... Args> void emplace(Args&&... args) {
+    uint64_t seq = this->published.load(std::memory_order_relaxed);
+    this->reserve(seq + 1);
+    this->put(seq, std::forward<Args>(args)...);
+    this->published.store(seq + 1, std::memory_order_release);
+    this->wakeSubscribers();
+  }
+
+  // claims room for up to a ring of messages at a time, then publishes them
+  // with one store and one wakeup
+  template <std::forward_iterator It> void publishMany(It first, It last) {
+    trace::Span span("broadcast.publishMany");
+    uint64_t seq = this->published.load(std::memory_order_relaxed);
+    for (auto left = static_cast<uint64_t>(std::distance(first, last)); left > 0;) {
+      uint64_t n = std::min(left, this->capacity());
+      this->reserve(seq + n);
+      uint64_t i = 0;
+      try {
+        for (; i < n; i++, ++first) {
+          this->put(seq + i, *first);
+        }
+      } catch (...) {
+        // what was written before the throw is published
+        this->published.store(seq + i, std::memory_order_release);
+        this->wakeSubscribers();
+        throw;
+      }
+      seq += n;
+      left -= n;
+      this->published.store(seq, std::memory_order_release);
+      this->wakeSubscribers();
+    }
+  }
+
+  Cursor* subscribe() {
+    std::lock_guard<std::mutex> guard(this->subscribersLock);
+    auto free = std::find_if(this->cursors.begin(), this->cursors.end(),
+                             [](const std::unique_ptr<Cursor>& cursor) { return !cursor->active; });
+    if (free == this->cursors.end()) {
+      free = this->cursors.insert(free, std::make_unique<Cursor>());
+    }
+    Cursor& cursor = **free;
+    cursor.read = this->published.load(std::memory_order_acquire);
+    cursor.dropped = 0;
+    cursor.next.store(cursor.read, std::memory_order_relaxed);
+    cursor.active = true;
+    return free->get();
+  }
+
+  void unsubscribe(Cursor* cursor) {
+    {
+      std::lock_guard<std::mutex> guard(this->subscribersLock);
+      cursor->active = false;
+    }
+    // the publisher may be waiting on this one
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->notFull.notify_one();
+  }
+
+  // subscriber side. hands up to `maxN` messages from `cursor` to `f`,
+  // returning how many
+  template <typename F> size_t consume(Cursor& cursor, size_t maxN, F&& f) {
+    uint64_t next = cursor.next.load(std::memory_order_acquire);
+    uint64_t end;
+    while (true) {
+      uint64_t available = this->published.load(std::memory_order_acquire) - next;
+      end = next + std::min<uint64_t>(available, maxN);
+      if (next == end) {
+        break;
+      }
+      // a failed CAS means the publisher just moved the cursor, try there
+      if constexpr (overflow == Overflow::Block) {
+        break;
+      } else if (cursor.next.compare_exchange_strong(next, next | busy, std::memory_order_acquire)) {
+        break;
+      }
+    }
+    cursor.dropped += next - cursor.read;
+    cursor.read = next;
+    if (next == end) {
+      return 0;
+    }
+
+    // the cursor moves on to whatever was read, even if `f` throws
+    struct Advance {
+      Broadcast* broadcast;
+      Cursor& cursor;
+      uint64_t at;
+
+      ~Advance() {
+        this->cursor.read = this->at;
+        this->cursor.next.store(this->at, std::memory_order_release);
+        if constexpr (overflow == Overflow::Block) {
+          this->broadcast->wakePublisher();
+        }
+      }
+    } advance{this, cursor, next};
+
+    for (; advance.at < end; advance.at++) {
+      f(*static_cast<const T*>(this->slots[advance.at & this->mask].get()));
+    }
+    return end - next;
+  }
+
+  // waits for a message at `cursor`, or until the deadline, shutdown or close
+  std::expected<void, ChannelError> wait(Cursor& cursor, const WaitStrategy& strategy,
+                                         detail::Deadline deadline) {
+    auto ready = [&]() {
+      return this->published.load(std::memory_order_acquire) >
+             (cursor.next.load(std::memory_order_relaxed) & ~busy);
+    };
+    for (uint32_t round = 0; !ready(); round++) {
+      if (this->isClosed.load(std::memory_order_acquire)) {
+        // the last publish is visible once the close is
+        return ready() ? std::expected<void, ChannelError>() : std::unexpected(ChannelError::Shutdown);
+      }
+      if (strategy.pause(round, deadline)) {
+        continue;
+      }
+
+      trace::Span span("broadcast.recv.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->subscribersParked.fetch_add(1, std::memory_order_relaxed);
+      heavyFence();
+      bool woken = detail::waitUntil(this->notEmpty, guard, deadline, [&]() {
+        return ready() || this->isClosed.load(std::memory_order_acquire);
+      });
+      this->subscribersParked.fetch_sub(1, std::memory_order_relaxed);
+      if (!woken) {
+        return std::unexpected(ChannelError::Timeout);
+      }
+    }
+    return {};
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->isClosed.store(true, std::memory_order_release);
+    this->notEmpty.notify_all();
+  }
+
+  template <typename U, Overflow O> friend class Publisher;
+  template <typename U, Overflow O> friend class Subscriber;
+
+public:
+  /// `capacity` is rounded up to a power of two
+  explicit Broadcast(size_t capacity)
+      : slots(new Slot[std::bit_ceil(std::max<size_t>(capacity, 2))]),
+        mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1) {
+    prepareFences();
+  }
+
+  ~Broadcast() {
+    uint64_t end = this->published.load(std::memory_order_acquire);
+    for (uint64_t seq = end - std::min(end, this->capacity()); seq < end; seq++) {
+      this->slots[seq & this->mask].get()->~T();
+    }
+  }
+
+  Broadcast(const Broadcast&) = delete;
+  Broadcast& operator=(const Broadcast&) = delete;
+
+  uint64_t capacity() const { return this->mask + 1; }
+};
+
+template <typename T, Overflow overflow = Overflow::Block> class Subscriber;
+
+/// The one writing end of a broadcast. Not copyable, and like any single
+/// writer, only used from one thread at a time.
+template <typename T, Overflow overflow = Overflow::Block> class Publisher {
+public:
+  using Ring = Broadcast<T, overflow>;
+
+  Publisher() {}
+  /// Adopts the sender handle `s` was made with
+  explicit Publisher(detail::Shared<Ring>* s) : shared(s) {}
+
+  Publisher(Publisher&& other) noexcept : shared(std::exchange(other.shared, nullptr)) {}
+
+  Publisher& operator=(Publisher other) noexcept {
+    std::swap(this->shared, other.shared);
+    return *this;
+  }
+
+  ~Publisher() {
+    if (this->shared != nullptr) {
+      this->shared->chan.close();
+      this->shared->release();
+    }
+  }
+
+  void publish(T val) { return this->shared->chan.emplace(std::move(val)); }
+
+  /// Constructs the message in place from `args`
+  template <typename... Args> void emplace(Args&&... args) {
+    return this->shared->chan.emplace(std::forward<Args>(args)...);
+  }
+
+  /// Publishes every message, in order, claiming room for as many at once as
+  /// the ring holds and waking subscribers once per claim
+  template <std::forward_iterator It> void publishMany(It first, It last) {
+    return this->shared->chan.publishMany(first, last);
+  }
+
+  void publishMany(std::span<const T> vals) { return this->publishMany(vals.begin(), vals.end()); }
+
+  /// A new subscriber, which sees messages from the next one published on
+  Subscriber<T, overflow> subscribe() {
+    this->shared->acquire();
+    return Subscriber<T, overflow>(this->shared);
+  }
+
+  uint64_t capacity() const { return this->shared->chan.capacity(); }
+
+private:
+  detail::Shared<Ring>* shared = nullptr;
+};
+
+/// A reading end of a broadcast, with its own cursor. Not copyable: a second
+/// reader subscribes instead.
+template <typename T, Overflow overflow> class Subscriber {
+public:
+  using Ring = Broadcast<T, overflow>;
+  using value_type = T;
+
+  Subscriber() {}
+  /// Adopts a receiver handle of `s`, reading from the next message on
+  explicit Subscriber(detail::Shared<Ring>* s) : shared(s), cursor(s->chan.subscribe()) {}
+
+  Subscriber(Subscriber&& other) noexcept
+      : shared(std::exchange(other.shared, nullptr)), cursor(std::exchange(other.cursor, nullptr)),
+        wait(other.wait) {}
+
+  Subscriber& operator=(Subscriber other) noexcept {
+    std::swap(this->shared, other.shared);
+    std::swap(this->cursor, other.cursor);
+    this->wait = other.wait;
+    return *this;
+  }
+
+  ~Subscriber() {
+    if (this->shared != nullptr) {
+      this->shared->chan.unsubscribe(this->cursor);
+      this->shared->release();
+    }
+  }
+
+  /// A copy of the next message, if one is waiting
+  std::expected<std::optional<T>, ChannelError> tryRecv() {
+    std::optional<T> val;
+    std::expected<size_t, ChannelError> n = this->poll([&](const T& msg) { val.emplace(msg); }, 1);
+    if (!n) {
+      return std::unexpected(n.error());
+    }
+    return val;
+  }
+
+  std::expected<T, ChannelError> recv() { return this->recvUntilDeadline(detail::noDeadline); }
+
+  /// As recv(), but fails with Timeout if nothing arrives within `timeout`
+  template <typename Rep, typename Period>
+  std::expected<T, ChannelError> recvFor(std::chrono::duration<Rep, Period> timeout) {
+    return this->recvUntilDeadline(std::chrono::steady_clock::now() + timeout);
+  }
+
+  /// Hands up to `maxN` waiting messages to `f` as `const T&`, in order and
+  /// without copying them, and returns how many. Doesn't wait. Fails with
+  /// Shutdown once the publisher is gone and everything has been read.
+  ///
+  /// With DropOldest the publisher can't overwrite the slots being read
+  /// until `f` returns, so keep it short there.
+  template <typename F> std::expected<size_t, ChannelError> poll(F&& f, size_t maxN = SIZE_MAX) {
+    Ring& ring = this->shared->chan;
+    size_t n = ring.consume(*this->cursor, maxN, f);
+    if (n == 0 && ring.isClosed.load(std::memory_order_acquire)) {
+      // the last publish is visible once the close is
+      n = ring.consume(*this->cursor, maxN, f);
+      if (n == 0) {
+        return std::unexpected(ChannelError::Shutdown);
+      }
+    }
+    return n;
+  }
+
+  /// How many messages the publisher overwrote before this subscriber read
+  /// them. Always 0 with Block.
+  uint64_t dropped() const { return this->cursor->dropped; }
+
+  /// How this subscriber waits in recv() and recvFor(), see WaitStrategy
+  void setWaitStrategy(WaitStrategy strategy) { this->wait = strategy; }
+
+private:
+  detail::Shared<Ring>* shared = nullptr;
+  typename Ring::Cursor* cursor = nullptr;
+  WaitStrategy wait = Ring::defaultWait;
+
+  std::expected<T, ChannelError> recvUntilDeadline(detail::Deadline deadline) {
+    while (true) {
+      if (std::expected<void, ChannelError> ready =
+              this->shared->chan.wait(*this->cursor, this->wait, deadline);
+          !ready) {
+        return std::unexpected(ready.error());
+      }
+      std::optional<T> val;
+      this->shared->chan.consume(*this->cursor, 1, [&](const T& msg) { val.emplace(msg); });
+      if (val) {
+        return std::move(*val);
+      }
+    }
+  }
+};
+
+/// A broadcast ring of `capacity` (rounded up to a power of two) messages,
+/// its publisher and a first subscriber. More subscribe from the publisher.
+template <typename T, Overflow overflow = Overflow::Block>
+std::pair<Publisher<T, overflow>, Subscriber<T, overflow>> mkBroadcast(size_t capacity) {
+  auto* shared = detail::Shared<Broadcast<T, overflow>>::make(capacity);
+  return std::pair(Publisher<T, overflow>(shared), Subscriber<T, overflow>(shared));
+}
+
+}; // namespace channel
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_BROADCAST_H
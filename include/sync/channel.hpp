@@ -1,12 +1,28 @@
 #ifndef OASIS_SYNC_CHANNEL_H
 #define OASIS_SYNC_CHANNEL_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <expected>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include "ready.hpp"
 
 namespace oasis {
 namespace sync {
@@ -14,89 +30,588 @@ namespace channel {
 
 enum class ChannelError {
   Shutdown,
+  /// a timed receive reached its deadline with nothing to receive
+  Timeout,
+};
+
+/// How a receiver waits for a message: it polls `spins` times with a CPU
+/// pause between, then `yields` more times giving up its timeslice between,
+/// and only then parks until a sender wakes it.
+///
+/// Parking costs a futex wake on the sending side and several microseconds
+/// before the receiver runs again, so a stage on the hot path that can spare
+/// a core spins a while first, e.g. `{.spins = 1 << 12, .yields = 16}`. A
+/// receiver that is mostly idle should park straight away, with `{}`.
+struct WaitStrategy {
+  uint32_t spins = 0;
+  uint32_t yields = 0;
+
+  // backs off for the `round`th time, or returns false once it's time to
+  // park. yielding stops at `deadline`, spinning is short enough not to check
+  bool pause(uint32_t round, std::chrono::steady_clock::time_point deadline) const {
+    if (round < spins) {
+      cpuRelax();
+      return true;
+    }
+    if (round - spins < yields && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+      return true;
+    }
+    return false;
+  }
+};
+
+namespace detail {
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+inline constexpr Deadline noDeadline = Deadline::max();
+
+// waits on `cond` until `pred` holds, giving up at `deadline`. returns pred()
+template <typename Pred>
+bool waitUntil(std::condition_variable &cond, std::unique_lock<std::mutex> &guard, Deadline deadline,
+               Pred pred) {
+  if (deadline == noDeadline) {
+    cond.wait(guard, pred);
+    return true;
+  }
+  return cond.wait_until(guard, deadline, pred);
+}
+
+// a thread blocked in a Selector. it's registered with every channel it
+// waits on, which signal it along with their own waiters
+struct Waiter {
+  std::mutex lock;
+  std::condition_variable cond;
+  bool signalled = false;
+
+  void signal() {
+    std::lock_guard<std::mutex> guard(lock);
+    signalled = true;
+    cond.notify_one();
+  }
 };
 
+// called with the channel's lock held, which also guards the list
+inline void signalAll(const std::vector<Waiter *> &waiters) {
+  for (Waiter *waiter : waiters) {
+    waiter->signal();
+  }
+}
+
+}; // namespace detail
+
+class Selector;
+
 template <typename T> class Channel {
 private:
   std::deque<T> queue;
   std::mutex lock;
   std::condition_variable cond;
   bool is_shutdown = false;
+  bool is_closed = false;
+  // the size of the queue, written under the lock, for spinning receivers to
+  // poll without taking it
+  std::atomic<size_t> pending = 0;
+  std::vector<detail::Waiter *> waiters;
+  // made by readyFd(), signalled when a message arrives, cleared when a
+  // receive finds the queue empty. all under the lock.
+  std::unique_ptr<ReadyFd> ready;
+
+  static constexpr WaitStrategy defaultWait = {};
+
+  void signalReady() {
+    if (ready != nullptr) {
+      ready->signal();
+    }
+  }
+
+  // once closed (every sender dropped) receivers still drain what's queued,
+  // and only then see Shutdown
+  bool exhausted() const { return is_shutdown || (is_closed && queue.empty()); }
 
   std::expected<std::optional<T>, ChannelError> tryRecv() {
     std::unique_lock<std::mutex> guard(lock);
 
-    if (is_shutdown) {
+    if (exhausted()) {
       return std::unexpected(ChannelError::Shutdown);
     }
 
     if (queue.empty()) {
+      if (ready != nullptr) {
+        ready->clear();
+      }
       return {};
     } else {
-      T val = queue.front();
+      T val = std::move(queue.front());
       queue.pop_front();
+      pending.store(queue.size(), std::memory_order_relaxed);
       return val;
     }
   }
 
-  std::expected<T, ChannelError> recv() {
+  std::expected<T, ChannelError> recv(const WaitStrategy &wait, detail::Deadline deadline) {
+    trace::Span span("channel.recv");
+    for (uint32_t round = 0; pending.load(std::memory_order_relaxed) == 0; round++) {
+      if (!wait.pause(round, deadline)) {
+        break;
+      }
+    }
+
     std::unique_lock<std::mutex> guard(lock);
-    cond.wait(guard, [this]() { return !queue.empty() || is_shutdown; });
+    if (!detail::waitUntil(cond, guard, deadline,
+                           [this]() { return !queue.empty() || is_shutdown || is_closed; })) {
+      return std::unexpected(ChannelError::Timeout);
+    }
 
-    if (is_shutdown) {
+    if (exhausted()) {
       return std::unexpected(ChannelError::Shutdown);
     }
 
-    T val = queue.front();
+    T val = std::move(queue.front());
     queue.pop_front();
+    pending.store(queue.size(), std::memory_order_relaxed);
     return val;
   }
 
-  void send(T val) {
+  // after a shutdown nobody will receive it, so a message is dropped rather
+  // than queued, as on the bounded channels
+  template <typename... Args> void emplace(Args &&...args) {
+    trace::Span span("channel.send");
     std::lock_guard<std::mutex> guard(lock);
-    queue.push_back(std::move(val));
+    if (is_shutdown) {
+      return;
+    }
+    queue.emplace_back(std::forward<Args>(args)...);
+    pending.store(queue.size(), std::memory_order_relaxed);
     cond.notify_one();
+    detail::signalAll(waiters);
+    signalReady();
+  }
+
+  // blocks like recv() for the first message, then takes as many as are
+  // queued, up to maxN, under the same lock
+  template <typename OutIt>
+  std::expected<size_t, ChannelError> recvMany(OutIt out, size_t maxN) {
+    trace::Span span("channel.recvMany");
+    std::unique_lock<std::mutex> guard(lock);
+    cond.wait(guard, [this]() { return !queue.empty() || is_shutdown || is_closed; });
+
+    if (exhausted()) {
+      return std::unexpected(ChannelError::Shutdown);
+    }
+
+    size_t n = std::min(maxN, queue.size());
+    auto end = queue.begin() + n;
+    for (auto it = queue.begin(); it != end; ++it) {
+      *out++ = std::move(*it);
+    }
+    queue.erase(queue.begin(), end);
+    pending.store(queue.size(), std::memory_order_relaxed);
+    span.setArg(n);
+    return n;
+  }
+
+  template <typename Container>
+  std::expected<size_t, ChannelError> drainInto(Container &out) {
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (exhausted()) {
+      return std::unexpected(ChannelError::Shutdown);
+    }
+
+    size_t n = queue.size();
+    for (T &val : queue) {
+      out.push_back(std::move(val));
+    }
+    queue.clear();
+    pending.store(0, std::memory_order_relaxed);
+    if (ready != nullptr) {
+      ready->clear();
+    }
+    return n;
+  }
+
+  template <typename It> void sendMany(It first, It last) {
+    trace::Span span("channel.sendMany");
+    std::lock_guard<std::mutex> guard(lock);
+    if (is_shutdown) {
+      return;
+    }
+    size_t before = queue.size();
+    queue.insert(queue.end(), first, last);
+    size_t n = queue.size() - before;
+    pending.store(queue.size(), std::memory_order_relaxed);
+    span.setArg(n);
+
+    // a single waiter can take a single message, any more and every waiter
+    // may have something to do
+    if (n == 1) {
+      cond.notify_one();
+    } else if (n > 1) {
+      cond.notify_all();
+    }
+    if (n > 0) {
+      detail::signalAll(waiters);
+      signalReady();
+    }
   }
 
   void shutdown() {
     std::lock_guard<std::mutex> guard(lock);
     is_shutdown = true;
     cond.notify_all();
+    detail::signalAll(waiters);
+    signalReady();
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> guard(lock);
+    is_closed = true;
+    cond.notify_all();
+    detail::signalAll(waiters);
+    signalReady();
+  }
+
+  int readyFd() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (ready == nullptr) {
+      ready = std::make_unique<ReadyFd>();
+      if (!queue.empty() || is_shutdown || is_closed) {
+        ready->signal();
+      }
+    }
+    return ready->fd();
+  }
+
+  void addWaiter(detail::Waiter *waiter) {
+    std::lock_guard<std::mutex> guard(lock);
+    waiters.push_back(waiter);
+  }
+
+  void removeWaiter(detail::Waiter *waiter) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::erase(waiters, waiter);
   }
 
-  template <typename U> friend class Receiver;
-  template <typename U> friend class Sender;
+  template <typename U, typename C> friend class Receiver;
+  template <typename U, typename C> friend class Sender;
+
+public:
+  /// Has recvMany(), drainInto() and sendMany(), one lock per batch
+  static constexpr bool batched = true;
 };
 
-template <typename T> class Receiver {
+namespace detail {
+
+// a per-thread free list of fixed size blocks, so that channels created and
+// dropped at a high rate recycle their control blocks instead of going to
+// the global allocator each time. a block goes back to the list of the
+// thread that drops the last handle, which is fine as long as threads both
+// create and drop channels, and each list is capped so a thread that only
+// drops them doesn't hoard memory.
+template <size_t Size, size_t Align, uint32_t maxCached = 64> class BlockPool {
+private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  // trivially destructible so it stays usable while other thread locals are
+  // torn down, after Drain has run
+  struct Cache {
+    FreeBlock *head = nullptr;
+    uint32_t count = 0;
+    bool exited = false;
+  };
+
+  struct Drain {
+    ~Drain() {
+      while (cache.head != nullptr) {
+        ::operator delete(std::exchange(cache.head, cache.head->next), std::align_val_t(Align));
+      }
+      cache.count = 0;
+      cache.exited = true;
+    }
+  };
+
+  static inline thread_local Cache cache;
+
+public:
+  static void *take() {
+    if (void *block = tryTake()) {
+      return block;
+    }
+    return ::operator new(Size, std::align_val_t(Align));
+  }
+
+  // a cached block, or null rather than allocating one
+  static void *tryTake() {
+    if (cache.head == nullptr) {
+      return nullptr;
+    }
+    cache.count--;
+    return std::exchange(cache.head, cache.head->next);
+  }
+
+  // how many blocks this thread has cached
+  static uint32_t cached() { return cache.count; }
+
+  static void give(void *block) {
+    thread_local Drain drain;
+    if (cache.count == maxCached || cache.exited) {
+      ::operator delete(block, std::align_val_t(Align));
+      return;
+    }
+    cache.head = new (block) FreeBlock{cache.head};
+    cache.count++;
+  }
+};
+
+// a channel together with the counts of the handles sharing it. it closes
+// when the last Sender goes, shuts down when the last Receiver does, and is
+// destroyed when the last handle does.
+template <typename C> struct Shared {
+  C chan;
+  std::atomic<uint32_t> senders = 1;
+  std::atomic<uint32_t> receivers = 1;
+  std::atomic<uint32_t> handles = 2;
+
+  template <typename... Args> explicit Shared(Args &&...args) : chan(std::forward<Args>(args)...) {}
+
+  /// A new channel, owned by one Sender and one Receiver
+  template <typename... Args> static Shared *make(Args &&...args) {
+    using Pool = BlockPool<sizeof(Shared), alignof(Shared)>;
+    void *block = Pool::take();
+    try {
+      return new (block) Shared(std::forward<Args>(args)...);
+    } catch (...) {
+      Pool::give(block);
+      throw;
+    }
+  }
+
+  void acquire() { handles.fetch_add(1, std::memory_order_relaxed); }
+
+  void release() {
+    if (handles.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      using Pool = BlockPool<sizeof(Shared), alignof(Shared)>;
+      this->~Shared();
+      Pool::give(this);
+    }
+  }
+};
+
+// a channel for one sending and one receiving thread, whose handles are
+// move-only so there can't be a second of either
+template <typename C> concept SingleEnded = C::singleEnded;
+
+// senders look for parked receivers without taking the channel's lock
+template <typename C> concept LockFree = C::lockFree;
+
+// channels with the batch operations, recvMany(), drainInto() and sendMany()
+template <typename C> concept Batched = C::batched;
+
+// channels with a fixed capacity, and so a trySend()
+template <typename C> concept Bounded = C::bounded;
+
+}; // namespace detail
+
+/// The receiving end of a channel. `C` picks the channel implementation.
+/// Every one can recv(), tryRecv(), time out, select and give a readyFd();
+/// the batch receives, recvMany() and drainInto(), are Channel only.
+///
+/// Handles share the channel: it lives until the last Sender and Receiver
+/// are gone, taking any messages still queued with it. Copies are cheap and
+/// can be handed to other threads, except for SPSC channels, whose handles
+/// can only be moved. Once every Receiver is gone the channel shuts down,
+/// so senders blocked on a full channel give up and later sends are dropped.
+template <typename T, typename C = Channel<T>> class Receiver {
 public:
+  using value_type = T;
+
   Receiver() {}
-  Receiver(Channel<T> *c) : chan(c) {}
+  /// Adopts one of the receiver handles `s` was made with
+  explicit Receiver(detail::Shared<C> *s) : shared(s) {}
+
+  Receiver(const Receiver &other)
+    requires(!detail::SingleEnded<C>)
+      : shared(other.shared), wait(other.wait) {
+    if (shared != nullptr) {
+      shared->receivers.fetch_add(1, std::memory_order_relaxed);
+      shared->acquire();
+    }
+  }
 
-  std::expected<std::optional<T>, ChannelError> tryRecv() { return chan->tryRecv(); }
+  Receiver(const Receiver &other)
+    requires detail::SingleEnded<C>
+  = delete;
 
-  std::expected<T, ChannelError> recv() { return chan->recv(); }
+  Receiver(Receiver &&other) noexcept
+      : shared(std::exchange(other.shared, nullptr)), wait(other.wait) {}
+
+  Receiver &operator=(Receiver other) noexcept {
+    std::swap(shared, other.shared);
+    wait = other.wait;
+    return *this;
+  }
+
+  ~Receiver() {
+    if (shared != nullptr) {
+      if (shared->receivers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        shared->chan.shutdown();
+      }
+      shared->release();
+    }
+  }
+
+  std::expected<std::optional<T>, ChannelError> tryRecv() { return shared->chan.tryRecv(); }
+
+  std::expected<T, ChannelError> recv() { return shared->chan.recv(wait, detail::noDeadline); }
+
+  /// As recv(), but fails with Timeout if nothing arrives within `timeout`
+  template <typename Rep, typename Period>
+  std::expected<T, ChannelError> recvFor(std::chrono::duration<Rep, Period> timeout) {
+    return shared->chan.recv(wait, std::chrono::steady_clock::now() + timeout);
+  }
+
+  /// As recv(), but fails with Timeout if nothing arrives by `deadline`
+  template <typename Clock, typename Duration>
+  std::expected<T, ChannelError> recvUntil(std::chrono::time_point<Clock, Duration> deadline) {
+    if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>) {
+      return shared->chan.recv(wait, std::chrono::time_point_cast<detail::Deadline::duration>(deadline));
+    } else {
+      return recvFor(deadline - Clock::now());
+    }
+  }
+
+  /// A file descriptor that polls readable when there's something to
+  /// receive, so an event loop can wait on the channel alongside its
+  /// sockets. Made on the first call and owned by the channel.
+  ///
+  /// It's signalled once when a message arrives at an empty channel (or the
+  /// channel shuts down) and stays readable until a tryRecv() finds the
+  /// channel empty, or a drainInto() empties it. So on readiness, receive
+  /// with those until there's nothing left, and a burst of sends costs the
+  /// senders one write(2) between them.
+  int readyFd() { return shared->chan.readyFd(); }
+
+  /// How this receiver waits in recv(), recvFor() and recvUntil(). Each
+  /// receiver has its own, starting from the channel's default.
+  void setWaitStrategy(WaitStrategy strategy) { wait = strategy; }
+
+  WaitStrategy waitStrategy() const { return wait; }
+
+  /// Waits for at least one message, then writes as many as are queued, up to
+  /// `maxN`, to `out`, all under one lock. Returns how many were written.
+  template <typename OutIt>
+  std::expected<size_t, ChannelError> recvMany(OutIt out, size_t maxN)
+    requires detail::Batched<C>
+  {
+    return shared->chan.recvMany(out, maxN);
+  }
+
+  /// Appends every queued message to `out` under one lock, without waiting.
+  /// Returns how many were appended.
+  template <typename Container>
+  std::expected<size_t, ChannelError> drainInto(Container &out)
+    requires detail::Batched<C>
+  {
+    return shared->chan.drainInto(out);
+  }
 
 private:
-  Channel<T> *chan;
+  detail::Shared<C> *shared = nullptr;
+  WaitStrategy wait = C::defaultWait;
+
+  // whether a Selector needs the heavy fence after registering with us
+  static constexpr bool lockFree = detail::LockFree<C>;
+
+  void addWaiter(detail::Waiter *waiter) { shared->chan.addWaiter(waiter); }
+
+  void removeWaiter(detail::Waiter *waiter) { shared->chan.removeWaiter(waiter); }
+
+  friend class Selector;
 };
 
-template <typename T> class Sender {
+/// The sending end of a channel, see Receiver. Once every Sender of a channel
+/// is gone the channel closes: receivers get the messages still queued, then
+/// Shutdown. sendMany() is Channel only, and trySend() is for the bounded
+/// SPSC and MPMC channels only.
+template <typename T, typename C = Channel<T>> class Sender {
 public:
   Sender() {}
-  Sender(Channel<T> *c) : chan(c) {}
+  /// Adopts one of the sender handles `s` was made with
+  explicit Sender(detail::Shared<C> *s) : shared(s) {}
+
+  Sender(const Sender &other)
+    requires(!detail::SingleEnded<C>)
+      : shared(other.shared) {
+    if (shared != nullptr) {
+      shared->senders.fetch_add(1, std::memory_order_relaxed);
+      shared->acquire();
+    }
+  }
+
+  Sender(const Sender &other)
+    requires detail::SingleEnded<C>
+  = delete;
 
-  void send(T val) { return chan->send(val); }
+  Sender(Sender &&other) noexcept : shared(std::exchange(other.shared, nullptr)) {}
+
+  Sender &operator=(Sender other) noexcept {
+    std::swap(shared, other.shared);
+    return *this;
+  }
+
+  ~Sender() {
+    if (shared != nullptr) {
+      if (shared->senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        shared->chan.close();
+      }
+      shared->release();
+    }
+  }
+
+  void send(T val) { return shared->chan.emplace(std::move(val)); }
+
+  /// Constructs the message in place from `args`
+  template <typename... Args> void emplace(Args &&...args) {
+    return shared->chan.emplace(std::forward<Args>(args)...);
+  }
+
+  /// Sends every message, in order, under one lock and with one wakeup. The
+  /// messages are moved out of `vals`.
+  void sendMany(std::span<T> vals)
+    requires detail::Batched<C>
+  {
+    return shared->chan.sendMany(std::make_move_iterator(vals.begin()),
+                          std::make_move_iterator(vals.end()));
+  }
+
+  template <std::input_iterator It>
+  void sendMany(It first, It last)
+    requires detail::Batched<C>
+  {
+    return shared->chan.sendMany(first, last);
+  }
+
+  /// Bounded channels only. Sends `val`, moving from it, unless the channel
+  /// is full or shut down.
+  bool trySend(T &val)
+    requires detail::Bounded<C>
+  {
+    return shared->chan.trySend(val);
+  }
 
-  void shutdown() { return chan->shutdown(); }
+  void shutdown() { return shared->chan.shutdown(); }
 
 private:
-  Channel<T> *chan;
+  detail::Shared<C> *shared = nullptr;
 };
 
 template <typename T> std::pair<Sender<T>, Receiver<T>> mkChannel() {
-  Channel<T> *chan = new Channel<T>();
-  return std::pair(Sender<T>(chan), Receiver<T>(chan));
+  detail::Shared<Channel<T>> *shared = detail::Shared<Channel<T>>::make();
+  return std::pair(Sender<T>(shared), Receiver<T>(shared));
 }
 
 }; // namespace channel
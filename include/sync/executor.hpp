@@ -0,0 +1,602 @@
+#ifndef OASIS_SYNC_EXECUTOR_H
+#define OASIS_SYNC_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include "channel.hpp"
+#include "fence.hpp"
+
+namespace oasis {
+namespace sync {
+
+namespace detail {
+
+// a type erased task. the callable lives inline in the node when it fits,
+// otherwise on the heap with the node holding the pointer, so the common
+// small closure costs one pooled block and no allocation. a node is one
+// cache line, recycled through a per-thread BlockPool. nodes spawned from
+// outside the pool are freed into the workers' pools instead, so the
+// Executor hands blocks back to those spawners through its spare list.
+struct alignas(cacheLineSize) TaskNode {
+  static constexpr size_t inlineSize = cacheLineSize - sizeof(void*);
+
+  unsigned char bytes[inlineSize];
+  // runs the callable, then destroys it
+  void (*invoke)(TaskNode*) noexcept;
+
+  template <typename F> static constexpr bool fitsInline = sizeof(F) <= inlineSize && alignof(F) <= cacheLineSize;
+
+  // TaskNode is incomplete in here, hence the spelled out size
+  using Pool = channel::detail::BlockPool<cacheLineSize, cacheLineSize, 1024>;
+
+  template <typename F> static TaskNode* make(F&& f) {
+    using Fn = std::decay_t<F>;
+    void* block = Pool::take();
+    TaskNode* node = new (block) TaskNode;
+    try {
+      if constexpr (fitsInline<Fn>) {
+        new (node->bytes) Fn(std::forward<F>(f));
+        node->invoke = [](TaskNode* self) noexcept {
+          Fn* fn = std::launder(reinterpret_cast<Fn*>(self->bytes));
+          (*fn)();
+          fn->~Fn();
+        };
+      } else {
+        new (node->bytes) Fn*(new Fn(std::forward<F>(f)));
+        node->invoke = [](TaskNode* self) noexcept {
+          std::unique_ptr<Fn> fn(*std::launder(reinterpret_cast<Fn**>(self->bytes)));
+          (*fn)();
+        };
+      }
+    } catch (...) {
+      Pool::give(block);
+      throw;
+    }
+    return node;
+  }
+
+  // runs the task and recycles its node
+  static void run(TaskNode* node) {
+    node->invoke(node);
+    Pool::give(node);
+  }
+};
+
+static_assert(sizeof(TaskNode) == cacheLineSize && alignof(TaskNode) == cacheLineSize);
+
+// a Chase-Lev work-stealing deque, with the orderings of Lê et al., "Correct
+// and Efficient Work-Stealing for Weak Memory Models". the owning worker
+// pushes and takes at the bottom without a lock or (in the common case) an
+// atomic read-modify-write, thieves steal from the top with a CAS, and the
+// two only race for the last task.
+//
+// the ring grows by doubling when full. a thief may still be reading the old
+// ring, so retired rings are kept until the deque goes; they add up to less
+// than the current one.
+class WorkStealingDeque {
+private:
+  struct Ring {
+    int64_t mask;
+    std::unique_ptr<std::atomic<TaskNode*>[]> slots;
+
+    explicit Ring(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<TaskNode*>[capacity]) {}
+
+    TaskNode* get(int64_t i) const { return this->slots[i & this->mask].load(std::memory_order_relaxed); }
+
+    void put(int64_t i, TaskNode* task) { this->slots[i & this->mask].store(task, std::memory_order_relaxed); }
+  };
+
+  static constexpr int64_t initialCapacity = 256;
+
+  alignas(cacheLineSize) std::atomic<int64_t> top = 0;
+  alignas(cacheLineSize) std::atomic<int64_t> bottom = 0;
+  std::atomic<Ring*> ring;
+  // owner only: the current ring and every one it replaced
+  std::vector<std::unique_ptr<Ring>> rings;
+
+  Ring* grow(Ring* old, int64_t t, int64_t b) {
+    auto bigger = std::make_unique<Ring>(2 * (old->mask + 1));
+    for (int64_t i = t; i < b; i++) {
+      bigger->put(i, old->get(i));
+    }
+    Ring* next = bigger.get();
+    this->rings.push_back(std::move(bigger));
+    this->ring.store(next, std::memory_order_release);
+    return next;
+  }
+
+public:
+  WorkStealingDeque() {
+    this->rings.push_back(std::make_unique<Ring>(initialCapacity));
+    this->ring.store(this->rings.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  /// Owner only
+  void push(TaskNode* task) {
+    int64_t b = this->bottom.load(std::memory_order_relaxed);
+    int64_t t = this->top.load(std::memory_order_acquire);
+    Ring* r = this->ring.load(std::memory_order_relaxed);
+    if (b - t > r->mask) {
+      r = this->grow(r, t, b);
+    }
+    r->put(b, task);
+    // publishes the task (and the node behind it) to thieves
+    this->bottom.store(b + 1, std::memory_order_release);
+  }
+
+  /// Owner only. The most recently pushed task, or null if there's none
+  TaskNode* take() {
+    int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+    Ring* r = this->ring.load(std::memory_order_relaxed);
+    this->bottom.store(b, std::memory_order_relaxed);
+    // orders the claim on the bottom before reading top, against the CAS
+    // of a thief that read the old bottom
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = this->top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      this->bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    TaskNode* task = r->get(b);
+    if (t == b) {
+      // the last one, race the thieves for it
+      if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        task = nullptr;
+      }
+      this->bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  /// Any thread. The oldest task, or null if there's none or another thread
+  /// got to it first
+  TaskNode* steal() {
+    int64_t t = this->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = this->bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    Ring* r = this->ring.load(std::memory_order_acquire);
+    TaskNode* task = r->get(t);
+    if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+  /// Any thread, racy: whether it looked empty
+  bool empty() const {
+    return this->top.load(std::memory_order_acquire) >= this->bottom.load(std::memory_order_acquire);
+  }
+};
+
+}; // namespace detail
+
+class TaskGroup;
+
+/// A fixed pool of worker threads running fire-and-forget tasks, with work
+/// stealing.
+///
+///   Executor exec;
+///   exec.spawn([&]() { handle(request); });
+///
+/// Every worker has its own Chase-Lev deque. A task spawned from a worker
+/// goes on the bottom of that worker's deque, and the worker runs its own
+/// tasks newest first, so a task that forks children runs them while their
+/// data is still in its cache. A worker out of tasks steals the oldest task
+/// from another worker, chosen at random, and those are the large subtrees
+/// in a fork-join computation, so steals are rare. Tasks spawned from
+/// outside the pool go on a shared injection queue that workers check
+/// before stealing.
+///
+/// Tasks are stored inline in a pooled node when the callable fits in
+/// TaskNode::inlineSize bytes (a lambda capturing up to seven pointers),
+/// and on the heap otherwise. Workers free the nodes of injected tasks into
+/// their own pools and hand as many blocks back to outside spawners through
+/// the Executor's spareNodes list, so those spawners reuse nodes too once
+/// the pool is warm. A task must not throw: an exception escaping one
+/// terminates the process, as it would on a std::thread.
+///
+/// A worker that finds nothing to do spins and yields a while, then parks.
+/// Parked workers are counted, so a spawn costs a light fence and a load
+/// unless one is parked, and then a lock and a notify to wake it. The
+/// handshake is the asymmetric fence pair of fence.hpp, the heavy half on
+/// the parking side.
+///
+/// The destructor waits until every worker is out of work, so it waits for
+/// every task, including ones spawned by tasks meanwhile, then joins the
+/// workers. Use TaskGroup to wait for a particular set of tasks.
+class Executor {
+private:
+  struct alignas(cacheLineSize) Worker {
+    detail::WorkStealingDeque deque;
+    Executor* owner;
+    size_t index;
+    // xorshift state for picking steal victims
+    uint64_t seed;
+  };
+
+  static constexpr channel::WaitStrategy idleWait = {.spins = 1 << 6, .yields = 1 << 4};
+  // most injected tasks a worker moves to its deque at once
+  static constexpr size_t injectBatch = 32;
+
+  static inline thread_local Worker* current = nullptr;
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+
+  // tasks spawned from outside the pool
+  alignas(cacheLineSize) std::atomic<size_t> injectedCount = 0;
+  std::mutex injectLock;
+  std::deque<detail::TaskNode*> injected;
+  // under `injectLock`: node blocks the workers have given back for outside
+  // spawners, one for every injected task they take
+  std::vector<void*> spareNodes;
+  static constexpr size_t maxSpareNodes = 1024;
+
+  alignas(cacheLineSize) std::atomic<uint32_t> sleepers = 0;
+  std::mutex lock;
+  std::condition_variable wake;
+  // the rest under `lock`. wakeups handed out and not yet taken by a parked
+  // worker
+  uint32_t permits = 0;
+  bool isStopping = false;
+  // stopping, and every worker found nothing to do
+  bool drained = false;
+
+  Worker* self() const {
+    Worker* w = current;
+    return w != nullptr && w->owner == this ? w : nullptr;
+  }
+
+  void submit(detail::TaskNode* task) {
+    if (Worker* w = this->self()) {
+      w->deque.push(task);
+    } else {
+      std::lock_guard<std::mutex> guard(this->injectLock);
+      this->injected.push_back(task);
+      this->injectedCount.store(this->injected.size(), std::memory_order_release);
+      // the node gets freed on whichever worker runs it, so top this
+      // thread's pool back up from the blocks the workers returned
+      while (!this->spareNodes.empty() && detail::TaskNode::Pool::cached() < injectBatch) {
+        detail::TaskNode::Pool::give(this->spareNodes.back());
+        this->spareNodes.pop_back();
+      }
+    }
+    this->wakeOne();
+  }
+
+  // wakes a parked worker, if there's one that isn't already being woken
+  void wakeOne() {
+    lightFence();
+    if (this->sleepers.load(std::memory_order_relaxed) == 0) [[likely]] {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      if (this->permits >= this->sleepers.load(std::memory_order_relaxed)) {
+        return;
+      }
+      this->permits++;
+    }
+    this->wake.notify_one();
+  }
+
+  // the oldest injected task. a worker takes a share of the rest along with
+  // it onto its own deque, so a burst from outside costs a lock per batch
+  // rather than per task, and the other workers can steal from the batch
+  detail::TaskNode* popInjected(Worker& w) {
+    if (this->injectedCount.load(std::memory_order_acquire) == 0) {
+      return nullptr;
+    }
+    detail::TaskNode* task;
+    size_t moved = 0;
+    {
+      std::lock_guard<std::mutex> guard(this->injectLock);
+      if (this->injected.empty()) {
+        return nullptr;
+      }
+      task = this->injected.front();
+      this->injected.pop_front();
+      moved = std::min(this->injected.size() / this->workers.size(), injectBatch);
+      // newest first, so the worker's own lifo takes them oldest first
+      for (size_t i = moved; i > 0; i--) {
+        w.deque.push(this->injected[i - 1]);
+      }
+      this->injected.erase(this->injected.begin(), this->injected.begin() + moved);
+      this->injectedCount.store(this->injected.size(), std::memory_order_release);
+      // running these frees their nodes into our pool, so pay for them with
+      // blocks already there
+      for (size_t i = 0; i <= moved && this->spareNodes.size() < maxSpareNodes; i++) {
+        void* block = detail::TaskNode::Pool::tryTake();
+        if (block == nullptr) {
+          break;
+        }
+        this->spareNodes.push_back(block);
+      }
+    }
+    if (moved > 0) {
+      this->wakeOne();
+    }
+    return task;
+  }
+
+  // one pass over the other workers, starting at a random one
+  detail::TaskNode* stealAny(Worker& thief) {
+    thief.seed ^= thief.seed << 13;
+    thief.seed ^= thief.seed >> 7;
+    thief.seed ^= thief.seed << 17;
+    size_t n = this->workers.size();
+    size_t start = thief.seed % n;
+
+    for (size_t k = 0; k < n; k++) {
+      Worker& victim = *this->workers[(start + k) % n];
+      if (&victim == &thief) {
+        continue;
+      }
+      if (detail::TaskNode* task = victim.deque.steal()) {
+        // there's more where that came from, get another worker on it
+        if (!victim.deque.empty()) {
+          this->wakeOne();
+        }
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  // a task for `w`: its own newest, then the oldest injected, then one
+  // stolen
+  detail::TaskNode* findTask(Worker& w) {
+    if (detail::TaskNode* task = w.deque.take()) {
+      return task;
+    }
+    if (detail::TaskNode* task = this->popInjected(w)) {
+      return task;
+    }
+    return this->stealAny(w);
+  }
+
+  bool hasWork() const {
+    if (this->injectedCount.load(std::memory_order_acquire) != 0) {
+      return true;
+    }
+    for (const auto& w : this->workers) {
+      if (!w->deque.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // runs a task, if the caller is one of our workers and finds one. lets a
+  // worker waiting on a TaskGroup help instead of blocking. a thread from
+  // outside doesn't help: what it could run are injected tasks, and those
+  // spawn their children back onto the injection queue, so it would keep
+  // picking up unrelated subtrees, each one deeper on its stack
+  bool runOne() {
+    Worker* w = this->self();
+    if (w == nullptr) {
+      return false;
+    }
+    if (detail::TaskNode* task = this->findTask(*w)) {
+      detail::TaskNode::run(task);
+      return true;
+    }
+    return false;
+  }
+
+  // blocks until woken, unless work shows up while registering as parked.
+  // returns false once the pool is stopping and every worker has run out of
+  // work, which is when they all exit
+  bool park() {
+    bool stopping;
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->sleepers.fetch_add(1, std::memory_order_relaxed);
+      stopping = this->isStopping;
+    }
+    // pairs with the light fence in wakeOne: either the spawner sees us
+    // counted, or we see its task
+    heavyFence();
+    bool idle = !this->hasWork();
+
+    std::unique_lock<std::mutex> guard(this->lock);
+    if (idle && stopping && this->sleepers.load(std::memory_order_relaxed) == this->workers.size()) {
+      this->drained = true;
+      this->wake.notify_all();
+    }
+    if (idle) {
+      trace::Span span("executor.park");
+      this->wake.wait(guard, [&]() { return this->permits > 0 || this->drained || this->isStopping != stopping; });
+    }
+    uint32_t left = this->sleepers.fetch_sub(1, std::memory_order_relaxed) - 1;
+    // a permit may have been meant for us even if we didn't wait for it
+    this->permits = std::min(this->permits > 0 ? this->permits - 1 : 0, left);
+    return !this->drained;
+  }
+
+  void workerLoop(Worker* w) {
+    current = w;
+    while (true) {
+      uint32_t round = 0;
+      detail::TaskNode* task;
+      while ((task = this->findTask(*w)) == nullptr && idleWait.pause(round++, channel::detail::noDeadline)) {
+      }
+      if (task != nullptr) {
+        detail::TaskNode::run(task);
+      } else if (!this->park()) {
+        break;
+      }
+    }
+    current = nullptr;
+  }
+
+public:
+  /// Starts `threads` workers, at least one
+  explicit Executor(size_t threads = std::thread::hardware_concurrency()) {
+    prepareFences();
+    this->spareNodes.reserve(maxSpareNodes);
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; i++) {
+      auto w = std::make_unique<Worker>();
+      w->owner = this;
+      w->index = i;
+      w->seed = 0x9e3779b97f4a7c15ull * (i + 1);
+      this->workers.push_back(std::move(w));
+    }
+    for (size_t i = 0; i < threads; i++) {
+      this->threads.emplace_back([this, w = this->workers[i].get()]() { this->workerLoop(w); });
+    }
+  }
+
+  ~Executor() {
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->isStopping = true;
+    }
+    this->wake.notify_all();
+    for (auto& t : this->threads) {
+      t.join();
+    }
+    for (void* block : this->spareNodes) {
+      detail::TaskNode::Pool::give(block);
+    }
+  }
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  /// Runs `f()` on the pool, from any thread, including from a task
+  template <typename F> void spawn(F&& f) {
+    static_assert(std::invocable<std::decay_t<F>&>, "a task is called with no arguments");
+    this->submit(detail::TaskNode::make(std::forward<F>(f)));
+  }
+
+  /// How many worker threads there are
+  size_t size() const { return this->workers.size(); }
+
+  /// Which worker the calling thread is, or -1 if it's not one of ours
+  ptrdiff_t workerIndex() const {
+    Worker* w = this->self();
+    return w != nullptr ? static_cast<ptrdiff_t>(w->index) : -1;
+  }
+
+  friend class TaskGroup;
+};
+
+/// A set of tasks to wait for, for fork-join on an Executor.
+///
+///   TaskGroup group(exec);
+///   group.spawn([&]() { left = sum(lo, mid); });
+///   group.spawn([&]() { right = sum(mid, hi); });
+///   group.wait();
+///
+/// On a worker, wait() doesn't just block: it runs pending tasks, its own
+/// or anyone's, until the group is done, so waiting from inside a task
+/// neither ties up a worker nor deadlocks a pool whose workers are all
+/// waiting. Only once there's nothing to run does it park. From outside the
+/// pool it spins a while and parks. A task's captures are destroyed before
+/// wait() can return.
+///
+/// Tasks may spawn more into their own group. One thread waits on a group.
+class TaskGroup {
+private:
+  // pending tasks, times two, plus a bit set by a waiter about to park
+  static constexpr uint64_t parkedBit = 1;
+  static constexpr uint64_t one = 2;
+
+  Executor& exec;
+  std::atomic<uint64_t> state = 0;
+  std::mutex lock;
+  std::condition_variable done;
+  bool finished = false;
+
+  // the last access to the group by a task, unless the waiter is parked, in
+  // which case the waiter can't return until the lock is released
+  void finish() {
+    if (this->state.fetch_sub(one, std::memory_order_acq_rel) == (one | parkedBit)) {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->finished = true;
+      this->done.notify_one();
+    }
+  }
+
+  template <typename F> struct Task {
+    F fn;
+    TaskGroup* group;
+
+    void operator()() {
+      {
+        F local = std::move(this->fn);
+        local();
+      }
+      this->group->finish();
+    }
+  };
+
+public:
+  explicit TaskGroup(Executor& exec) : exec(exec) {}
+
+  /// Waits for any tasks still pending
+  ~TaskGroup() { this->wait(); }
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /// Runs `f()` on the executor as part of this group
+  template <typename F> void spawn(F&& f) {
+    static_assert(std::invocable<std::decay_t<F>&>, "a task is called with no arguments");
+    this->state.fetch_add(one, std::memory_order_relaxed);
+    this->exec.spawn(Task<std::decay_t<F>>{std::forward<F>(f), this});
+  }
+
+  /// Helps run tasks until every task spawned into the group has finished
+  void wait() {
+    uint32_t round = 0;
+    while (this->state.load(std::memory_order_acquire) != 0) {
+      if (this->exec.runOne()) {
+        round = 0;
+      } else if (!Executor::idleWait.pause(round++, channel::detail::noDeadline)) {
+        break;
+      }
+    }
+    if (this->state.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+
+    // nothing to help with, the rest is running elsewhere
+    if (this->state.fetch_or(parkedBit, std::memory_order_acq_rel) >= one) {
+      trace::Span span("taskgroup.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->done.wait(guard, [this]() { return this->finished; });
+      this->finished = false;
+    }
+    this->state.store(0, std::memory_order_relaxed);
+  }
+};
+
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_EXECUTOR_H
@@ -0,0 +1,81 @@
+#ifndef OASIS_SYNC_FENCE_H
+#define OASIS_SYNC_FENCE_H
+
+#include <atomic>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace oasis {
+namespace sync {
+
+// asymmetric fences: a pair of them, one light and one heavy, orders memory
+// like a pair of seq_cst fences would. the light one is a compiler barrier,
+// the heavy one has the kernel interrupt every running thread of the process
+// with a full barrier (membarrier(2)), so it costs microseconds.
+//
+// for a Dekker-style handshake where one side is hot and the other rare,
+// like publishing messages vs parking a waiting thread: the hot side stores,
+// lightFence()s and loads, the rare side stores, heavyFence()s and loads,
+// and at least one of the loads sees the other side's store.
+//
+// where the kernel can't do it (not linux, or too old) the light fence falls
+// back to a real seq_cst fence.
+
+namespace detail {
+// set once the process is registered for expedited membarriers
+inline std::atomic<bool> membarrierReady = false;
+
+inline bool registerMembarrier() {
+#if defined(__linux__)
+  int supported = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+  if (supported < 0 || !(supported & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) {
+    return false;
+  }
+  return syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#else
+  return false;
+#endif
+}
+}; // namespace detail
+
+inline void lightFence() {
+  // a light fence that sees the flag unset pairs with a heavy fence that may
+  // not have issued a membarrier, so it has to be a full fence itself
+  if (detail::membarrierReady.load(std::memory_order_relaxed)) [[likely]] {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  } else {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+/// Registers the process for cheap light fences, if the kernel allows. Until
+/// then light fences are full fences, so anything built on the pair calls
+/// this up front, e.g. from its constructor.
+inline bool prepareFences() {
+  static const bool registered = []() {
+    bool ok = detail::registerMembarrier();
+    if (ok) {
+      detail::membarrierReady.store(true, std::memory_order_relaxed);
+    }
+    return ok;
+  }();
+  return registered;
+}
+
+inline void heavyFence() {
+#if defined(__linux__)
+  if (prepareFences() && syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0) {
+    return;
+  }
+#endif
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_FENCE_H
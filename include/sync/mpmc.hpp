@@ -0,0 +1,375 @@
+#ifndef OASIS_SYNC_MPMC_H
+#define OASIS_SYNC_MPMC_H
+
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include "channel.hpp"
+#include "fence.hpp"
+#include "ready.hpp"
+
+namespace oasis {
+namespace sync {
+namespace channel {
+
+/// A bounded channel for any number of sending and receiving threads.
+///
+/// This is Dmitry Vyukov's bounded MPMC queue: a power of two ring of cells,
+/// each with a sequence number saying whose turn the cell is. A sender
+/// claims the cell at `enqueuePos` with a CAS once its sequence says it's
+/// free, fills it, then bumps the sequence to hand it to the receiver that
+/// claims the same position from `dequeuePos`. Senders contend only on
+/// `enqueuePos` and receivers only on `dequeuePos`, each on its own cache
+/// line, and nobody ever waits on a lock to make progress.
+///
+/// A receiver finding the ring empty (or a sender finding it full) spins
+/// for a while, then parks on a condition variable; how long a receiver
+/// spins is its WaitStrategy, by default 256 pauses. Each side counts its
+/// parked threads so the other only takes the lock to wake one when there
+/// is one, the count handshake using the asymmetric fences of fence.hpp.
+///
+/// Shutdown and close behave as for Channel: after a shutdown receives fail
+/// at once, after the last sender is dropped they drain the ring first. A
+/// send after shutdown drops its message.
+template <typename T> class MpmcChannel {
+private:
+  static constexpr uint32_t spinIterations = 1 << 8;
+  static constexpr WaitStrategy defaultWait = {.spins = spinIterations};
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    alignas(T) unsigned char bytes[sizeof(T)];
+
+    T* get() { return std::launder(reinterpret_cast<T*>(this->bytes)); }
+  };
+
+  alignas(cacheLineSize) std::atomic<size_t> enqueuePos = 0;
+  alignas(cacheLineSize) std::atomic<size_t> dequeuePos = 0;
+
+  alignas(cacheLineSize) std::atomic<bool> isShutdown = false;
+  std::atomic<bool> isClosed = false;
+  std::atomic<uint32_t> receiversParked = 0;
+  std::atomic<uint32_t> sendersParked = 0;
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+
+  std::mutex lock;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  // selectors waiting to receive, each counted in receiversParked
+  std::vector<detail::Waiter*> waiters;
+  // made by readyFd() under the lock, and read without it by senders
+  std::unique_ptr<ReadyFd> readyOwner;
+  std::atomic<ReadyFd*> ready = nullptr;
+
+  void wakeReceiver() {
+    lightFence();
+    if (ReadyFd* r = this->ready.load(std::memory_order_acquire)) {
+      r->signal();
+    }
+    if (this->receiversParked.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notEmpty.notify_one();
+      detail::signalAll(this->waiters);
+    }
+  }
+
+  void wakeSender() {
+    lightFence();
+    if (this->sendersParked.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notFull.notify_one();
+    }
+  }
+
+  // whether the next receive (send) would find a message (a free cell), for
+  // parked threads to recheck
+  bool looksReadable() const {
+    size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+    const Cell& cell = this->cells[pos & this->mask];
+    return cell.sequence.load(std::memory_order_acquire) == pos + 1;
+  }
+
+  bool looksWritable() const {
+    size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+    const Cell& cell = this->cells[pos & this->mask];
+    return cell.sequence.load(std::memory_order_acquire) == pos;
+  }
+
+  // a publish wakes one parked receiver, which goes back to sleep if the
+  // message is in a later cell than the next one to read, i.e. it was
+  // published ahead of a sender still filling an earlier cell. that wakeup
+  // is used up, and the earlier sender's wakes only one more receiver, so a
+  // receive that goes through passes a wakeup on itself while there's more
+  // to read, and likewise a send while there's room. the fence before the
+  // load is the one issued by wakeSender (wakeReceiver) just before
+  void passOnReceiverWake() {
+    if (this->receiversParked.load(std::memory_order_relaxed) != 0 && this->looksReadable()) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notEmpty.notify_one();
+    }
+  }
+
+  void passOnSenderWake() {
+    if (this->sendersParked.load(std::memory_order_relaxed) != 0 && this->looksWritable()) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notFull.notify_one();
+    }
+  }
+
+  // claims a message, or returns false if the ring is empty
+  bool tryTake(std::optional<T>& out) {
+    size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = this->cells[pos & this->mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (this->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          out.emplace(std::move(*cell.get()));
+          cell.get()->~T();
+          cell.sequence.store(pos + this->mask + 1, std::memory_order_release);
+          this->wakeSender();
+          this->passOnReceiverWake();
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = this->dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // claims a free cell and constructs the message in it, or returns false if
+  // the ring is full. `args` are only used once a cell is claimed.
+  template <typename... Args> bool tryPut(Args&&... args) {
+    size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = this->cells[pos & this->mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          new (cell.bytes) T(std::forward<Args>(args)...);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          this->wakeReceiver();
+          this->passOnSenderWake();
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = this->enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::expected<std::optional<T>, ChannelError> tryRecv() {
+    if (this->isShutdown.load(std::memory_order_acquire)) {
+      return std::unexpected(ChannelError::Shutdown);
+    }
+    std::optional<T> val;
+    if (this->tryTake(val)) {
+      return val;
+    }
+    // rearm the ready fd, then look again for a message whose sender saw it
+    // still signalled
+    if (ReadyFd* r = this->ready.load(std::memory_order_relaxed); r != nullptr && r->clear()) {
+      heavyFence();
+      if (this->tryTake(val)) {
+        return val;
+      }
+    }
+    if (this->isClosed.load(std::memory_order_acquire)) {
+      // every sender published its messages before the last one closed, so
+      // one more look after seeing the close finds any that are left
+      if (!this->tryTake(val)) {
+        return std::unexpected(ChannelError::Shutdown);
+      }
+    }
+    return val;
+  }
+
+  std::expected<T, ChannelError> recv(const WaitStrategy& wait, detail::Deadline deadline) {
+    std::optional<T> val;
+    for (uint32_t round = 0;; round++) {
+      if (this->isShutdown.load(std::memory_order_acquire)) {
+        return std::unexpected(ChannelError::Shutdown);
+      }
+      if (this->tryTake(val)) {
+        return std::move(*val);
+      }
+      if (this->isClosed.load(std::memory_order_acquire)) {
+        if (this->tryTake(val)) {
+          return std::move(*val);
+        }
+        return std::unexpected(ChannelError::Shutdown);
+      }
+      if (wait.pause(round, deadline)) {
+        continue;
+      }
+
+      trace::Span span("mpmc.recv.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->receiversParked.fetch_add(1, std::memory_order_relaxed);
+      heavyFence();
+      bool woken = detail::waitUntil(this->notEmpty, guard, deadline, [&]() {
+        return this->looksReadable() || this->isShutdown.load(std::memory_order_acquire) ||
+               this->isClosed.load(std::memory_order_acquire);
+      });
+      this->receiversParked.fetch_sub(1, std::memory_order_relaxed);
+      if (!woken) {
+        return std::unexpected(ChannelError::Timeout);
+      }
+    }
+  }
+
+  bool trySend(T& val) {
+    if (this->isShutdown.load(std::memory_order_acquire)) {
+      return false;
+    }
+    return this->tryPut(std::move(val));
+  }
+
+  template <typename... Args> void emplace(Args&&... args) {
+    // a constructor throwing in a claimed cell would leave the cell
+    // unpublished and stall every receiver behind it, so unless it can't
+    // throw, build the message first and only move it into the cell
+    constexpr bool isMove = sizeof...(Args) == 1 && (std::is_same_v<Args, T> && ...);
+    if constexpr (!isMove && !std::is_nothrow_constructible_v<T, Args&&...>) {
+      return this->emplace(T(std::forward<Args>(args)...));
+    }
+
+    for (uint32_t spins = 0;; spins++) {
+      if (this->isShutdown.load(std::memory_order_acquire)) {
+        return;
+      }
+      if (this->tryPut(std::forward<Args>(args)...)) {
+        return;
+      }
+      if (spins < spinIterations) {
+        cpuRelax();
+        continue;
+      }
+
+      trace::Span span("mpmc.send.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->sendersParked.fetch_add(1, std::memory_order_relaxed);
+      heavyFence();
+      this->notFull.wait(guard, [&]() {
+        return this->looksWritable() || this->isShutdown.load(std::memory_order_acquire);
+      });
+      this->sendersParked.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  void shutdown() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->isShutdown.store(true, std::memory_order_release);
+    this->notEmpty.notify_all();
+    this->notFull.notify_all();
+    detail::signalAll(this->waiters);
+    if (this->readyOwner != nullptr) {
+      this->readyOwner->signal();
+    }
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->isClosed.store(true, std::memory_order_release);
+    this->notEmpty.notify_all();
+    this->notFull.notify_all();
+    detail::signalAll(this->waiters);
+    if (this->readyOwner != nullptr) {
+      this->readyOwner->signal();
+    }
+  }
+
+  int readyFd() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->readyOwner == nullptr) {
+      this->readyOwner = std::make_unique<ReadyFd>();
+      this->ready.store(this->readyOwner.get(), std::memory_order_release);
+      // a send that didn't see the fd yet is seen here
+      heavyFence();
+      if (this->looksReadable() || this->isShutdown.load(std::memory_order_acquire) ||
+          this->isClosed.load(std::memory_order_acquire)) {
+        this->readyOwner->signal();
+      }
+    }
+    return this->readyOwner->fd();
+  }
+
+  void addWaiter(detail::Waiter* waiter) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->waiters.push_back(waiter);
+    // the selector fences after registering with all its channels
+    this->receiversParked.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void removeWaiter(detail::Waiter* waiter) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    std::erase(this->waiters, waiter);
+    this->receiversParked.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  template <typename U, typename C> friend class Receiver;
+  template <typename U, typename C> friend class Sender;
+
+public:
+  /// Senders look for parked receivers without the lock, so parking fences
+  static constexpr bool lockFree = true;
+  /// Has trySend(), it holds at most its capacity
+  static constexpr bool bounded = true;
+
+  /// `capacity` is rounded up to a power of two
+  explicit MpmcChannel(size_t capacity)
+      : cells(new Cell[std::bit_ceil(std::max<size_t>(capacity, 2))]),
+        mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1) {
+    for (size_t idx = 0; idx <= this->mask; idx++) {
+      this->cells[idx].sequence.store(idx, std::memory_order_relaxed);
+    }
+    prepareFences();
+  }
+
+  ~MpmcChannel() {
+    std::optional<T> val;
+    while (this->tryTake(val)) {
+      val.reset();
+    }
+  }
+
+  MpmcChannel(const MpmcChannel&) = delete;
+  MpmcChannel& operator=(const MpmcChannel&) = delete;
+
+  size_t capacity() const { return this->mask + 1; }
+};
+
+template <typename T> using MpmcSender = Sender<T, MpmcChannel<T>>;
+template <typename T> using MpmcReceiver = Receiver<T, MpmcChannel<T>>;
+
+/// A channel for any number of sending and receiving threads, holding up
+/// to `capacity` (rounded up to a power of two) messages
+template <typename T> std::pair<MpmcSender<T>, MpmcReceiver<T>> mkMpmcChannel(size_t capacity) {
+  auto *shared = detail::Shared<MpmcChannel<T>>::make(capacity);
+  return std::pair(MpmcSender<T>(shared), MpmcReceiver<T>(shared));
+}
+
+}; // namespace channel
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_MPMC_H
@@ -0,0 +1,100 @@
+#ifndef OASIS_SYNC_READY_H
+#define OASIS_SYNC_READY_H
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#else
+#include <fcntl.h>
+#endif
+
+namespace oasis {
+namespace sync {
+
+/// A file descriptor that polls readable while something is ready, so an
+/// event loop (epoll, kqueue, poll) can wait on it alongside sockets. An
+/// eventfd on linux, a pipe elsewhere.
+///
+/// Signals are coalesced: once signalled, further signal()s are a relaxed
+/// load until clear() rearms it, so a burst costs one write(2). A clear()
+/// is always a read(2), even on an fd that isn't readable.
+class ReadyFd {
+private:
+  std::atomic<bool> signalled = false;
+  int readEnd = -1;
+  int writeEnd = -1;
+
+public:
+  ReadyFd() {
+#if defined(__linux__)
+    this->readEnd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->readEnd < 0) {
+      throw std::runtime_error("[ReadyFd] failed to create eventfd (syscall)");
+    }
+    this->writeEnd = this->readEnd;
+#else
+    int ends[2];
+    if (pipe(ends) != 0) {
+      throw std::runtime_error("[ReadyFd] failed to create pipe (syscall)");
+    }
+    for (int end : ends) {
+      fcntl(end, F_SETFL, fcntl(end, F_GETFL) | O_NONBLOCK);
+      fcntl(end, F_SETFD, FD_CLOEXEC);
+    }
+    this->readEnd = ends[0];
+    this->writeEnd = ends[1];
+#endif
+  }
+
+  ~ReadyFd() {
+    close(this->readEnd);
+    if (this->writeEnd != this->readEnd) {
+      close(this->writeEnd);
+    }
+  }
+
+  ReadyFd(const ReadyFd&) = delete;
+  ReadyFd& operator=(const ReadyFd&) = delete;
+
+  /// The end to poll for readability
+  int fd() const { return this->readEnd; }
+
+  /// Makes the fd readable, unless it already is. From any thread.
+  void signal() {
+    if (this->signalled.load(std::memory_order_relaxed) ||
+        this->signalled.exchange(true, std::memory_order_acq_rel)) {
+      return;
+    }
+    uint64_t one = 1;
+    // the only failure is a full counter (or pipe), which is readable anyway
+    [[maybe_unused]] ssize_t n = write(this->writeEnd, &one, sizeof(one));
+  }
+
+  /// Makes the fd unreadable again and returns whether it was signalled.
+  /// Whoever clears it has to look again at what it signals for afterwards
+  /// (with a fence against the signaller where that's lock-free), or a
+  /// signal sent just before the clear is lost.
+  bool clear() {
+    // always drains, even with the flag down: a signaller sets the flag
+    // before it writes, so a clear racing it can drop the flag before the
+    // write lands, leaving the fd readable with the flag down. the next
+    // clear has to take that write out or the fd stays readable for good.
+    // draining before dropping the flag means the flag is never left up
+    // over an fd with nothing to read, which would swallow later signals
+    bool drained = false;
+    uint64_t buf[8];
+    while (read(this->readEnd, buf, sizeof(buf)) > 0) {
+      drained = true;
+    }
+    return this->signalled.exchange(false, std::memory_order_acq_rel) || drained;
+  }
+};
+
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_READY_H
@@ -0,0 +1,165 @@
+#ifndef OASIS_SYNC_SELECT_H
+#define OASIS_SYNC_SELECT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <expected>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "../trace.hpp"
+#include "channel.hpp"
+#include "fence.hpp"
+
+namespace oasis {
+namespace sync {
+namespace channel {
+
+enum class SelectOrder {
+  /// start each look at the receiver after the one that last delivered, so a
+  /// busy receiver can't starve the others
+  Fair,
+  /// always look at the receivers in the order given, e.g. control before data
+  Priority,
+};
+
+/// Receives from whichever of several receivers has a message first. The
+/// receivers can be of any message and channel types.
+///
+///   Selector select;
+///   auto msg = select.recv(control, data, timers);
+///   switch (msg.index()) { ... std::get<1>(msg) ... }
+///
+/// The result holds, at the index of the receiver it came from, either a
+/// message or Shutdown. A receiver that's shut down (or closed and drained)
+/// reports Shutdown every time it's looked at, so drop it from the set then.
+///
+/// A selector with nothing to receive registers one waiter with every
+/// channel, checks them all once more, and parks until any of them signals
+/// the waiter. The registration is made before that last check, so a
+/// message sent meanwhile is either seen by the check or signals the waiter.
+/// When any of the channels is lock-free (SPSC or MPMC) the registration is
+/// followed by the heavy fence of a parking receiver on those channels;
+/// selecting only over locked channels needs no fence.
+///
+/// A Selector belongs to one thread. An SPSC receiver may be selected on only
+/// by its single receiving thread, as for any receive.
+class Selector {
+public:
+  template <typename... Rs>
+  using Result = std::variant<std::expected<typename Rs::value_type, ChannelError>...>;
+
+  explicit Selector(SelectOrder order = SelectOrder::Fair) : order(order) {}
+
+  Selector(const Selector &) = delete;
+  Selector &operator=(const Selector &) = delete;
+
+  /// Waits for a message from any of `receivers`
+  template <typename... Rs> Result<Rs...> recv(Rs &...receivers) {
+    return *this->recvUntilDeadline(detail::noDeadline, receivers...);
+  }
+
+  /// As recv(), but fails with Timeout if nothing arrives within `timeout`
+  template <typename Rep, typename Period, typename... Rs>
+  std::expected<Result<Rs...>, ChannelError> recvFor(std::chrono::duration<Rep, Period> timeout,
+                                                     Rs &...receivers) {
+    return this->recvUntilDeadline(std::chrono::steady_clock::now() + timeout, receivers...);
+  }
+
+  /// As recv(), but fails with Timeout if nothing arrives by `deadline`
+  template <typename Clock, typename Duration, typename... Rs>
+  std::expected<Result<Rs...>, ChannelError>
+  recvUntil(std::chrono::time_point<Clock, Duration> deadline, Rs &...receivers) {
+    if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>) {
+      return this->recvUntilDeadline(
+          std::chrono::time_point_cast<detail::Deadline::duration>(deadline), receivers...);
+    } else {
+      return this->recvFor(deadline - Clock::now(), receivers...);
+    }
+  }
+
+private:
+  detail::Waiter waiter;
+  SelectOrder order;
+  // where a Fair look starts
+  size_t next = 0;
+
+  template <typename... Rs>
+  std::expected<Result<Rs...>, ChannelError> recvUntilDeadline(detail::Deadline deadline,
+                                                               Rs &...receivers) {
+    static_assert(sizeof...(Rs) > 0, "select needs a receiver");
+    while (true) {
+      if (std::optional<Result<Rs...>> result = this->poll(receivers...)) {
+        return std::move(*result);
+      }
+
+      {
+        std::lock_guard<std::mutex> guard(this->waiter.lock);
+        this->waiter.signalled = false;
+      }
+      (receivers.addWaiter(&this->waiter), ...);
+      // a locked channel's senders see the registration through its lock
+      if constexpr ((Rs::lockFree || ...)) {
+        heavyFence();
+      }
+
+      std::optional<Result<Rs...>> result = this->poll(receivers...);
+      bool woken = true;
+      if (!result) {
+        trace::Span span("select.park");
+        std::unique_lock<std::mutex> guard(this->waiter.lock);
+        woken = detail::waitUntil(this->waiter.cond, guard, deadline,
+                                  [this]() { return this->waiter.signalled; });
+      }
+      (receivers.removeWaiter(&this->waiter), ...);
+
+      if (result) {
+        return std::move(*result);
+      }
+      if (!woken) {
+        return std::unexpected(ChannelError::Timeout);
+      }
+    }
+  }
+
+  // one tryRecv on each receiver in turn until one has a message or is shut
+  // down
+  template <typename... Rs> std::optional<Result<Rs...>> poll(Rs &...receivers) {
+    constexpr size_t count = sizeof...(Rs);
+    size_t start = this->order == SelectOrder::Fair ? this->next : 0;
+    std::optional<Result<Rs...>> result;
+    for (size_t k = 0; k < count && !result; k++) {
+      size_t idx = (start + k) % count;
+      tryIndex(idx, result, std::index_sequence_for<Rs...>{}, receivers...);
+      if (result) {
+        this->next = (idx + 1) % count;
+      }
+    }
+    return result;
+  }
+
+  template <typename Res, size_t... Is, typename... Rs>
+  static void tryIndex(size_t idx, std::optional<Res> &out, std::index_sequence<Is...>,
+                       Rs &...receivers) {
+    ((Is == idx ? tryOne<Is>(receivers, out) : void()), ...);
+  }
+
+  template <size_t I, typename R, typename Res> static void tryOne(R &receiver, std::optional<Res> &out) {
+    auto val = receiver.tryRecv();
+    if (!val.has_value()) {
+      out.emplace(std::in_place_index<I>, std::unexpected(val.error()));
+    } else if (val->has_value()) {
+      out.emplace(std::in_place_index<I>, std::move(**val));
+    }
+  }
+};
+
+}; // namespace channel
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_SELECT_H
@@ -0,0 +1,337 @@
+#ifndef OASIS_SYNC_SPSC_H
+#define OASIS_SYNC_SPSC_H
+
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include "channel.hpp"
+#include "fence.hpp"
+#include "ready.hpp"
+
+namespace oasis {
+namespace sync {
+namespace channel {
+
+/// A bounded channel for exactly one sending and one receiving thread.
+///
+/// Messages live in a power of two ring. The sender only writes `tail` and
+/// the receiver only writes `head`, each on a cache line of its own, and
+/// each side keeps a copy of the other's index that it refreshes only when
+/// the ring looks full (or empty) by the copy. So in a steady stream the two
+/// threads rarely touch the same cache line, and a send or receive is a
+/// slot access and a store.
+///
+/// A receiver waiting on an empty ring (or a sender on a full one) spins for
+/// a while, then parks on a condition variable; how long a receiver spins
+/// is its WaitStrategy, by default 256 pauses. The other side only takes
+/// the lock to wake it when it has flagged that it's parked, and the flag
+/// handshake is an asymmetric fence pair (see fence.hpp), so all of its cost
+/// falls on the thread about to park.
+///
+/// Shutdown and close behave as for Channel: after a shutdown receives fail
+/// at once, after the sender is dropped they drain the ring first. A send
+/// after shutdown drops its message.
+template <typename T> class SpscChannel {
+private:
+  static constexpr uint32_t spinIterations = 1 << 8;
+  static constexpr WaitStrategy defaultWait = {.spins = spinIterations};
+
+  struct Slot {
+    alignas(T) unsigned char bytes[sizeof(T)];
+
+    T* get() { return std::launder(reinterpret_cast<T*>(this->bytes)); }
+  };
+
+  // the sender's line
+  alignas(cacheLineSize) std::atomic<size_t> tail = 0;
+  size_t cachedHead = 0;
+
+  // the receiver's line
+  alignas(cacheLineSize) std::atomic<size_t> head = 0;
+  size_t cachedTail = 0;
+
+  // read by both sides on every operation but written rarely, so it stays
+  // shared in both caches
+  alignas(cacheLineSize) std::atomic<bool> isShutdown = false;
+  std::atomic<bool> isClosed = false;
+  std::atomic<bool> receiverParked = false;
+  std::atomic<bool> senderParked = false;
+  std::unique_ptr<Slot[]> slots;
+  size_t mask;
+
+  std::mutex lock;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  // selectors waiting on the receiving side, they count as it being parked
+  std::vector<detail::Waiter*> waiters;
+  // made by readyFd() under the lock, and read without it by senders
+  std::unique_ptr<ReadyFd> readyOwner;
+  std::atomic<ReadyFd*> ready = nullptr;
+
+  // a publishing side stores its index then checks the other side's parked
+  // flag, a parking side sets its flag then checks the index. the fences
+  // between make sure one of them sees the other's store, so a thread never
+  // parks through the message (or free slot) that would have woken it.
+  void wakeReceiver() {
+    lightFence();
+    if (ReadyFd* r = this->ready.load(std::memory_order_acquire)) {
+      r->signal();
+    }
+    if (this->receiverParked.load(std::memory_order_relaxed)) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notEmpty.notify_one();
+      detail::signalAll(this->waiters);
+    }
+  }
+
+  void wakeSender() {
+    lightFence();
+    if (this->senderParked.load(std::memory_order_relaxed)) [[unlikely]] {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->notFull.notify_one();
+    }
+  }
+
+  // receiver side. whether a message is ready at `h`, refreshing the cached
+  // tail if it looks like there isn't
+  bool readable(size_t h) {
+    if (h != this->cachedTail) {
+      return true;
+    }
+    this->cachedTail = this->tail.load(std::memory_order_acquire);
+    return h != this->cachedTail;
+  }
+
+  // sender side, the same for a free slot at `t`
+  bool writable(size_t t) {
+    if (t - this->cachedHead <= this->mask) {
+      return true;
+    }
+    this->cachedHead = this->head.load(std::memory_order_acquire);
+    return t - this->cachedHead <= this->mask;
+  }
+
+  T take(size_t h) {
+    Slot& slot = this->slots[h & this->mask];
+    T val = std::move(*slot.get());
+    slot.get()->~T();
+    this->head.store(h + 1, std::memory_order_release);
+    this->wakeSender();
+    return val;
+  }
+
+  template <typename... Args> void put(size_t t, Args&&... args) {
+    new (this->slots[t & this->mask].bytes) T(std::forward<Args>(args)...);
+    this->tail.store(t + 1, std::memory_order_release);
+    this->wakeReceiver();
+  }
+
+  std::expected<std::optional<T>, ChannelError> tryRecv() {
+    if (this->isShutdown.load(std::memory_order_acquire)) {
+      return std::unexpected(ChannelError::Shutdown);
+    }
+    size_t h = this->head.load(std::memory_order_relaxed);
+    if (!this->readable(h)) {
+      // rearm the ready fd, then look again for a message whose sender saw
+      // it still signalled
+      if (ReadyFd* r = this->ready.load(std::memory_order_relaxed); r != nullptr && r->clear()) {
+        heavyFence();
+        if (this->readable(h)) {
+          return this->take(h);
+        }
+      }
+      // the sender's last message is published before it closes, so one
+      // more look after seeing the close finds it
+      if (this->isClosed.load(std::memory_order_acquire) && !this->readable(h)) {
+        return std::unexpected(ChannelError::Shutdown);
+      }
+      return {};
+    }
+    return this->take(h);
+  }
+
+  std::expected<T, ChannelError> recv(const WaitStrategy& wait, detail::Deadline deadline) {
+    size_t h = this->head.load(std::memory_order_relaxed);
+    for (uint32_t round = 0; !this->readable(h); round++) {
+      if (this->isShutdown.load(std::memory_order_acquire)) {
+        return std::unexpected(ChannelError::Shutdown);
+      }
+      if (this->isClosed.load(std::memory_order_acquire)) {
+        if (this->readable(h)) {
+          break;
+        }
+        return std::unexpected(ChannelError::Shutdown);
+      }
+      if (wait.pause(round, deadline)) {
+        continue;
+      }
+
+      trace::Span span("spsc.recv.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->receiverParked.store(true, std::memory_order_relaxed);
+      heavyFence();
+      bool woken = detail::waitUntil(this->notEmpty, guard, deadline, [&]() {
+        return this->tail.load(std::memory_order_acquire) != h ||
+               this->isShutdown.load(std::memory_order_acquire) ||
+               this->isClosed.load(std::memory_order_acquire);
+      });
+      this->receiverParked.store(false, std::memory_order_relaxed);
+      if (!woken) {
+        return std::unexpected(ChannelError::Timeout);
+      }
+    }
+
+    if (this->isShutdown.load(std::memory_order_acquire)) {
+      return std::unexpected(ChannelError::Shutdown);
+    }
+    return this->take(h);
+  }
+
+  bool trySend(T& val) {
+    if (this->isShutdown.load(std::memory_order_acquire)) {
+      return false;
+    }
+    size_t t = this->tail.load(std::memory_order_relaxed);
+    if (!this->writable(t)) {
+      return false;
+    }
+    this->put(t, std::move(val));
+    return true;
+  }
+
+  template <typename... Args> void emplace(Args&&... args) {
+    size_t t = this->tail.load(std::memory_order_relaxed);
+    for (uint32_t spins = 0; !this->writable(t); spins++) {
+      if (this->isShutdown.load(std::memory_order_acquire)) {
+        return;
+      }
+      if (spins < spinIterations) {
+        cpuRelax();
+        continue;
+      }
+
+      trace::Span span("spsc.send.park");
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->senderParked.store(true, std::memory_order_relaxed);
+      heavyFence();
+      this->notFull.wait(guard, [&]() {
+        return t - this->head.load(std::memory_order_acquire) <= this->mask ||
+               this->isShutdown.load(std::memory_order_acquire);
+      });
+      this->senderParked.store(false, std::memory_order_relaxed);
+    }
+
+    if (this->isShutdown.load(std::memory_order_acquire)) {
+      return;
+    }
+    this->put(t, std::forward<Args>(args)...);
+  }
+
+  void shutdown() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->isShutdown.store(true, std::memory_order_release);
+    this->notEmpty.notify_all();
+    this->notFull.notify_all();
+    detail::signalAll(this->waiters);
+    if (this->readyOwner != nullptr) {
+      this->readyOwner->signal();
+    }
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->isClosed.store(true, std::memory_order_release);
+    this->notEmpty.notify_all();
+    this->notFull.notify_all();
+    detail::signalAll(this->waiters);
+    if (this->readyOwner != nullptr) {
+      this->readyOwner->signal();
+    }
+  }
+
+  int readyFd() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->readyOwner == nullptr) {
+      this->readyOwner = std::make_unique<ReadyFd>();
+      this->ready.store(this->readyOwner.get(), std::memory_order_release);
+      // a send that didn't see the fd yet is seen here
+      heavyFence();
+      if (this->tail.load(std::memory_order_acquire) != this->head.load(std::memory_order_acquire) || this->isShutdown.load(std::memory_order_acquire) ||
+          this->isClosed.load(std::memory_order_acquire)) {
+        this->readyOwner->signal();
+      }
+    }
+    return this->readyOwner->fd();
+  }
+
+  void addWaiter(detail::Waiter* waiter) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->waiters.push_back(waiter);
+    // the selector is the one receiver, so nothing else is parked. it fences
+    // after registering with all its channels
+    this->receiverParked.store(true, std::memory_order_relaxed);
+  }
+
+  void removeWaiter(detail::Waiter* waiter) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    std::erase(this->waiters, waiter);
+    this->receiverParked.store(false, std::memory_order_relaxed);
+  }
+
+  template <typename U, typename C> friend class Receiver;
+  template <typename U, typename C> friend class Sender;
+
+public:
+  /// Its handles are move-only, there's one of each
+  static constexpr bool singleEnded = true;
+  /// The sender looks for a parked receiver without the lock, so parking fences
+  static constexpr bool lockFree = true;
+  /// Has trySend(), it holds at most its capacity
+  static constexpr bool bounded = true;
+
+  /// `capacity` is rounded up to a power of two
+  explicit SpscChannel(size_t capacity)
+      : slots(new Slot[std::bit_ceil(std::max<size_t>(capacity, 2))]),
+        mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1) {
+    prepareFences();
+  }
+
+  ~SpscChannel() {
+    size_t end = this->tail.load(std::memory_order_acquire);
+    for (size_t h = this->head.load(std::memory_order_relaxed); h != end; h++) {
+      this->slots[h & this->mask].get()->~T();
+    }
+  }
+
+  SpscChannel(const SpscChannel&) = delete;
+  SpscChannel& operator=(const SpscChannel&) = delete;
+
+  size_t capacity() const { return this->mask + 1; }
+};
+
+template <typename T> using SpscSender = Sender<T, SpscChannel<T>>;
+template <typename T> using SpscReceiver = Receiver<T, SpscChannel<T>>;
+
+/// A channel for one sending and one receiving thread, holding up to
+/// `capacity` (rounded up to a power of two) messages
+template <typename T> std::pair<SpscSender<T>, SpscReceiver<T>> mkSpscChannel(size_t capacity) {
+  auto *shared = detail::Shared<SpscChannel<T>>::make(capacity);
+  return std::pair(SpscSender<T>(shared), SpscReceiver<T>(shared));
+}
+
+}; // namespace channel
+}; // namespace sync
+}; // namespace oasis
+
+#endif // OASIS_SYNC_SPSC_H
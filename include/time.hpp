@@ -1,16 +1,308 @@
 #ifndef OASIS_TIME_H
 #define OASIS_TIME_H
 
-#include <cstdint>
+#include <atomic>
 #include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "utils.hpp"
 
 namespace oasis {
 namespace time {
-uint64_t millisSinceEpoch() {
-  auto now = std::chrono::system_clock::now();
-  auto duration = now.time_since_epoch();
-  return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+
+/// A source of nanosecond timestamps. `sinceEpoch` says whether readings
+/// count from the unix epoch (a wall clock) or from some arbitrary point,
+/// in which case only differences between readings mean anything.
+template <typename C>
+concept Clock = requires {
+  { C::nowNanos() } -> std::same_as<uint64_t>;
+  { C::sinceEpoch } -> std::convertible_to<bool>;
+};
+
+template <typename C>
+concept WallClock = Clock<C> && C::sinceEpoch;
+
+namespace detail {
+inline uint64_t readClock(clockid_t id) {
+  struct timespec ts;
+  clock_gettime(id, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
 }
+}; // namespace detail
+
+/// The wall clock, CLOCK_REALTIME. On linux this is read through the vDSO,
+/// so it costs a couple dozen nanoseconds and no system call.
+struct RealtimeClock {
+  static constexpr bool sinceEpoch = true;
+
+  static uint64_t nowNanos() { return detail::readClock(CLOCK_REALTIME); }
+};
+
+/// The wall clock as of the last timer tick, CLOCK_REALTIME_COARSE. Only
+/// accurate to the tick (1 - 4ms on most linux kernels) but several times
+/// cheaper to read than RealtimeClock. Where there's no coarse clock this is
+/// RealtimeClock.
+struct CoarseRealtimeClock {
+  static constexpr bool sinceEpoch = true;
+
+  static uint64_t nowNanos() {
+#if defined(CLOCK_REALTIME_COARSE)
+    return detail::readClock(CLOCK_REALTIME_COARSE);
+#else
+    return detail::readClock(CLOCK_REALTIME);
+#endif
+  }
+};
+
+/// CLOCK_MONOTONIC, never goes backwards, for measuring intervals
+struct MonotonicClock {
+  static constexpr bool sinceEpoch = false;
+
+  static uint64_t nowNanos() { return detail::readClock(CLOCK_MONOTONIC); }
+};
+
+/// The CPU's invariant timestamp counter, scaled to wall clock nanoseconds.
+///
+/// The counter's rate is measured against CLOCK_REALTIME once per process,
+/// on first use or an explicit calibrate(), which spins for
+/// `calibrationNanos`. After that a reading is a rdtsc and a multiply. It
+/// isn't steered by NTP, so it drifts from the wall clock by the calibration
+/// error, in the order of a few ppm.
+///
+/// On CPUs without an invariant counter (or that aren't x86) this is
+/// RealtimeClock.
+struct TscClock {
+  static constexpr bool sinceEpoch = true;
+
+  static constexpr uint64_t calibrationNanos = 20'000'000;
+
+  /// Whether readings actually come from the timestamp counter
+  static bool available() { return calibration().ticksToNanos != 0; }
+
+  /// Calibrates now rather than on the first reading
+  static void calibrate() { calibration(); }
+
+  static uint64_t nowNanos() {
+#if defined(__x86_64__) || defined(__i386__)
+    const Calibration& c = calibration();
+    if (c.ticksToNanos != 0) [[likely]] {
+      // signed, another core's counter may be slightly behind the base
+      __int128_t ticks = static_cast<int64_t>(__rdtsc() - c.baseTicks);
+      return c.baseNanos + static_cast<int64_t>((ticks * c.ticksToNanos) >> 32);
+    }
+#endif
+    return RealtimeClock::nowNanos();
+  }
+
+private:
+  struct Calibration {
+    uint64_t baseTicks = 0;
+    uint64_t baseNanos = 0;
+    // nanoseconds per tick, as a 32.32 fixed point number, 0 if unavailable
+    uint64_t ticksToNanos = 0;
+  };
+
+#if defined(__x86_64__) || defined(__i386__)
+  static bool hasInvariantTsc() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x8000'0007, &eax, &ebx, &ecx, &edx)) {
+      return false;
+    }
+    return edx & (1u << 8);
+  }
+
+  // a (ticks, nanos) pair read as close together as we can manage: the
+  // clock read bracketed by the tightest pair of counter reads out of a few
+  static void sample(uint64_t& ticks, uint64_t& nanos) {
+    uint64_t bestSpread = UINT64_MAX;
+    for (int i = 0; i < 16; i++) {
+      uint64_t before = __rdtsc();
+      uint64_t now = RealtimeClock::nowNanos();
+      uint64_t after = __rdtsc();
+      if (after - before < bestSpread) {
+        bestSpread = after - before;
+        ticks = before + (after - before) / 2;
+        nanos = now;
+      }
+    }
+  }
+#endif
+
+  static const Calibration& calibration() {
+    static const Calibration calibration = []() {
+      Calibration c;
+#if defined(__x86_64__) || defined(__i386__)
+      if (!hasInvariantTsc()) {
+        return c;
+      }
+
+      uint64_t startTicks = 0, startNanos = 0, endTicks = 0, endNanos = 0;
+      sample(startTicks, startNanos);
+      uint64_t deadline = MonotonicClock::nowNanos() + calibrationNanos;
+      while (MonotonicClock::nowNanos() < deadline) {
+      }
+      sample(endTicks, endNanos);
+
+      if (endTicks <= startTicks || endNanos <= startNanos) {
+        return c;
+      }
+      c.baseTicks = endTicks;
+      c.baseNanos = endNanos;
+      c.ticksToNanos = ((endNanos - startNanos) << 32) / (endTicks - startTicks);
+#endif
+      return c;
+    }();
+    return calibration;
+  }
+};
+
+namespace detail {
+// the millisecond published by CachedClock's ticker, 0 while it's stopped.
+// alone on its cache line so that only the ticker's stores invalidate it.
+struct alignas(cacheLineSize) CachedMillis {
+  std::atomic<uint64_t> value = 0;
+};
+
+inline CachedMillis cachedMillis;
+}; // namespace detail
+
+/// The wall clock to the millisecond, read from a shared cache.
+///
+/// While started, a background ticker thread publishes the current
+/// millisecond into an atomic on a cache line of its own, just after each
+/// millisecond boundary, and a reading is a single relaxed load. Readings may
+/// trail RealtimeClock by the ticker's wakeup latency, typically well under a
+/// millisecond.
+///
+/// start() and stop() are reference counted, the ticker runs while at least
+/// one start() hasn't been matched by a stop(). When it isn't running,
+/// readings fall back to RealtimeClock, so a reading is never stale.
+class CachedClock {
+public:
+  static constexpr bool sinceEpoch = true;
+
+  static uint64_t nowMillis() {
+    uint64_t millis = detail::cachedMillis.value.load(std::memory_order_relaxed);
+    if (millis != 0) [[likely]] {
+      return millis;
+    }
+    return RealtimeClock::nowNanos() / 1'000'000;
+  }
+
+  static uint64_t nowNanos() { return nowMillis() * 1'000'000; }
+
+  /// Starts the ticker if it isn't running. The current millisecond is
+  /// published before this returns.
+  static void start() {
+    Ticker& t = ticker();
+    std::lock_guard<std::mutex> guard(t.lock);
+    if (t.users++ > 0) {
+      return;
+    }
+    detail::cachedMillis.value.store(RealtimeClock::nowNanos() / 1'000'000, std::memory_order_relaxed);
+    t.thread = std::thread(&CachedClock::run, t.generation);
+  }
+
+  /// Stops the ticker once every start() has been matched, waiting for its
+  /// thread to exit
+  static void stop() {
+    Ticker& t = ticker();
+    std::thread thread;
+    {
+      std::lock_guard<std::mutex> guard(t.lock);
+      if (t.users == 0 || --t.users > 0) {
+        return;
+      }
+      t.generation++;
+      thread = std::move(t.thread);
+    }
+    t.cond.notify_all();
+    thread.join();
+
+    std::lock_guard<std::mutex> guard(t.lock);
+    // unless a start() raced in while we were joining
+    if (t.users == 0) {
+      detail::cachedMillis.value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  static bool running() {
+    Ticker& t = ticker();
+    std::lock_guard<std::mutex> guard(t.lock);
+    return t.users > 0;
+  }
+
+  /// Keeps the ticker running for its lifetime
+  class Session {
+  public:
+    Session() { CachedClock::start(); }
+    ~Session() { CachedClock::stop(); }
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+  };
+
+private:
+  struct Ticker {
+    std::mutex lock;
+    std::condition_variable cond;
+    size_t users = 0;
+    // bumped to stop the running thread, so a thread being joined by stop()
+    // can't be revived by a start() that follows it
+    uint64_t generation = 0;
+    std::thread thread;
+
+    ~Ticker() {
+      if (this->thread.joinable()) {
+        {
+          std::lock_guard<std::mutex> guard(this->lock);
+          this->generation++;
+        }
+        this->cond.notify_all();
+        this->thread.join();
+      }
+    }
+  };
+
+  static Ticker& ticker() {
+    static Ticker ticker;
+    return ticker;
+  }
+
+  static void run(uint64_t generation) {
+    Ticker& t = ticker();
+    std::unique_lock<std::mutex> guard(t.lock);
+    while (t.generation == generation) {
+      uint64_t nanos = RealtimeClock::nowNanos();
+      detail::cachedMillis.value.store(nanos / 1'000'000, std::memory_order_relaxed);
+
+      // wake just after the next millisecond starts
+      auto untilNext = std::chrono::nanoseconds(1'000'000 - nanos % 1'000'000);
+      t.cond.wait_for(guard, untilNext, [&]() { return t.generation != generation; });
+    }
+  }
+};
+
+/// Milliseconds since the unix epoch by the given wall clock
+template <WallClock C = RealtimeClock>
+inline uint64_t millisSinceEpoch() {
+  if constexpr (requires { { C::nowMillis() } -> std::same_as<uint64_t>; }) {
+    return C::nowMillis();
+  } else {
+    return C::nowNanos() / 1'000'000;
+  }
+}
+
 }; // namespace time
 }; // namespace oasis
 
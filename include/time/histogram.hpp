@@ -0,0 +1,292 @@
+#ifndef OASIS_TIME_HISTOGRAM_H
+#define OASIS_TIME_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../time.hpp"
+
+namespace oasis {
+namespace time {
+
+/// A log-linear (HDR style) histogram of 64-bit values, typically latencies
+/// in nanoseconds.
+///
+/// Values below 256 get a bucket each. Above that every power of two is
+/// split into 128 equal buckets, so a value is reported to within 1/128
+/// (under 0.8%) of itself, across the whole 64-bit range, in a fixed 58KB of
+/// counts.
+///
+/// Not thread safe, see LatencyRecorder for recording from many threads.
+class Histogram {
+public:
+  static constexpr uint64_t subBucketBits = 7;
+  static constexpr uint64_t subBuckets = 1 << subBucketBits;
+  static constexpr size_t numBuckets = (64 - subBucketBits + 1) * subBuckets;
+
+  /// The bucket `value` is counted in
+  static inline size_t bucketIndex(uint64_t value) {
+    // values below subBuckets land in the first block, shift 0, directly
+    uint64_t shift = (63 - std::countl_zero(value | subBuckets)) - subBucketBits;
+    return ((shift + 1) << subBucketBits) + (value >> shift) - subBuckets;
+  }
+
+  /// The smallest value counted in bucket `idx`
+  static inline uint64_t bucketLowest(size_t idx) {
+    uint64_t block = idx >> subBucketBits;
+    uint64_t sub = idx & (subBuckets - 1);
+    if (block == 0) {
+      return sub;
+    }
+    return (sub + subBuckets) << (block - 1);
+  }
+
+  /// The largest value counted in bucket `idx`
+  static inline uint64_t bucketHighest(size_t idx) {
+    uint64_t block = idx >> subBucketBits;
+    uint64_t width = block == 0 ? 1 : 1LLU << (block - 1);
+    return bucketLowest(idx) + (width - 1);
+  }
+
+private:
+  std::vector<uint64_t> counts;
+  uint64_t total = 0;
+  uint64_t sum = 0;
+  uint64_t minValue = UINT64_MAX;
+  uint64_t maxValue = 0;
+
+  friend class LatencyRecorder;
+
+public:
+  Histogram() : counts(numBuckets, 0) {}
+
+  void record(uint64_t value, uint64_t count = 1) {
+    this->counts[bucketIndex(value)] += count;
+    this->total += count;
+    this->sum += value * count;
+    this->minValue = std::min(this->minValue, value);
+    this->maxValue = std::max(this->maxValue, value);
+  }
+
+  /// Adds every value recorded in `other`
+  void merge(const Histogram& other) {
+    for (size_t idx = 0; idx < numBuckets; idx++) {
+      this->counts[idx] += other.counts[idx];
+    }
+    this->total += other.total;
+    this->sum += other.sum;
+    this->minValue = std::min(this->minValue, other.minValue);
+    this->maxValue = std::max(this->maxValue, other.maxValue);
+  }
+
+  void reset() {
+    std::fill(this->counts.begin(), this->counts.end(), 0);
+    this->total = 0;
+    this->sum = 0;
+    this->minValue = UINT64_MAX;
+    this->maxValue = 0;
+  }
+
+  uint64_t count() const { return this->total; }
+
+  /// The exact smallest and largest values recorded, 0 if empty
+  uint64_t min() const { return this->total == 0 ? 0 : this->minValue; }
+  uint64_t max() const { return this->maxValue; }
+
+  double mean() const {
+    return this->total == 0 ? 0 : static_cast<double>(this->sum) / this->total;
+  }
+
+  /// The number of values recorded in bucket `idx`
+  uint64_t bucketCount(size_t idx) const { return this->counts[idx]; }
+
+  /// The value at or below which `percentile` percent of the recorded values
+  /// fall, reported as the top of its bucket (and never above max()). 0 if
+  /// empty.
+  uint64_t percentile(double percentile) const {
+    if (this->total == 0) {
+      return 0;
+    }
+    double clamped = std::clamp(percentile, 0.0, 100.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(clamped / 100.0 * this->total));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t idx = 0; idx < numBuckets; idx++) {
+      seen += this->counts[idx];
+      if (seen >= rank) {
+        return std::min(bucketHighest(idx), this->maxValue);
+      }
+    }
+    return this->maxValue;
+  }
+};
+
+/// Records values from any number of threads into one logical histogram.
+///
+/// Each thread records into a shard of its own, created on its first record,
+/// so recording never contends or takes a lock: it's a bucket computation
+/// and a handful of relaxed loads and stores to memory only that thread
+/// writes. snapshot() sums the shards into a Histogram while recording
+/// carries on; a snapshot taken mid-record may be missing that record.
+///
+/// Shards outlive their threads, so counts are cumulative for the life of
+/// the recorder. Diff two snapshots' counts for an interval.
+class LatencyRecorder {
+private:
+  struct Shard {
+    // written only by the owning thread, read by snapshots
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<uint64_t> total = 0;
+    std::atomic<uint64_t> sum = 0;
+    std::atomic<uint64_t> minValue = UINT64_MAX;
+    std::atomic<uint64_t> maxValue = 0;
+
+    std::thread::id owner;
+    Shard* next = nullptr;
+
+    explicit Shard(std::thread::id owner)
+        : counts(new std::atomic<uint64_t>[Histogram::numBuckets]()), owner(owner) {}
+
+    // single writer, so a load and a store rather than a locked add
+    static inline void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+      counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+  };
+
+  // a small per-thread cache from recorder to that thread's shard. recorder
+  // ids are never reused, so entries for destroyed recorders never match.
+  struct CacheEntry {
+    uint64_t recorder = 0;
+    Shard* shard = nullptr;
+  };
+  static constexpr size_t cacheEntries = 16;
+
+  static inline std::atomic<uint64_t> nextId = 1;
+
+  uint64_t id;
+  // shards are only ever pushed, so a reader can walk the list unlocked
+  std::atomic<Shard*> shards = nullptr;
+
+  static std::array<CacheEntry, cacheEntries>& cache() {
+    thread_local std::array<CacheEntry, cacheEntries> cache{};
+    return cache;
+  }
+
+  Shard& localShard() {
+    CacheEntry& entry = cache()[this->id % cacheEntries];
+    if (entry.recorder == this->id) [[likely]] {
+      return *entry.shard;
+    }
+
+    // evicted, or this thread's first record
+    std::thread::id self = std::this_thread::get_id();
+    Shard* shard = this->shards.load(std::memory_order_acquire);
+    while (shard != nullptr && shard->owner != self) {
+      shard = shard->next;
+    }
+    if (shard == nullptr) {
+      shard = new Shard(self);
+      shard->next = this->shards.load(std::memory_order_relaxed);
+      while (!this->shards.compare_exchange_weak(shard->next, shard,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+      }
+    }
+
+    entry.recorder = this->id;
+    entry.shard = shard;
+    return *shard;
+  }
+
+public:
+  LatencyRecorder() : id(nextId.fetch_add(1, std::memory_order_relaxed)) {}
+
+  /// Must not race with record() calls, every recording thread has to be done
+  ~LatencyRecorder() {
+    Shard* shard = this->shards.load(std::memory_order_acquire);
+    while (shard != nullptr) {
+      Shard* next = shard->next;
+      delete shard;
+      shard = next;
+    }
+  }
+
+  LatencyRecorder(const LatencyRecorder&) = delete;
+  LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+  void record(uint64_t value) {
+    Shard& shard = this->localShard();
+    Shard::bump(shard.counts[Histogram::bucketIndex(value)], 1);
+    Shard::bump(shard.total, 1);
+    Shard::bump(shard.sum, value);
+    if (value < shard.minValue.load(std::memory_order_relaxed)) {
+      shard.minValue.store(value, std::memory_order_relaxed);
+    }
+    if (value > shard.maxValue.load(std::memory_order_relaxed)) {
+      shard.maxValue.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  /// The sum of every thread's recordings so far
+  Histogram snapshot() const {
+    Histogram histogram;
+    this->snapshotInto(histogram);
+    return histogram;
+  }
+
+  /// Adds every thread's recordings so far into `histogram`, which lets a
+  /// caller reuse one Histogram's memory across snapshots
+  void snapshotInto(Histogram& histogram) const {
+    Shard* shard = this->shards.load(std::memory_order_acquire);
+    for (; shard != nullptr; shard = shard->next) {
+      uint64_t shardTotal = 0;
+      for (size_t idx = 0; idx < Histogram::numBuckets; idx++) {
+        uint64_t count = shard->counts[idx].load(std::memory_order_relaxed);
+        histogram.counts[idx] += count;
+        shardTotal += count;
+      }
+      // from the buckets, so count() always agrees with them
+      histogram.total += shardTotal;
+      histogram.sum += shard->sum.load(std::memory_order_relaxed);
+      histogram.minValue = std::min(histogram.minValue,
+                                    shard->minValue.load(std::memory_order_relaxed));
+      histogram.maxValue = std::max(histogram.maxValue,
+                                    shard->maxValue.load(std::memory_order_relaxed));
+    }
+  }
+};
+
+/// Records the time from its construction to its destruction, in
+/// nanoseconds by `C`, into a LatencyRecorder
+template <Clock C = TscClock>
+class ScopedLatency {
+private:
+  LatencyRecorder& recorder;
+  uint64_t start;
+
+public:
+  explicit ScopedLatency(LatencyRecorder& recorder)
+      : recorder(recorder), start(C::nowNanos()) {}
+
+  ~ScopedLatency() {
+    uint64_t end = C::nowNanos();
+    // a counter read on another core can be a hair behind
+    this->recorder.record(end > this->start ? end - this->start : 0);
+  }
+
+  ScopedLatency(const ScopedLatency&) = delete;
+  ScopedLatency& operator=(const ScopedLatency&) = delete;
+};
+
+}; // namespace time
+}; // namespace oasis
+
+#endif // OASIS_TIME_HISTOGRAM_H
@@ -0,0 +1,299 @@
+#ifndef OASIS_TIME_WHEEL_H
+#define OASIS_TIME_WHEEL_H
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+namespace oasis {
+namespace time {
+
+class TimerWheel;
+
+/// A timer for a TimerWheel.
+///
+/// Timers are intrusive: the wheel links them into its lists in place and
+/// never allocates, so a timer must stay put (it can't be copied or moved)
+/// while it's scheduled. Typically it's a member of whatever it times out,
+/// with that object as the callback's context. Destroying a scheduled timer
+/// cancels it.
+class Timer {
+public:
+  using Callback = void (*)(Timer&, void* /* opaque context */);
+
+private:
+  friend class TimerWheel;
+
+  Timer* prev = nullptr;
+  Timer* next = nullptr;
+  TimerWheel* wheel = nullptr;
+  uint64_t deadlineTick = 0;
+  // index of the wheel list the timer is on, see TimerWheel::expiringList
+  uint16_t list = 0;
+
+  Callback callback;
+  void* ctx;
+
+  // list heads are bare nodes
+  Timer() : callback(nullptr), ctx(nullptr) {}
+
+public:
+  Timer(Callback callback, void* ctx) : callback(callback), ctx(ctx) {}
+  ~Timer();
+
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+
+  bool scheduled() const { return this->wheel != nullptr; }
+
+  /// The tick the timer is due at, only meaningful while scheduled
+  uint64_t deadline() const { return this->deadlineTick; }
+};
+
+/// A hierarchical timing wheel.
+///
+/// Time is counted in ticks of whatever length the owner picks (typically a
+/// millisecond) and only moves when the owner calls advance(), usually from
+/// a single periodic handler on its poller. Scheduling and cancelling are
+/// O(1). advance() only visits the slots the clock moved past, skipping
+/// empty ones with a bitmap per level, so its cost depends on how many
+/// timers fire or move down a level, not on how many exist.
+///
+/// There are `numLevels` levels of 64 slots. A timer sits on the level of
+/// the highest 6-bit digit in which its deadline differs from the current
+/// tick, in the slot for that digit. When the clock passes the slot its
+/// timers are either due or are moved to a lower level, so every timer
+/// moves at most `numLevels` times before it fires. Deadlines further out
+/// than the wheel's range (2^36 ticks, ~795 days of milliseconds) are parked
+/// in the top level and placed again each time it turns.
+///
+/// Not thread safe, a wheel and its timers belong to one thread.
+class TimerWheel {
+private:
+  friend class Timer;
+
+  static constexpr uint64_t levelBits = 6;
+  static constexpr uint64_t slotsPerLevel = 1 << levelBits;
+  static constexpr uint64_t slotMask = slotsPerLevel - 1;
+  static constexpr uint64_t numLevels = 6;
+  static constexpr uint64_t numSlots = numLevels * slotsPerLevel;
+  // the list timers are moved to once due, before their callbacks run
+  static constexpr uint16_t expiringList = numSlots;
+
+  // circular lists with a head node each, so linking and unlinking never
+  // branch on empty
+  Timer lists[numSlots + 1];
+  // a bit per non-empty slot, per level
+  std::array<uint64_t, numLevels> occupied{};
+
+  uint64_t currentTick;
+  size_t numScheduled = 0;
+
+  static inline bool isEmpty(const Timer& head) { return head.next == &head; }
+
+  static inline uint64_t digit(uint64_t tick, uint64_t level) {
+    return (tick >> (level * levelBits)) & slotMask;
+  }
+
+  void link(Timer& timer, uint16_t list) {
+    Timer& head = this->lists[list];
+    timer.list = list;
+    timer.prev = head.prev;
+    timer.next = &head;
+    head.prev->next = &timer;
+    head.prev = &timer;
+    if (list < numSlots) {
+      this->occupied[list / slotsPerLevel] |= 1LLU << (list % slotsPerLevel);
+    }
+  }
+
+  void unlink(Timer& timer) {
+    timer.prev->next = timer.next;
+    timer.next->prev = timer.prev;
+    timer.prev = nullptr;
+    timer.next = nullptr;
+    if (timer.list < numSlots && isEmpty(this->lists[timer.list])) {
+      this->occupied[timer.list / slotsPerLevel] &= ~(1LLU << (timer.list % slotsPerLevel));
+    }
+  }
+
+  // the slot for a deadline after the current tick
+  uint16_t slotFor(uint64_t deadline) const {
+    uint64_t level = (63 - std::countl_zero(deadline ^ this->currentTick)) / levelBits;
+    if (level < numLevels) {
+      return level * slotsPerLevel + digit(deadline, level);
+    }
+
+    const uint64_t top = numLevels - 1;
+    if (deadline - this->currentTick < (1LLU << (numLevels * levelBits))) {
+      // due within the top level's next turn, its slot comes around before
+      // the deadline
+      return top * slotsPerLevel + digit(deadline, top);
+    }
+    // out of range, park it in the top level slot the clock reaches last
+    return top * slotsPerLevel + ((digit(this->currentTick, top) - 1) & slotMask);
+  }
+
+  // moves every timer in `from` onto the expiring list or a lower slot
+  void redistribute(uint16_t from) {
+    // detach the whole list first, a parked timer can land back in the
+    // same slot
+    Timer& head = this->lists[from];
+    Timer* timer = head.next;
+    head.prev->next = nullptr;
+    head.prev = &head;
+    head.next = &head;
+    this->occupied[from / slotsPerLevel] &= ~(1LLU << (from % slotsPerLevel));
+
+    while (timer != nullptr) {
+      Timer* next = timer->next;
+      if (timer->deadlineTick <= this->currentTick) {
+        this->link(*timer, expiringList);
+      } else {
+        this->link(*timer, this->slotFor(timer->deadlineTick));
+      }
+      timer = next;
+    }
+  }
+
+public:
+  explicit TimerWheel(uint64_t nowTick) : currentTick(nowTick) {
+    for (Timer& head : this->lists) {
+      head.prev = &head;
+      head.next = &head;
+    }
+  }
+
+  /// Cancels every timer still scheduled
+  ~TimerWheel() {
+    for (Timer& head : this->lists) {
+      while (!isEmpty(head)) {
+        this->cancel(*head.next);
+      }
+    }
+  }
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  uint64_t now() const { return this->currentTick; }
+
+  size_t size() const { return this->numScheduled; }
+
+  /// Schedules `timer` to fire at `deadline`, rescheduling it if it's
+  /// already scheduled. A deadline at or before the current tick fires on
+  /// the next advance().
+  void schedule(Timer& timer, uint64_t deadline) {
+    if (timer.wheel != nullptr) {
+      timer.wheel->cancel(timer);
+    }
+    timer.wheel = this;
+    timer.deadlineTick = deadline;
+    this->numScheduled++;
+
+    if (deadline <= this->currentTick) {
+      deadline = this->currentTick + 1;
+    }
+    this->link(timer, this->slotFor(deadline));
+  }
+
+  void scheduleAfter(Timer& timer, uint64_t ticks) {
+    this->schedule(timer, this->currentTick + ticks);
+  }
+
+  /// Cancels `timer` if it's scheduled on this wheel, returning whether it was
+  bool cancel(Timer& timer) {
+    if (timer.wheel != this) {
+      return false;
+    }
+    this->unlink(timer);
+    timer.wheel = nullptr;
+    this->numScheduled--;
+    return true;
+  }
+
+  /// Moves the clock to `nowTick` and fires every timer due by then,
+  /// returning how many fired.
+  ///
+  /// Timers due within the ticks passed over fire as one batch, in no
+  /// particular order. A timer is unscheduled before its callback runs, so
+  /// callbacks are free to schedule it again or cancel other timers,
+  /// including ones in the same batch that haven't fired yet.
+  size_t advance(uint64_t nowTick) {
+    if (nowTick <= this->currentTick) {
+      nowTick = this->currentTick;
+    }
+    uint64_t previousTick = this->currentTick;
+    this->currentTick = nowTick;
+
+    for (uint64_t level = 0; level < numLevels; level++) {
+      uint64_t shift = level * levelBits;
+      uint64_t turned = (nowTick >> shift) - (previousTick >> shift);
+      if (turned == 0) {
+        // and no higher level moved either
+        break;
+      }
+
+      // the slots the clock passed at this level, after the one it was on
+      // up to and including the one it's on now
+      uint64_t passed;
+      if (turned >= slotsPerLevel) {
+        passed = ~0LLU;
+      } else {
+        passed = std::rotl((1LLU << turned) - 1, (digit(previousTick, level) + 1) & slotMask);
+      }
+
+      uint64_t pending = passed & this->occupied[level];
+      while (pending != 0) {
+        uint64_t slot = std::countr_zero(pending);
+        pending &= pending - 1;
+        this->redistribute(level * slotsPerLevel + slot);
+      }
+    }
+
+    // timers that were due before the clock moved, see schedule()
+    size_t fired = 0;
+    Timer& expiring = this->lists[expiringList];
+    while (!isEmpty(expiring)) {
+      Timer& timer = *expiring.next;
+      this->cancel(timer);
+      fired++;
+      timer.callback(timer, timer.ctx);
+    }
+    return fired;
+  }
+
+  /// The earliest tick at which advance() could fire a timer, or UINT64_MAX
+  /// if nothing is scheduled. Exact when the next timer is on the lowest
+  /// level, otherwise the tick the slot holding it is reached. Meant for
+  /// sizing a poller's wait.
+  uint64_t nextExpiry() const {
+    uint64_t next = UINT64_MAX;
+    for (uint64_t level = 0; level < numLevels; level++) {
+      if (this->occupied[level] == 0) {
+        continue;
+      }
+      // distance to the nearest occupied slot after the current one
+      uint64_t current = digit(this->currentTick, level);
+      uint64_t ahead = std::rotr(this->occupied[level], (current + 1) & slotMask);
+      uint64_t distance = std::countr_zero(ahead) + 1;
+
+      uint64_t shift = level * levelBits;
+      uint64_t reached = ((this->currentTick >> shift) + distance) << shift;
+      next = std::min(next, reached);
+    }
+    return next;
+  }
+};
+
+inline Timer::~Timer() {
+  if (this->wheel != nullptr) {
+    this->wheel->cancel(*this);
+  }
+}
+
+}; // namespace time
+}; // namespace oasis
+
+#endif // OASIS_TIME_WHEEL_H
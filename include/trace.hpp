@@ -0,0 +1,309 @@
+#ifndef OASIS_TRACE_H
+#define OASIS_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "time.hpp"
+
+namespace oasis {
+namespace trace {
+
+/// Events each thread keeps, the oldest are overwritten once it's full
+inline constexpr size_t eventsPerThread = 1 << 13;
+
+/// A traced event as collected from the buffers
+struct Event {
+  /// Static storage, typically a string literal
+  const char* name;
+  uint64_t startNanos;
+  /// instantEvent for events without a duration
+  uint64_t durationNanos;
+  /// A number attached to the event, such as a byte count
+  uint64_t arg;
+  /// The index of the recording thread, in order of first event
+  uint32_t thread;
+};
+
+inline constexpr uint64_t instantEvent = UINT64_MAX;
+
+namespace detail {
+inline std::atomic<bool> enabled = false;
+
+// a single producer ring of fixed size events, readable while it's written.
+// each field is a relaxed atomic, which costs the writer nothing over plain
+// stores. before overwriting a slot the writer announces it in `claimed`,
+// so a reader can tell which of the slots it copied may be torn, the
+// seqlock way.
+struct alignas(cacheLineSize) ThreadBuffer {
+  struct Slot {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> startNanos;
+    std::atomic<uint64_t> durationNanos;
+    std::atomic<uint64_t> arg;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  std::atomic<uint64_t> head = 0;
+  std::atomic<uint64_t> claimed = 0;
+
+  // the rest belongs to the registry, and is guarded by its lock
+  uint32_t thread;
+  std::string threadName;
+  // events before this are cleared
+  uint64_t exportFrom = 0;
+  bool exited = false;
+
+  explicit ThreadBuffer(uint32_t thread)
+      : slots(new Slot[eventsPerThread]()), thread(thread) {}
+
+  void write(const char* name, uint64_t startNanos, uint64_t durationNanos, uint64_t arg) {
+    uint64_t idx = this->head.load(std::memory_order_relaxed);
+    this->claimed.store(idx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Slot& slot = this->slots[idx % eventsPerThread];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNanos.store(startNanos, std::memory_order_relaxed);
+    slot.durationNanos.store(durationNanos, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    this->head.store(idx + 1, std::memory_order_release);
+  }
+
+  void collect(std::vector<Event>& out) const {
+    uint64_t end = this->head.load(std::memory_order_acquire);
+    uint64_t begin = std::max(this->exportFrom, end > eventsPerThread ? end - eventsPerThread : 0);
+    size_t first = out.size();
+    for (uint64_t idx = begin; idx < end; idx++) {
+      const Slot& slot = this->slots[idx % eventsPerThread];
+      out.push_back(Event{
+        .name = slot.name.load(std::memory_order_relaxed),
+        .startNanos = slot.startNanos.load(std::memory_order_relaxed),
+        .durationNanos = slot.durationNanos.load(std::memory_order_relaxed),
+        .arg = slot.arg.load(std::memory_order_relaxed),
+        .thread = this->thread,
+      });
+    }
+
+    // drop whatever the writer lapped while we were copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t claimed = this->claimed.load(std::memory_order_relaxed);
+    if (claimed > begin + eventsPerThread) {
+      size_t torn = std::min(claimed - eventsPerThread - begin, end - begin);
+      out.erase(out.begin() + first, out.begin() + first + torn);
+    }
+  }
+};
+
+struct Registry {
+  std::mutex lock;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  uint32_t nextThread = 0;
+};
+
+inline Registry& registry() {
+  static Registry registry;
+  return registry;
+}
+
+// trivially destructible, so the hot path reads it without a TLS guard
+inline thread_local ThreadBuffer* localBuffer = nullptr;
+
+// marks the thread's buffer exited when the thread ends
+struct ThreadExit {
+  ~ThreadExit() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    if (localBuffer != nullptr) {
+      localBuffer->exited = true;
+      localBuffer = nullptr;
+    }
+  }
+};
+
+inline ThreadBuffer& registerThread() {
+  thread_local ThreadExit exit;
+  Registry& r = registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  r.buffers.push_back(std::make_unique<ThreadBuffer>(r.nextThread++));
+  localBuffer = r.buffers.back().get();
+  return *localBuffer;
+}
+
+inline ThreadBuffer& buffer() {
+  ThreadBuffer* buffer = localBuffer;
+  if (buffer != nullptr) [[likely]] {
+    return *buffer;
+  }
+  return registerThread();
+}
+
+inline void writeEscaped(std::ostream& out, std::string_view str) {
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out << ' ';
+    } else {
+      out << c;
+    }
+  }
+}
+
+// nanoseconds as microseconds with three decimals, exactly
+inline void writeMicros(std::ostream& out, uint64_t nanos) {
+  char frac[4] = {
+    static_cast<char>('0' + nanos / 100 % 10),
+    static_cast<char>('0' + nanos / 10 % 10),
+    static_cast<char>('0' + nanos % 10),
+    '\0',
+  };
+  out << nanos / 1'000 << '.' << frac;
+}
+}; // namespace detail
+
+/// Tracing is off until enabled, and while it's off a span or an instant
+/// costs a relaxed load and a branch.
+///
+/// The first enable() in a process blocks while time::TscClock calibrates,
+/// up to TscClock::calibrationNanos, so that the first traced event doesn't
+/// stall whichever thread records it instead.
+inline void enable() {
+  time::TscClock::calibrate();
+  detail::enabled.store(true, std::memory_order_relaxed);
+}
+inline void disable() { detail::enabled.store(false, std::memory_order_relaxed); }
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+/// Records an event without a duration
+inline void instant(const char* name, uint64_t arg = 0) {
+  if (!enabled()) [[likely]] {
+    return;
+  }
+  detail::buffer().write(name, time::TscClock::nowNanos(), instantEvent, arg);
+}
+
+/// Records the time from its construction to its destruction as an event.
+///
+/// Events go into a ring buffer of the recording thread's, without locks or
+/// allocation (bar the thread's first event, which allocates its buffer).
+/// Timestamps come from time::TscClock. `name` isn't copied, it must outlive the
+/// trace, as string literals do.
+class Span {
+private:
+  const char* name;
+  uint64_t start;
+  uint64_t arg = 0;
+
+public:
+  explicit Span(const char* name) {
+    if (!enabled()) [[likely]] {
+      this->name = nullptr;
+      return;
+    }
+    this->name = name;
+    this->start = time::TscClock::nowNanos();
+  }
+
+  ~Span() {
+    if (this->name == nullptr) [[likely]] {
+      return;
+    }
+    uint64_t end = time::TscClock::nowNanos();
+    detail::buffer().write(this->name, this->start, end > this->start ? end - this->start : 0,
+                           this->arg);
+  }
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  /// Sets the number recorded with the event, e.g. once a byte count is known
+  void setArg(uint64_t arg) { this->arg = arg; }
+};
+
+/// Names the calling thread in exported traces
+inline void setThreadName(std::string name) {
+  detail::ThreadBuffer& buffer = detail::buffer();
+  std::lock_guard<std::mutex> guard(detail::registry().lock);
+  buffer.threadName = std::move(name);
+}
+
+/// Every event still in a buffer, thread by thread, oldest first. Safe to call
+/// while threads are recording, an event recorded meanwhile may be missed.
+inline std::vector<Event> collect() {
+  detail::Registry& r = detail::registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  std::vector<Event> events;
+  for (const auto& buffer : r.buffers) {
+    buffer->collect(events);
+  }
+  return events;
+}
+
+/// Discards every event recorded so far, and the buffers of threads that
+/// have exited
+inline void clear() {
+  detail::Registry& r = detail::registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+  std::erase_if(r.buffers, [](const auto& buffer) { return buffer->exited; });
+  for (const auto& buffer : r.buffers) {
+    buffer->exportFrom = buffer->head.load(std::memory_order_acquire);
+  }
+}
+
+/// Writes every event still in a buffer as Chrome trace event JSON, which
+/// chrome://tracing and the Perfetto UI both open
+inline void writeChromeJson(std::ostream& out) {
+  detail::Registry& r = detail::registry();
+  std::lock_guard<std::mutex> guard(r.lock);
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&]() {
+    if (!first) {
+      out << ",";
+    }
+    first = false;
+  };
+
+  std::vector<Event> events;
+  for (const auto& buffer : r.buffers) {
+    if (!buffer->threadName.empty()) {
+      separate();
+      out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread
+          << ",\"args\":{\"name\":\"";
+      detail::writeEscaped(out, buffer->threadName);
+      out << "\"}}";
+    }
+
+    events.clear();
+    buffer->collect(events);
+    for (const Event& event : events) {
+      separate();
+      out << "\n{\"name\":\"";
+      detail::writeEscaped(out, event.name);
+      out << "\",\"cat\":\"oasis\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":";
+      detail::writeMicros(out, event.startNanos);
+      if (event.durationNanos == instantEvent) {
+        out << ",\"ph\":\"i\",\"s\":\"t\"";
+      } else {
+        out << ",\"ph\":\"X\",\"dur\":";
+        detail::writeMicros(out, event.durationNanos);
+      }
+      out << ",\"args\":{\"arg\":" << event.arg << "}}";
+    }
+  }
+  out << "\n]}\n";
+}
+
+}; // namespace trace
+}; // namespace oasis
+
+#endif // OASIS_TRACE_H
@@ -1,8 +1,30 @@
 #ifndef OASIS_UTILS_H
 #define OASIS_UTILS_H
 
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 namespace oasis {
 
+// size of a cache line, for keeping data written by one thread off the lines
+// other threads read. std::hardware_destructive_interference_size would be the
+// standard spelling, but its value isn't stable across compiler flags, which
+// makes it unsafe to use in a header.
+inline constexpr std::size_t cacheLineSize = 64;
+
+// tells the CPU we're in a spin-wait loop, so it backs off the memory
+// pipeline (and lets a hyperthread sibling run) until the next iteration
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
 // Overload pattern for using std::visit with std:variant, introducing a way to
 // provide a variable number of lambdas that take different parameter types. the
 // one that matches the underlying type of the std::variant will be called. there
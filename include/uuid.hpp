@@ -1,18 +1,51 @@
 #ifndef OASIS_UUID_H
 #define OASIS_UUID_H
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <compare>
 #include <cstdint>
-#include <iomanip>
+#include <cstring>
+#include <expected>
 #include <ostream>
 #include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <pthread.h>
 
 #include "time.hpp"
+#include "uuid/chacha.hpp"
+#include "uuid/hex.hpp"
 
 namespace oasis {
 namespace uuid {
 /// Universally Unique IDentifiers
 ///
 /// https://datatracker.ietf.org/doc/html/rfc9562
+enum class UuidParseError {
+  InvalidLength,
+  MissingSeparator,
+  InvalidHexDigit,
+};
+
+/// Where and why a string passed to parseMany failed to parse
+struct UuidParseFailure {
+  size_t index;
+  UuidParseError error;
+};
+
+class UuidV7Generator;
+class UuidV4Generator;
+class UuidBloomFilter;
+
+namespace detail {
+class UuidRadixSorter;
+}; // namespace detail
+
 class Uuid {
 private:
   uint64_t lo;
@@ -20,16 +53,68 @@ private:
 
   // bits 0 - 48
   static const uint64_t timestampMask = 0x0000'FFFF'FFFF'FFFFLLU;
+  // bits 48 - 51, set to 0b0111 (7)
+  static const uint64_t versionMask = 0b0111LLU << 48;
+  // bits 48 - 51
+  static const uint64_t versionClearMask = 0b1111LLU << 48;
+  // bits 48 - 51, set to 0b0100 (4)
+  static const uint64_t version4Mask = 0b0100LLU << 48;
+  // bits 52 - 63
+  static const uint64_t randAMask = 0xFFF0'0000'0000'0000LLU;
+  // bits 64 - 65, set to 0b10
+  static const uint64_t varClearMask = 0b11LLU;
+  // bits 64 - 65, set to 0b10
+  static const uint64_t varMask = 0b10LLU;
 
   Uuid(uint64_t lo, uint64_t hi) : lo(lo), hi(hi) {};
 
-  // allow our overload to access internals
-  friend std::ostream& operator<<(std::ostream&, const Uuid&);
+  // the 16 bytes in the order their hex digits appear in the string form. the
+  // five groups of digits are lo bits 0 - 31, lo bits 32 - 47, lo bits
+  // 48 - 63, hi bits 0 - 15 and hi bits 16 - 63, each most significant first
+  inline void toDisplayBytes(uint8_t* out) const {
+    uint64_t first = (this->lo << 32)
+      | (((this->lo >> 32) & 0xFFFF) << 16)
+      | (this->lo >> 48);
+    uint64_t second = (this->hi >> 16) | (this->hi << 48);
+    detail::storeBigEndian(first, out);
+    detail::storeBigEndian(second, out + 8);
+  }
+
+  static inline Uuid fromDisplayBytes(const uint8_t* in) {
+    uint64_t first = detail::loadBigEndian(in);
+    uint64_t second = detail::loadBigEndian(in + 8);
+    uint64_t lo = (first >> 32)
+      | ((first & 0xFFFF) << 48)
+      | (((first >> 16) & 0xFFFF) << 32);
+    uint64_t hi = (second << 16) | (second >> 48);
+    return Uuid(lo, hi);
+  }
+
+  // generators assemble ids directly from their bit fields
+  friend class UuidV7Generator;
+  friend class UuidV4Generator;
+
+  // the columnar codec splits ids into their fields
+  friend class UuidV7Column;
+
+  // radix sorting works on the bytes of the ordering key
+  friend class detail::UuidRadixSorter;
+
+  // the bloom filter takes its bits from the random fields instead of hashing
+  friend class UuidBloomFilter;
 
-  // allow our overload to access internals
-  friend struct std::hash<Uuid>; // friend the class, not the member function
+  // the most significant half of the ordering key, see operator<=>
+  inline uint64_t orderingHi() const { return std::rotl(this->lo, 16); }
+
+  // batch conversions work on display bytes directly
+  friend void toCharsMany(std::span<const Uuid>, std::span<char>);
+  friend size_t parseMany(std::span<const std::string_view>, std::span<Uuid>,
+                          std::vector<UuidParseFailure>&);
 
 public:
+  /// The nil UUID, all 128 bits set to zero
+  Uuid() : lo(0), hi(0) {};
+
   //  0                   1                   2                   3
   //  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
   // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -41,36 +126,67 @@ public:
   // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   // |                            rand_b                             |
   // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  static Uuid v7() {
-    // bits 48 - 51, set to 0b0111 (7)
-    static const uint64_t versionMask = 0b0111LLU << 48;
-    // bits 52 - 63
-    static const uint64_t randAMask = 0xFFF0'0000'0000'0000LLU;
-    // bits 64 - 65, set to 0b10
-    static const uint64_t varClearMask = 0b11LLU;
-    // bits 64 - 65, set to 0b10
-    static const uint64_t varMask = 0b10LLU;
+  //
+  // ids are produced by the calling thread's UuidV7Generator, so ids created
+  // on the same thread are strictly increasing, even within a millisecond.
+  // the timestamp is read from `C`, see time::WallClock.
+  template <time::WallClock C = time::RealtimeClock>
+  static Uuid v7();
 
-    std::random_device rd;
-    std::mt19937_64 mt(rd());
+  // fills `out` with ids from the calling thread's UuidV7Generator, in
+  // increasing order. much cheaper per id than calling v7() in a loop.
+  template <time::WallClock C = time::RealtimeClock>
+  static void v7Batch(std::span<Uuid> out);
 
-    uint64_t lo = time::millisSinceEpoch();
-    // clear the upper 16 bits of timestamp so we can use it as lo
-    lo &= timestampMask;
-    lo |= versionMask;
+  // version 4, every bit but the version and variant is random. ids come from
+  // the calling thread's UuidV4Generator, a ChaCha20 keystream, so they can't
+  // be predicted from ids seen before.
+  static Uuid v4();
 
-    uint64_t randA = mt();
-    randA &= randAMask;
+  // fills `out` with ids from the calling thread's UuidV4Generator
+  static void v4Batch(std::span<Uuid> out);
 
-    lo |= randA;
-    
-    uint64_t hi = mt();
-    hi &= ~varClearMask;
-    hi |= varMask;
+  /// Length of the string form, see operator<<
+  static constexpr size_t stringLength = 36;
 
-    return Uuid(lo, hi);
+  /// Writes the string form (lowercase hex), without a trailing NUL
+  void toChars(char (&out)[stringLength]) const {
+    uint8_t bytes[16];
+    char digits[32];
+    this->toDisplayBytes(bytes);
+    detail::encodeHex(bytes, digits);
+    detail::insertDashes(digits, out);
   }
 
+  /// Parses the string form, accepting upper and lowercase hex digits
+  static std::expected<Uuid, UuidParseError> fromChars(std::string_view str) {
+    if (str.size() != stringLength) {
+      return std::unexpected(UuidParseError::InvalidLength);
+    }
+
+    char digits[32];
+    if (!detail::removeDashes(str.data(), digits)) {
+      return std::unexpected(UuidParseError::MissingSeparator);
+    }
+
+    uint8_t bytes[16];
+    if (!detail::decodeHex(digits, bytes)) {
+      return std::unexpected(UuidParseError::InvalidHexDigit);
+    }
+
+    return fromDisplayBytes(bytes);
+  }
+
+  /// The `unix_ts_ms` field, only meaningful for v7 ids
+  uint64_t timestampMillis() const { return this->lo & timestampMask; }
+
+  /// The `ver` field
+  uint8_t version() const { return (this->lo >> 48) & 0b1111; }
+
+  /// A 64-bit hash in which every output bit depends on all 128 input bits.
+  /// v7 ids share most of their timestamp bits, so anything weaker clusters.
+  uint64_t hash() const;
+
   inline bool operator==(const Uuid& rhs) const {
     return this->lo == rhs.lo && this->hi == rhs.hi;
   }
@@ -78,8 +194,402 @@ public:
   inline bool operator!=(const Uuid& rhs) const {
     return !operator==(rhs);
   }
+
+  /// Orders by timestamp, then rand_a, then the version, then rand_b, then
+  /// the variant bits. For v7 ids the version is the same everywhere, so
+  /// that's creation order, including ids from the same millisecond on the
+  /// same thread. Every uuid takes part in the same total order, v7 or not.
+  ///
+  /// Note the string form is not sorted the same way, its first group holds
+  /// the low bits of the timestamp.
+  inline std::strong_ordering operator<=>(const Uuid& rhs) const {
+    if (auto cmp = this->orderingHi() <=> rhs.orderingHi(); cmp != 0) {
+      return cmp;
+    }
+    return this->hi <=> rhs.hi;
+  }
+};
+
+namespace detail {
+// splitmix64, used to expand a single seed into a full xoshiro state
+//
+// https://prng.di.unimi.it/splitmix64.c
+inline uint64_t splitmix64(uint64_t& state) {
+  uint64_t z = (state += 0x9E37'79B9'7F4A'7C15LLU);
+  z = (z ^ (z >> 30)) * 0xBF58'476D'1CE4'E5B9LLU;
+  z = (z ^ (z >> 27)) * 0x94D0'49BB'1331'11EBLLU;
+  return z ^ (z >> 31);
+}
+
+// xoshiro256**, a small, fast, non-cryptographic generator. unlike
+// std::mt19937_64 its state is 32 bytes, so it's cheap to keep per thread.
+//
+// https://prng.di.unimi.it/xoshiro256starstar.c
+class Xoshiro256 {
+private:
+  uint64_t s[4];
+
+  static inline uint64_t rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+public:
+  explicit Xoshiro256(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+      this->s[i] = splitmix64(seed);
+    }
+  }
+
+  inline uint64_t operator()() {
+    const uint64_t result = rotl(this->s[1] * 5, 7) * 9;
+    const uint64_t t = this->s[1] << 17;
+
+    this->s[2] ^= this->s[0];
+    this->s[3] ^= this->s[1];
+    this->s[1] ^= this->s[2];
+    this->s[0] ^= this->s[3];
+    this->s[2] ^= t;
+    this->s[3] = rotl(this->s[3], 45);
+
+    return result;
+  }
+};
+
+// four independent xoshiro256** streams, stored lane-wise so each step is a
+// handful of 4-wide vector ops. the multiplies by 5 and 9 are spelled as
+// shift+add since there's no 64-bit vector multiply before AVX-512.
+class Xoshiro256x4 {
+private:
+  static const size_t lanes = 4;
+
+  uint64_t s0[lanes];
+  uint64_t s1[lanes];
+  uint64_t s2[lanes];
+  uint64_t s3[lanes];
+
+public:
+  explicit Xoshiro256x4(uint64_t seed) {
+    for (size_t l = 0; l < lanes; l++) {
+      this->s0[l] = splitmix64(seed);
+      this->s1[l] = splitmix64(seed);
+      this->s2[l] = splitmix64(seed);
+      this->s3[l] = splitmix64(seed);
+    }
+  }
+
+  // fills out[0, n) with random words, n is rounded up to a multiple of 4 so
+  // `out` must have room for that many
+  void fill(uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i += lanes) {
+      for (size_t l = 0; l < lanes; l++) {
+        uint64_t x = this->s1[l] + (this->s1[l] << 2);
+        x = (x << 7) | (x >> 57);
+        out[i + l] = x + (x << 3);
+
+        const uint64_t t = this->s1[l] << 17;
+        this->s2[l] ^= this->s0[l];
+        this->s3[l] ^= this->s1[l];
+        this->s1[l] ^= this->s2[l];
+        this->s0[l] ^= this->s3[l];
+        this->s2[l] ^= t;
+        this->s3[l] = (this->s3[l] << 45) | (this->s3[l] >> 19);
+      }
+    }
+  }
+};
+
+// multiplies into 128 bits and folds the halves together, the core of the
+// wyhash/rapidhash family of mixers
+inline uint64_t foldedMultiply(uint64_t a, uint64_t b) {
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t mix128(uint64_t lo, uint64_t hi) {
+  uint64_t h = foldedMultiply(lo ^ 0xA076'1D64'78BD'642FLLU, 0xE703'7ED1'A0B4'28DBLLU);
+  return foldedMultiply(h ^ hi, 0x8EBC'6AF0'9C88'C6E3LLU);
+}
+
+inline uint64_t seedFromRandomDevice() {
+  std::random_device rd;
+  return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
+// bumped in the child after every fork(), which copies every generator's
+// state along with the rest of memory
+inline std::atomic<uint64_t> forkGeneration = 0;
+
+inline const bool forkHandlerInstalled = []() {
+  pthread_atfork(nullptr, nullptr, []() {
+    forkGeneration.fetch_add(1, std::memory_order_relaxed);
+  });
+  return true;
+}();
+}; // namespace detail
+
+/// Generates monotonic v7 UUIDs.
+///
+/// Uses RFC 9562 section 6.2, method 1 (fixed-length dedicated counter). The
+/// counter is 42 bits wide and occupies `rand_a` followed by the top 30 bits
+/// of `rand_b`; the remaining 32 bits of `rand_b` are random for every id.
+/// On each new millisecond the counter is reseeded randomly with its top bit
+/// cleared, leaving at least 2^41 increments before it can roll over. If it
+/// does roll over (or the clock goes backwards), the timestamp is advanced
+/// past the wall clock instead so ordering is never violated.
+///
+/// The random state is drawn again in the child after a fork(), so parent
+/// and child don't produce the same ids.
+///
+/// A generator is not thread safe; `local()` returns the calling thread's.
+class UuidV7Generator {
+private:
+  static const uint64_t counterBits = 42;
+  static const uint64_t counterMax = (1LLU << counterBits) - 1;
+  // the most significant counter bit is cleared on reseed, guarding rollover
+  static const uint64_t counterSeedMask = counterMax >> 1;
+
+  // counter bits that spill over into rand_b
+  static const uint64_t counterLoBits = 30;
+  static const uint64_t counterLoMask = (1LLU << counterLoBits) - 1;
+  // bits 66 - 97, the random tail of rand_b that sits below the counter
+  static const uint64_t randBMask = 0x0000'0003'FFFF'FFFCLLU;
+
+  // ids per clock read in fill(), a multiple of 4 for the wide generator
+  static constexpr size_t blockSize = 1024;
+
+  detail::Xoshiro256 rng;
+  detail::Xoshiro256x4 wideRng;
+  uint64_t lastMillis = 0;
+  uint64_t counter = 0;
+  uint64_t forkGeneration;
+
+public:
+  UuidV7Generator() : UuidV7Generator(detail::seedFromRandomDevice()) {}
+
+  /// A generator with a fixed seed, for reproducible output. It is still
+  /// reseeded after a fork().
+  explicit UuidV7Generator(uint64_t seed)
+      : rng(seed), wideRng(~seed),
+        forkGeneration(detail::forkGeneration.load(std::memory_order_relaxed)) {}
+
+  /// The generator owned by the calling thread, created on first use
+  static UuidV7Generator& local() {
+    thread_local UuidV7Generator generator;
+    return generator;
+  }
+
+  /// The next id, timestamped by the wall clock `C`. Clocks can be mixed
+  /// freely, a clock behind the last timestamp is handled like any other
+  /// backwards step.
+  template <time::WallClock C = time::RealtimeClock>
+  Uuid next() {
+    this->reseedAfterFork();
+    this->tick(time::millisSinceEpoch<C>());
+    return this->assemble(this->rng());
+  }
+
+  /// Fills `out` with increasing ids.
+  ///
+  /// The clock is read once per block of `blockSize` ids rather than once per
+  /// id, and the random bits for a block come from a 4-lane generator.
+  template <time::WallClock C = time::RealtimeClock>
+  void fill(std::span<Uuid> out) {
+    uint64_t randBits[blockSize];
+    this->reseedAfterFork();
+
+    size_t idx = 0;
+    while (idx < out.size()) {
+      size_t n = std::min(blockSize, out.size() - idx);
+      this->wideRng.fill(randBits, n);
+
+      this->tick(time::millisSinceEpoch<C>());
+      out[idx] = this->assemble(randBits[0]);
+      for (size_t i = 1; i < n; i++) {
+        this->tick(this->lastMillis);
+        out[idx + i] = this->assemble(randBits[i]);
+      }
+
+      idx += n;
+    }
+  }
+
+private:
+  // a fork() child inherits the random state along with the rest of memory,
+  // so it would hand out the parent's ids for the rest of the millisecond.
+  // the counter carries on as it was, to stay monotonic past the ids made
+  // before the fork, the random bits below it and later reseeds now differ
+  inline void reseedAfterFork() {
+    uint64_t generation = detail::forkGeneration.load(std::memory_order_relaxed);
+    if (generation != this->forkGeneration) [[unlikely]] {
+      uint64_t seed = detail::seedFromRandomDevice();
+      this->rng = detail::Xoshiro256(seed);
+      this->wideRng = detail::Xoshiro256x4(~seed);
+      this->forkGeneration = generation;
+    }
+  }
+
+  // advances the (timestamp, counter) pair given the current wall clock
+  inline void tick(uint64_t now) {
+    if (now > this->lastMillis) {
+      this->lastMillis = now;
+      this->counter = this->rng() & counterSeedMask;
+    } else if (this->counter < counterMax) {
+      this->counter++;
+    } else {
+      // counter exhausted for this millisecond, borrow from the next one
+      this->lastMillis++;
+      this->counter = this->rng() & counterSeedMask;
+    }
+  }
+
+  inline Uuid assemble(uint64_t randBits) const {
+    uint64_t lo = this->lastMillis & Uuid::timestampMask;
+    lo |= Uuid::versionMask;
+    lo |= ((this->counter >> counterLoBits) << 52) & Uuid::randAMask;
+
+    uint64_t hi = (this->counter & counterLoMask) << 34;
+    hi |= randBits & randBMask;
+    hi |= Uuid::varMask;
+
+    return Uuid(lo, hi);
+  }
 };
 
+/// Generates v4 UUIDs from a ChaCha20 keystream.
+///
+/// The 122 random bits of each id are taken straight from the keystream, 16
+/// bytes per id. The keystream is made `bufferBlocks` blocks at a time (8 at
+/// once with AVX2) using fast key erasure: the first 32 bytes of every refill
+/// become the next key and are never handed out, and buffered bytes are
+/// wiped as they're used. Recovering a generator's state therefore reveals
+/// nothing about ids it already produced.
+///
+/// The key comes from std::random_device, and is drawn again in the child
+/// after a fork() so parent and child don't produce the same ids.
+///
+/// A generator is not thread safe; `local()` returns the calling thread's.
+class UuidV4Generator {
+private:
+  static constexpr size_t bufferBlocks = 16;
+  static constexpr size_t bufferWords = bufferBlocks * detail::chachaBlockWords;
+  static constexpr size_t wordsPerId = 4;
+  // ids per refill, after the words that become the next key
+  static constexpr size_t idsPerRefill =
+    (bufferWords - detail::chachaKeyWords) / wordsPerId;
+
+  uint32_t key[detail::chachaKeyWords];
+  uint32_t buffer[bufferWords];
+  // ids in the buffer before this one have been handed out
+  size_t nextId = idsPerRefill;
+  uint64_t forkGeneration;
+
+public:
+  UuidV4Generator() {
+    this->seed();
+  }
+
+  /// A generator with a fixed key, for reproducible output. It is still
+  /// rekeyed after a fork().
+  explicit UuidV4Generator(const uint32_t (&key)[detail::chachaKeyWords])
+      : forkGeneration(detail::forkGeneration.load(std::memory_order_relaxed)) {
+    std::copy(key, key + detail::chachaKeyWords, this->key);
+  }
+
+  /// The generator owned by the calling thread, created on first use
+  static UuidV4Generator& local() {
+    thread_local UuidV4Generator generator;
+    return generator;
+  }
+
+  Uuid next() {
+    this->ensureIds();
+    uint32_t* words = this->idWords(this->nextId++);
+    Uuid uuid = assemble(words);
+    std::memset(words, 0, wordsPerId * sizeof(uint32_t));
+    return uuid;
+  }
+
+  void fill(std::span<Uuid> out) {
+    size_t idx = 0;
+    while (idx < out.size()) {
+      this->ensureIds();
+
+      size_t n = std::min(idsPerRefill - this->nextId, out.size() - idx);
+      uint32_t* words = this->idWords(this->nextId);
+      for (size_t i = 0; i < n; i++) {
+        out[idx + i] = assemble(words + i * wordsPerId);
+      }
+      std::memset(words, 0, n * wordsPerId * sizeof(uint32_t));
+
+      this->nextId += n;
+      idx += n;
+    }
+  }
+
+private:
+  void seed() {
+    std::random_device rd;
+    for (uint32_t& word : this->key) {
+      word = rd();
+    }
+    this->forkGeneration = detail::forkGeneration.load(std::memory_order_relaxed);
+  }
+
+  // refills if the buffer is used up, or was inherited across a fork()
+  inline void ensureIds() {
+    uint64_t generation = detail::forkGeneration.load(std::memory_order_relaxed);
+    if (generation != this->forkGeneration) {
+      this->seed();
+      this->refill();
+    } else if (this->nextId == idsPerRefill) {
+      this->refill();
+    }
+  }
+
+  void refill() {
+
+    // every refill is under a new key, so the counter and nonce stay at 0
+    detail::chachaBlocks(this->key, 0, 0, this->buffer, bufferBlocks);
+    std::copy(this->buffer, this->buffer + detail::chachaKeyWords, this->key);
+    std::memset(this->buffer, 0, detail::chachaKeyWords * sizeof(uint32_t));
+    this->nextId = 0;
+  }
+
+  inline uint32_t* idWords(size_t id) {
+    return this->buffer + detail::chachaKeyWords + id * wordsPerId;
+  }
+
+  static inline Uuid assemble(const uint32_t* words) {
+    uint64_t lo = words[0] | (static_cast<uint64_t>(words[1]) << 32);
+    uint64_t hi = words[2] | (static_cast<uint64_t>(words[3]) << 32);
+    lo = (lo & ~Uuid::versionClearMask) | Uuid::version4Mask;
+    hi = (hi & ~Uuid::varClearMask) | Uuid::varMask;
+    return Uuid(lo, hi);
+  }
+};
+
+inline uint64_t Uuid::hash() const {
+  return detail::mix128(this->lo, this->hi);
+}
+
+template <time::WallClock C>
+inline Uuid Uuid::v7() {
+  return UuidV7Generator::local().next<C>();
+}
+
+template <time::WallClock C>
+inline void Uuid::v7Batch(std::span<Uuid> out) {
+  UuidV7Generator::local().fill<C>(out);
+}
+
+inline Uuid Uuid::v4() {
+  return UuidV4Generator::local().next();
+}
+
+inline void Uuid::v4Batch(std::span<Uuid> out) {
+  UuidV4Generator::local().fill(out);
+}
+
 /// The formal definition of the UUID string representation is provided by the following ABNF [RFC5234]:
 /// UUID     = 4hexOctet "-"
 ///            2hexOctet "-"
@@ -91,20 +601,106 @@ public:
 /// HEXDIG   = DIGIT / "A" / "B" / "C" / "D" / "E" / "F"
 ///
 /// ex: f81d4fae-7dec-11d0-a765-00a0c91e6bf6
-std::ostream& operator<<(std::ostream& os, const Uuid& uuid)
-{
-  auto first = uuid.lo & 0x0000'0000'FFFF'FFFFLLU;
-  auto second = (uuid.lo & 0x0000'FFFF'0000'0000LLU) >> 32;
-  auto third = (uuid.lo & 0xFFFF'0000'0000'0000LLU) >> 48;
-  auto fourth = uuid.hi & 0x0000'0000'0000'FFFFLLU;
-  auto fifth = (uuid.hi & 0xFFFF'FFFF'FFFF'0000LLU) >> 16;
-
-  return os << std::hex
-    << std::setw(8) << std::setfill('0') << first << "-"
-    << std::setw(4) << std::setfill('0') << second << "-"
-    << std::setw(4) << std::setfill('0') << third << "-" 
-    << std::setw(4) << std::setfill('0') << fourth << "-"
-    << std::setw(12) << std::setfill('0') << fifth;
+inline std::ostream& operator<<(std::ostream& os, const Uuid& uuid) {
+  char str[Uuid::stringLength];
+  uuid.toChars(str);
+  return os.write(str, Uuid::stringLength);
+}
+
+/// Writes the string forms of `uuids` back to back into `out`, which must hold
+/// at least `Uuid::stringLength * uuids.size()` chars
+inline void toCharsMany(std::span<const Uuid> uuids, std::span<char> out) {
+  assert(out.size() >= Uuid::stringLength * uuids.size());
+
+  char* dst = out.data();
+  size_t idx = 0;
+#if defined(__AVX2__)
+  for (; idx + 2 <= uuids.size(); idx += 2) {
+    uint8_t bytes[32];
+    char digits[64];
+    uuids[idx].toDisplayBytes(bytes);
+    uuids[idx + 1].toDisplayBytes(bytes + 16);
+    detail::encodeHexAvx2x2(bytes, digits);
+    detail::insertDashes(digits, dst);
+    detail::insertDashes(digits + 32, dst + Uuid::stringLength);
+    dst += 2 * Uuid::stringLength;
+  }
+#endif
+  for (; idx < uuids.size(); idx++) {
+    uint8_t bytes[16];
+    char digits[32];
+    uuids[idx].toDisplayBytes(bytes);
+    detail::encodeHex(bytes, digits);
+    detail::insertDashes(digits, dst);
+    dst += Uuid::stringLength;
+  }
+}
+
+/// Parses back to back string forms from `in` into `out`, stopping at the
+/// first invalid one. Returns how many uuids were parsed.
+inline size_t fromCharsMany(std::span<const char> in, std::span<Uuid> out) {
+  size_t count = std::min(in.size() / Uuid::stringLength, out.size());
+  for (size_t idx = 0; idx < count; idx++) {
+    std::string_view str(in.data() + idx * Uuid::stringLength, Uuid::stringLength);
+    std::expected<Uuid, UuidParseError> uuid = Uuid::fromChars(str);
+    if (!uuid.has_value()) {
+      return idx;
+    }
+    out[idx] = uuid.value();
+  }
+  return count;
+}
+
+/// Parses `strs[i]` into `out[i]`, which must be at least as large as `strs`.
+///
+/// Strings are handled in blocks: each block's dashes are stripped, then all
+/// of its hex digits are validated and decoded together (two uuids per
+/// vector op with AVX2), so valid input never branches per uuid. Any string
+/// that fails leaves the nil uuid in its slot and appends a UuidParseFailure
+/// to `failures`, in index order. Returns the number of uuids parsed.
+inline size_t parseMany(std::span<const std::string_view> strs,
+                        std::span<Uuid> out,
+                        std::vector<UuidParseFailure>& failures) {
+  assert(out.size() >= strs.size());
+
+  static const size_t blockSize = 16;
+  char digits[blockSize * 32];
+  uint8_t bytes[blockSize * 16];
+
+  size_t parsed = 0;
+  for (size_t base = 0; base < strs.size(); base += blockSize) {
+    size_t n = std::min(blockSize, strs.size() - base);
+
+    uint32_t structureOk = 0;
+    for (size_t i = 0; i < n; i++) {
+      const std::string_view& str = strs[base + i];
+      if (str.size() == Uuid::stringLength) {
+        bool dashes = detail::removeDashes(str.data(), digits + 32 * i);
+        structureOk |= static_cast<uint32_t>(dashes) << i;
+      } else {
+        // keep the decode below well defined, this slot is failed regardless
+        std::memset(digits + 32 * i, '0', 32);
+      }
+    }
+
+    uint32_t ok = structureOk & detail::decodeHexMany(digits, bytes, n);
+    for (size_t i = 0; i < n; i++) {
+      out[base + i] = Uuid::fromDisplayBytes(bytes + 16 * i);
+    }
+
+    uint32_t failed = ~ok & ((1u << n) - 1);
+    parsed += n - std::popcount(failed);
+    while (failed != 0) {
+      size_t i = std::countr_zero(failed);
+      failed &= failed - 1;
+
+      // rare path, rerun the single parser to find out what was wrong
+      failures.push_back(UuidParseFailure{
+        base + i, Uuid::fromChars(strs[base + i]).error()});
+      out[base + i] = Uuid();
+    }
+  }
+  return parsed;
 }
 }; // namespace uuid
 }; // namespace oasis
@@ -112,9 +708,7 @@ std::ostream& operator<<(std::ostream& os, const Uuid& uuid)
 template <>
 struct std::hash< oasis::uuid::Uuid > {
   std::size_t operator()(const oasis::uuid::Uuid& uuid) const {
-    size_t h1 = hash<uint64_t>()(uuid.lo);
-    size_t h2 = hash<uint64_t>()(uuid.hi);
-    return h1 ^ (h2 << 1);
+    return uuid.hash();
   }
 };
 
@@ -0,0 +1,233 @@
+#ifndef OASIS_UUID_BLOOM_H
+#define OASIS_UUID_BLOOM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../uuid.hpp"
+
+namespace oasis {
+namespace uuid {
+
+/// A blocked ("split block") Bloom filter of Uuids.
+///
+/// The filter is an array of 32 byte blocks, each eight 32-bit words. An id
+/// picks one block, then sets (or checks) one bit in each of its eight words,
+/// so every operation touches a single cache line and, with AVX2, is a
+/// handful of vector ops. The layout follows the split block Bloom filter of
+/// Parquet and Impala.
+///
+/// Uuids are already random, so rather than hashing them the filter takes
+/// its bits straight from the id: `hi` (rand_b) folded with `lo` and one
+/// multiply so that v7 ids from the same millisecond, which share their
+/// counter's high bits, still spread across blocks.
+///
+/// Not thread safe.
+class UuidBloomFilter {
+private:
+  static constexpr size_t wordsPerBlock = 8;
+  static constexpr size_t blockBytes = wordsPerBlock * sizeof(uint32_t);
+  // how far ahead of the id being probed the batch operations prefetch
+  static constexpr size_t prefetchAhead = 16;
+
+  // odd constants, one per word, choosing that word's bit
+  alignas(32) static constexpr uint32_t salts[wordsPerBlock] = {
+    0x47B6'137B, 0x4497'4D91, 0x8824'AD5B, 0xA2B7'289D,
+    0x7054'95C7, 0x2DF1'424B, 0x9EFC'4947, 0x5C6B'FB31,
+  };
+
+  struct alignas(blockBytes) Block {
+    uint32_t words[wordsPerBlock];
+  };
+
+  std::unique_ptr<Block[]> blocks;
+  size_t numBlocks;
+
+  explicit UuidBloomFilter(size_t numBlocks)
+      : blocks(new Block[numBlocks]()), numBlocks(numBlocks) {}
+
+  static inline uint64_t material(const Uuid& uuid) {
+    return (uuid.hi ^ uuid.lo) * 0x9E37'79B9'7F4A'7C15LLU;
+  }
+
+  // maps the high 32 bits onto [0, numBlocks) without a division
+  inline Block& blockFor(uint64_t bits) const {
+    return this->blocks[((bits >> 32) * this->numBlocks) >> 32];
+  }
+
+  // calls fn(index, block, key) for every id in order, prefetching the
+  // block of the id `prefetchAhead` places on, so that a filter bigger than
+  // the cache has several misses in flight rather than one
+  template <typename Fn> void forEachProbe(std::span<const Uuid> uuids, Fn&& fn) const {
+    size_t ahead = std::min(prefetchAhead, uuids.size());
+    for (size_t idx = 0; idx < ahead; idx++) {
+      __builtin_prefetch(&this->blockFor(material(uuids[idx])));
+    }
+    for (size_t idx = 0; idx < uuids.size(); idx++) {
+      if (idx + ahead < uuids.size()) {
+        __builtin_prefetch(&this->blockFor(material(uuids[idx + ahead])));
+      }
+      uint64_t bits = material(uuids[idx]);
+      fn(idx, this->blockFor(bits), static_cast<uint32_t>(bits));
+    }
+  }
+
+#if defined(__AVX2__)
+  static inline __m256i mask(uint32_t key) {
+    const __m256i salt = _mm256_load_si256(reinterpret_cast<const __m256i*>(salts));
+    __m256i bit = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(key), salt), 27);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), bit);
+  }
+
+  static inline void insertInto(Block& block, uint32_t key) {
+    __m256i* words = reinterpret_cast<__m256i*>(block.words);
+    _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), mask(key)));
+  }
+
+  static inline bool checkIn(const Block& block, uint32_t key) {
+    __m256i words = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words));
+    return _mm256_testc_si256(words, mask(key));
+  }
+#else
+  static inline void insertInto(Block& block, uint32_t key) {
+    for (size_t w = 0; w < wordsPerBlock; w++) {
+      block.words[w] |= 1u << ((key * salts[w]) >> 27);
+    }
+  }
+
+  static inline bool checkIn(const Block& block, uint32_t key) {
+    bool present = true;
+    for (size_t w = 0; w < wordsPerBlock; w++) {
+      present &= (block.words[w] >> ((key * salts[w]) >> 27)) & 1;
+    }
+    return present;
+  }
+#endif
+
+  // expected false positive rate of a filter of `blocks` blocks holding `ids`
+  // ids: block loads are Poisson distributed, and within a block of i ids
+  // each word has a given bit set with probability 1 - (31/32)^i
+  static double falsePositiveRate(size_t blocks, size_t ids) {
+    if (ids == 0) {
+      return 0;
+    }
+    double load = static_cast<double>(ids) / blocks;
+    double spread = 10 * std::sqrt(load) + 20;
+    size_t first = static_cast<size_t>(std::max(0.0, load - spread));
+    size_t last = static_cast<size_t>(load + spread);
+
+    // the probabilities are worked out in log space, e^-load underflows for
+    // heavily loaded filters
+    double rate = 0;
+    double logLoad = std::log(load);
+    for (size_t i = first; i <= last; i++) {
+      double poisson = std::exp(i * logLoad - load - std::lgamma(i + 1.0));
+      double wordRate = 1 - std::pow(31.0 / 32.0, i);
+      rate += poisson * std::pow(wordRate, wordsPerBlock);
+    }
+    return std::min(rate, 1.0);
+  }
+
+public:
+  /// The largest filter that fits in `bytes` (at least one block)
+  static UuidBloomFilter withMemoryBudget(size_t bytes) {
+    return UuidBloomFilter(std::max<size_t>(1, bytes / blockBytes));
+  }
+
+  /// The smallest filter expected to stay at or below `falsePositiveRate`
+  /// once it holds `expectedIds` ids, capped at `maxBytes`
+  static UuidBloomFilter forCapacity(size_t expectedIds,
+                                     double falsePositiveRate,
+                                     size_t maxBytes = SIZE_MAX) {
+    size_t maxBlocks = std::max<size_t>(1, maxBytes / blockBytes);
+
+    // the rate only falls as blocks are added, so binary search the count
+    size_t lo = 1;
+    size_t hi = 1;
+    while (hi < maxBlocks &&
+           UuidBloomFilter::falsePositiveRate(hi, expectedIds) > falsePositiveRate) {
+      lo = hi;
+      hi = std::min(maxBlocks, hi * 2);
+    }
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (UuidBloomFilter::falsePositiveRate(mid, expectedIds) > falsePositiveRate) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return UuidBloomFilter(hi);
+  }
+
+  /// Size of the bit array in bytes
+  size_t sizeBytes() const { return this->numBlocks * blockBytes; }
+
+  /// The false positive rate to expect once `ids` distinct ids are inserted
+  double expectedFalsePositiveRate(size_t ids) const {
+    return falsePositiveRate(this->numBlocks, ids);
+  }
+
+  void clear() {
+    std::fill(this->blocks.get(), this->blocks.get() + this->numBlocks, Block{});
+  }
+
+  void insert(const Uuid& uuid) {
+    uint64_t bits = material(uuid);
+    insertInto(this->blockFor(bits), static_cast<uint32_t>(bits));
+  }
+
+  /// False if `uuid` was never inserted, true if it probably was
+  bool mayContain(const Uuid& uuid) const {
+    uint64_t bits = material(uuid);
+    return checkIn(this->blockFor(bits), static_cast<uint32_t>(bits));
+  }
+
+  /// Inserts `uuid`, returning whether it was probably present already
+  bool testAndInsert(const Uuid& uuid) {
+    uint64_t bits = material(uuid);
+    Block& block = this->blockFor(bits);
+    bool present = checkIn(block, static_cast<uint32_t>(bits));
+    insertInto(block, static_cast<uint32_t>(bits));
+    return present;
+  }
+
+  /// Inserts every id, prefetching the blocks of the ids coming up
+  void insertMany(std::span<const Uuid> uuids) {
+    this->forEachProbe(uuids, [](size_t, Block& block, uint32_t key) { insertInto(block, key); });
+  }
+
+  /// Sets out[i] to mayContain(uuids[i]), returning how many were set
+  size_t mayContainMany(std::span<const Uuid> uuids, std::span<bool> out) const {
+    size_t present = 0;
+    this->forEachProbe(uuids, [&](size_t idx, Block& block, uint32_t key) {
+      out[idx] = checkIn(block, key);
+      present += out[idx];
+    });
+    return present;
+  }
+
+  /// testAndInsert over a batch, in order, so an id repeated within the batch
+  /// is reported from its second occurrence on. Returns how many were set.
+  size_t testAndInsertMany(std::span<const Uuid> uuids, std::span<bool> out) {
+    size_t present = 0;
+    this->forEachProbe(uuids, [&](size_t idx, Block& block, uint32_t key) {
+      out[idx] = checkIn(block, key);
+      insertInto(block, key);
+      present += out[idx];
+    });
+    return present;
+  }
+};
+
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_BLOOM_H
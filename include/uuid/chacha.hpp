@@ -0,0 +1,232 @@
+#ifndef OASIS_UUID_CHACHA_H
+#define OASIS_UUID_CHACHA_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace oasis {
+namespace uuid {
+namespace detail {
+
+// the ChaCha20 block function (RFC 8439), used as the keystream behind v4
+// ids. the 16 word state is the constants, the 256-bit key, then djb's
+// original split of a 64-bit block counter and a 64-bit nonce.
+//
+// the SSE2/AVX2 kernels run 4/8 blocks at once, one block per vector lane,
+// and are picked at compile time like the hex kernels. every kernel produces
+// the same keystream, block after block.
+
+inline constexpr size_t chachaBlockWords = 16;
+inline constexpr size_t chachaKeyWords = 8;
+
+inline constexpr uint32_t chachaConstants[4] = {
+  0x6170'7865, 0x3320'646E, 0x7962'2D32, 0x6B20'6574,
+};
+
+inline void chachaQuarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+  a += b; d ^= a; d = std::rotl(d, 16);
+  c += d; b ^= c; b = std::rotl(b, 12);
+  a += b; d ^= a; d = std::rotl(d, 8);
+  c += d; b ^= c; b = std::rotl(b, 7);
+}
+
+#if defined(__SSE2__)
+template <int n>
+inline __m128i chachaRotl(__m128i x) {
+  return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+}
+
+inline void chachaQuarterRound(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+  a = _mm_add_epi32(a, b); d = chachaRotl<16>(_mm_xor_si128(d, a));
+  c = _mm_add_epi32(c, d); b = chachaRotl<12>(_mm_xor_si128(b, c));
+  a = _mm_add_epi32(a, b); d = chachaRotl<8>(_mm_xor_si128(d, a));
+  c = _mm_add_epi32(c, d); b = chachaRotl<7>(_mm_xor_si128(b, c));
+}
+#endif
+
+#if defined(__AVX2__)
+template <int n>
+inline __m256i chachaRotl(__m256i x) {
+  // rotations by whole bytes are a single shuffle
+  if constexpr (n == 16) {
+    const __m256i rot16 = _mm256_setr_epi8(
+      2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+      2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    return _mm256_shuffle_epi8(x, rot16);
+  } else if constexpr (n == 8) {
+    const __m256i rot8 = _mm256_setr_epi8(
+      3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+      3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    return _mm256_shuffle_epi8(x, rot8);
+  } else {
+    return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+  }
+}
+
+inline void chachaQuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+  a = _mm256_add_epi32(a, b); d = chachaRotl<16>(_mm256_xor_si256(d, a));
+  c = _mm256_add_epi32(c, d); b = chachaRotl<12>(_mm256_xor_si256(b, c));
+  a = _mm256_add_epi32(a, b); d = chachaRotl<8>(_mm256_xor_si256(d, a));
+  c = _mm256_add_epi32(c, d); b = chachaRotl<7>(_mm256_xor_si256(b, c));
+}
+#endif
+
+// the 20 rounds, over a state of words or of vectors of words
+template <typename Word>
+inline void chachaRounds(Word (&x)[chachaBlockWords]) {
+  for (int i = 0; i < 10; i++) {
+    chachaQuarterRound(x[0], x[4], x[8], x[12]);
+    chachaQuarterRound(x[1], x[5], x[9], x[13]);
+    chachaQuarterRound(x[2], x[6], x[10], x[14]);
+    chachaQuarterRound(x[3], x[7], x[11], x[15]);
+    chachaQuarterRound(x[0], x[5], x[10], x[15]);
+    chachaQuarterRound(x[1], x[6], x[11], x[12]);
+    chachaQuarterRound(x[2], x[7], x[8], x[13]);
+    chachaQuarterRound(x[3], x[4], x[9], x[14]);
+  }
+}
+
+inline void chachaInitState(const uint32_t* key, uint64_t counter, uint64_t nonce,
+                            uint32_t (&state)[chachaBlockWords]) {
+  for (size_t w = 0; w < 4; w++) {
+    state[w] = chachaConstants[w];
+  }
+  for (size_t w = 0; w < chachaKeyWords; w++) {
+    state[4 + w] = key[w];
+  }
+  state[12] = static_cast<uint32_t>(counter);
+  state[13] = static_cast<uint32_t>(counter >> 32);
+  state[14] = static_cast<uint32_t>(nonce);
+  state[15] = static_cast<uint32_t>(nonce >> 32);
+}
+
+inline void chachaBlockScalar(const uint32_t* key, uint64_t counter, uint64_t nonce,
+                              uint32_t* out) {
+  uint32_t state[chachaBlockWords];
+  chachaInitState(key, counter, nonce, state);
+
+  uint32_t x[chachaBlockWords];
+  for (size_t w = 0; w < chachaBlockWords; w++) {
+    x[w] = state[w];
+  }
+  chachaRounds(x);
+  for (size_t w = 0; w < chachaBlockWords; w++) {
+    out[w] = x[w] + state[w];
+  }
+}
+
+#if defined(__SSE2__)
+// blocks counter .. counter + 3
+inline void chachaBlocksSse2(const uint32_t* key, uint64_t counter, uint64_t nonce,
+                             uint32_t* out) {
+  static const size_t lanes = 4;
+
+  uint32_t state[chachaBlockWords];
+  chachaInitState(key, counter, nonce, state);
+
+  __m128i init[chachaBlockWords];
+  for (size_t w = 0; w < 12; w++) {
+    init[w] = _mm_set1_epi32(state[w]);
+  }
+  alignas(16) uint32_t counterLo[lanes];
+  alignas(16) uint32_t counterHi[lanes];
+  for (size_t l = 0; l < lanes; l++) {
+    counterLo[l] = static_cast<uint32_t>(counter + l);
+    counterHi[l] = static_cast<uint32_t>((counter + l) >> 32);
+  }
+  init[12] = _mm_load_si128(reinterpret_cast<const __m128i*>(counterLo));
+  init[13] = _mm_load_si128(reinterpret_cast<const __m128i*>(counterHi));
+  init[14] = _mm_set1_epi32(state[14]);
+  init[15] = _mm_set1_epi32(state[15]);
+
+  __m128i x[chachaBlockWords];
+  for (size_t w = 0; w < chachaBlockWords; w++) {
+    x[w] = init[w];
+  }
+  chachaRounds(x);
+
+  // lane l of word w is word w of block l
+  alignas(16) uint32_t words[chachaBlockWords][lanes];
+  for (size_t w = 0; w < chachaBlockWords; w++) {
+    _mm_store_si128(reinterpret_cast<__m128i*>(words[w]), _mm_add_epi32(x[w], init[w]));
+  }
+  for (size_t l = 0; l < lanes; l++) {
+    for (size_t w = 0; w < chachaBlockWords; w++) {
+      out[l * chachaBlockWords + w] = words[w][l];
+    }
+  }
+}
+#endif
+
+#if defined(__AVX2__)
+// blocks counter .. counter + 7
+inline void chachaBlocksAvx2(const uint32_t* key, uint64_t counter, uint64_t nonce,
+                             uint32_t* out) {
+  static const size_t lanes = 8;
+
+  uint32_t state[chachaBlockWords];
+  chachaInitState(key, counter, nonce, state);
+
+  __m256i init[chachaBlockWords];
+  for (size_t w = 0; w < 12; w++) {
+    init[w] = _mm256_set1_epi32(state[w]);
+  }
+  alignas(32) uint32_t counterLo[lanes];
+  alignas(32) uint32_t counterHi[lanes];
+  for (size_t l = 0; l < lanes; l++) {
+    counterLo[l] = static_cast<uint32_t>(counter + l);
+    counterHi[l] = static_cast<uint32_t>((counter + l) >> 32);
+  }
+  init[12] = _mm256_load_si256(reinterpret_cast<const __m256i*>(counterLo));
+  init[13] = _mm256_load_si256(reinterpret_cast<const __m256i*>(counterHi));
+  init[14] = _mm256_set1_epi32(state[14]);
+  init[15] = _mm256_set1_epi32(state[15]);
+
+  __m256i x[chachaBlockWords];
+  for (size_t w = 0; w < chachaBlockWords; w++) {
+    x[w] = init[w];
+  }
+  chachaRounds(x);
+
+  alignas(32) uint32_t words[chachaBlockWords][lanes];
+  for (size_t w = 0; w < chachaBlockWords; w++) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words[w]), _mm256_add_epi32(x[w], init[w]));
+  }
+  for (size_t l = 0; l < lanes; l++) {
+    for (size_t w = 0; w < chachaBlockWords; w++) {
+      out[l * chachaBlockWords + w] = words[w][l];
+    }
+  }
+}
+#endif
+
+// writes `n` blocks of keystream, starting at block `counter`, to `out`
+inline void chachaBlocks(const uint32_t* key, uint64_t counter, uint64_t nonce,
+                         uint32_t* out, size_t n) {
+  size_t b = 0;
+#if defined(__AVX2__)
+  for (; b + 8 <= n; b += 8) {
+    chachaBlocksAvx2(key, counter + b, nonce, out + b * chachaBlockWords);
+  }
+#endif
+#if defined(__SSE2__)
+  for (; b + 4 <= n; b += 4) {
+    chachaBlocksSse2(key, counter + b, nonce, out + b * chachaBlockWords);
+  }
+#endif
+  for (uint32_t* block = out + b * chachaBlockWords; b < n; b++) {
+    chachaBlockScalar(key, counter + b, nonce, block);
+    block += chachaBlockWords;
+  }
+}
+
+}; // namespace detail
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_CHACHA_H
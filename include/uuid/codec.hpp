@@ -0,0 +1,357 @@
+#ifndef OASIS_UUID_CODEC_H
+#define OASIS_UUID_CODEC_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../uuid.hpp"
+
+namespace oasis {
+namespace uuid {
+
+enum class UuidColumnError {
+  Truncated,
+  InvalidHeader,
+};
+
+namespace detail {
+
+template <typename T> inline T loadLe(const uint8_t* in) {
+  static_assert(std::endian::native == std::endian::little,
+                "uuid columns are little endian on the wire");
+  T val;
+  std::memcpy(&val, in, sizeof(T));
+  return val;
+}
+
+template <typename T> inline void storeLe(uint8_t* out, T val) {
+  static_assert(std::endian::native == std::endian::little,
+                "uuid columns are little endian on the wire");
+  std::memcpy(out, &val, sizeof(T));
+}
+
+inline uint64_t zigzagEncode(int64_t val) {
+  return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t val) {
+  return static_cast<int64_t>((val >> 1) ^ (0 - (val & 1)));
+}
+
+// the widest zigzagged delta between two 48-bit timestamps. any value this
+// wide sits inside a single unaligned 8 byte load, whatever its bit offset.
+inline constexpr uint32_t maxDeltaWidth = 49;
+
+// reads values [from, count) of `width` bits each, packed lsb first starting
+// at `packed`, zigzag decodes them and prefix sums them onto `base`, writing
+// the running totals to `out`. `packed` must be readable 8 bytes past the
+// last value.
+inline void unpackDeltasScalar(const uint8_t* packed, uint32_t width,
+                               size_t count, uint64_t base, uint64_t* out,
+                               size_t from = 0) {
+  uint64_t mask = (1LLU << width) - 1;
+  for (size_t i = from; i < count; i++) {
+    size_t bit = i * width;
+    uint64_t val = (loadLe<uint64_t>(packed + bit / 8) >> (bit % 8)) & mask;
+    base += zigzagDecode(val);
+    out[i] = base;
+  }
+}
+
+#if defined(__AVX2__)
+// the same as unpackDeltasScalar, 4 deltas at a time: one gather pulls the 4
+// unaligned words holding them, a variable shift and mask extract them, and a
+// 2 step log shift prefix sum accumulates them
+inline void unpackDeltasAvx2(const uint8_t* packed, uint32_t width,
+                             size_t count, uint64_t base, uint64_t* out) {
+  const __m256i mask = _mm256_set1_epi64x((1LLU << width) - 1);
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i step = _mm256_set1_epi64x(4 * static_cast<int64_t>(width));
+
+  __m256i bits = _mm256_set_epi64x(3 * width, 2 * width, width, 0);
+  __m256i running = _mm256_set1_epi64x(base);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i bytes = _mm256_srli_epi64(bits, 3);
+    __m256i shifts = _mm256_and_si256(bits, _mm256_set1_epi64x(7));
+    __m256i words = _mm256_i64gather_epi64(
+      reinterpret_cast<const long long*>(packed), bytes, 1);
+    __m256i vals = _mm256_and_si256(_mm256_srlv_epi64(words, shifts), mask);
+
+    // zigzag decode: (v >> 1) ^ -(v & 1)
+    __m256i sign = _mm256_sub_epi64(zero, _mm256_and_si256(vals, one));
+    __m256i deltas = _mm256_xor_si256(_mm256_srli_epi64(vals, 1), sign);
+
+    // inclusive prefix sum across the 4 lanes
+    __m256i shifted1 = _mm256_blend_epi32(
+      _mm256_permute4x64_epi64(deltas, 0b10'01'00'00), zero, 0b0000'0011);
+    deltas = _mm256_add_epi64(deltas, shifted1);
+    __m256i shifted2 = _mm256_blend_epi32(
+      _mm256_permute4x64_epi64(deltas, 0b01'00'00'00), zero, 0b0000'1111);
+    deltas = _mm256_add_epi64(deltas, shifted2);
+
+    __m256i totals = _mm256_add_epi64(running, deltas);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), totals);
+
+    running = _mm256_permute4x64_epi64(totals, 0b11'11'11'11);
+    bits = _mm256_add_epi64(bits, step);
+  }
+
+  uint64_t last = i == 0 ? base : out[i - 1];
+  unpackDeltasScalar(packed, width, count, last, out, i);
+}
+#endif
+
+inline void unpackDeltas(const uint8_t* packed, uint32_t width, size_t count,
+                         uint64_t base, uint64_t* out) {
+#if defined(__AVX2__)
+  unpackDeltasAvx2(packed, width, count, base, out);
+#else
+  unpackDeltasScalar(packed, width, count, base, out);
+#endif
+}
+
+}; // namespace detail
+
+/// A compressed, columnar encoding of an array of uuids, tuned for v7 ids.
+///
+/// Ids are split into blocks of `blockSize`. Within a block the 48-bit
+/// timestamps are delta encoded against their predecessor, zigzagged (so
+/// out of order ids still work) and bit packed at the block's widest delta,
+/// while the remaining 80 bits (ver + rand_a, then var + rand_b) are stored
+/// as-is in two columns. Sorted v7 ids have deltas of a few ms at most, so
+/// a block costs a little over 10 bytes per id rather than 16.
+///
+/// The encoding is lossless for any uuid, not just v7. A table of block
+/// offsets follows the header so any block (or single id) can be decoded
+/// without touching the others.
+///
+/// Layout, all integers little endian:
+///   header:  u32 magic, u32 count, u32 blockSize, u32 numBlocks
+///   offsets: u32 per block, from the start of the buffer
+///   block:   u64 first timestamp, u32 count, u32 delta width,
+///            packed deltas (count - 1 of them) + 8 bytes of padding,
+///            u16 per id (lo bits 48 - 63), u64 per id (hi)
+class UuidV7Column {
+public:
+  static constexpr uint32_t blockSize = 128;
+
+private:
+  static const uint32_t magic = 0x3743'5555; // "UUC7"
+  static const size_t headerSize = 16;
+  static const size_t blockHeaderSize = 16;
+  // lets the decoder do a full 8 byte load at any packed value
+  static const size_t packPadding = 8;
+
+  std::vector<uint8_t> buf;
+
+  explicit UuidV7Column(std::vector<uint8_t> buf) : buf(std::move(buf)) {}
+
+  static size_t packedSize(uint32_t count, uint32_t width) {
+    size_t bits = static_cast<size_t>(count == 0 ? 0 : count - 1) * width;
+    return (bits + 7) / 8 + packPadding;
+  }
+
+  static size_t blockBytes(uint32_t count, uint32_t width) {
+    return blockHeaderSize + packedSize(count, width) + count * (2 + 8);
+  }
+
+  static void encodeBlock(std::span<const Uuid> ids, std::vector<uint8_t>& out) {
+    assert(ids.size() <= blockSize);
+    uint32_t count = static_cast<uint32_t>(ids.size());
+
+    uint64_t deltas[blockSize];
+    uint64_t widest = 0;
+    for (uint32_t i = 1; i < count; i++) {
+      int64_t delta = static_cast<int64_t>(ids[i].timestampMillis()) -
+                      static_cast<int64_t>(ids[i - 1].timestampMillis());
+      deltas[i - 1] = detail::zigzagEncode(delta);
+      widest |= deltas[i - 1];
+    }
+    uint32_t width = std::bit_width(widest);
+    assert(width <= detail::maxDeltaWidth);
+
+    size_t start = out.size();
+    out.resize(start + blockBytes(count, width), 0);
+    uint8_t* dst = out.data() + start;
+
+    detail::storeLe<uint64_t>(dst, ids[0].timestampMillis());
+    detail::storeLe<uint32_t>(dst + 8, count);
+    detail::storeLe<uint32_t>(dst + 12, width);
+    dst += blockHeaderSize;
+
+    for (uint32_t i = 0; width != 0 && i + 1 < count; i++) {
+      size_t bit = static_cast<size_t>(i) * width;
+      uint64_t word = detail::loadLe<uint64_t>(dst + bit / 8);
+      word |= deltas[i] << (bit % 8);
+      detail::storeLe<uint64_t>(dst + bit / 8, word);
+    }
+    dst += packedSize(count, width);
+
+    for (uint32_t i = 0; i < count; i++) {
+      detail::storeLe<uint16_t>(dst + 2 * i, ids[i].lo >> 48);
+    }
+    dst += 2 * count;
+
+    for (uint32_t i = 0; i < count; i++) {
+      detail::storeLe<uint64_t>(dst + 8 * i, ids[i].hi);
+    }
+  }
+
+  const uint8_t* blockStart(size_t block) const {
+    uint32_t offset = detail::loadLe<uint32_t>(this->buf.data() + headerSize + 4 * block);
+    return this->buf.data() + offset;
+  }
+
+public:
+  UuidV7Column() : UuidV7Column(std::span<const Uuid>()) {}
+
+  /// Encodes `ids`. Throws std::length_error if there are more than
+  /// UINT32_MAX of them, or a block would start past the first 4GB, which
+  /// the u32 header fields can't describe.
+  explicit UuidV7Column(std::span<const Uuid> ids) {
+    if (ids.size() > UINT32_MAX) {
+      throw std::length_error("[UuidV7Column] more ids than a u32 count holds");
+    }
+    uint32_t numBlocks = static_cast<uint32_t>((ids.size() + blockSize - 1) / blockSize);
+    this->buf.resize(headerSize + 4 * static_cast<size_t>(numBlocks));
+    detail::storeLe<uint32_t>(this->buf.data(), magic);
+    detail::storeLe<uint32_t>(this->buf.data() + 4, static_cast<uint32_t>(ids.size()));
+    detail::storeLe<uint32_t>(this->buf.data() + 8, blockSize);
+    detail::storeLe<uint32_t>(this->buf.data() + 12, numBlocks);
+
+    for (uint32_t block = 0; block < numBlocks; block++) {
+      if (this->buf.size() > UINT32_MAX) {
+        throw std::length_error("[UuidV7Column] encoding too large for u32 block offsets");
+      }
+      detail::storeLe<uint32_t>(this->buf.data() + headerSize + 4 * static_cast<size_t>(block),
+                                static_cast<uint32_t>(this->buf.size()));
+      size_t first = static_cast<size_t>(block) * blockSize;
+      size_t count = std::min<size_t>(blockSize, ids.size() - first);
+      encodeBlock(ids.subspan(first, count), this->buf);
+    }
+  }
+
+  /// Wraps a buffer produced by `bytes()`, validating its structure
+  static std::expected<UuidV7Column, UuidColumnError> fromBytes(
+      std::span<const uint8_t> bytes) {
+    if (bytes.size() < headerSize) {
+      return std::unexpected(UuidColumnError::Truncated);
+    }
+
+    uint32_t count = detail::loadLe<uint32_t>(bytes.data() + 4);
+    uint32_t numBlocks = detail::loadLe<uint32_t>(bytes.data() + 12);
+    if (detail::loadLe<uint32_t>(bytes.data()) != magic ||
+        detail::loadLe<uint32_t>(bytes.data() + 8) != blockSize ||
+        numBlocks != (static_cast<uint64_t>(count) + blockSize - 1) / blockSize) {
+      return std::unexpected(UuidColumnError::InvalidHeader);
+    }
+    if (bytes.size() < headerSize + 4 * static_cast<size_t>(numBlocks)) {
+      return std::unexpected(UuidColumnError::Truncated);
+    }
+
+    for (uint32_t block = 0; block < numBlocks; block++) {
+      size_t offset = detail::loadLe<uint32_t>(bytes.data() + headerSize + 4 * block);
+      if (offset + blockHeaderSize > bytes.size()) {
+        return std::unexpected(UuidColumnError::Truncated);
+      }
+
+      uint32_t expectedCount = std::min(blockSize, count - block * blockSize);
+      uint32_t blockCount = detail::loadLe<uint32_t>(bytes.data() + offset + 8);
+      uint32_t width = detail::loadLe<uint32_t>(bytes.data() + offset + 12);
+      if (blockCount != expectedCount || width > detail::maxDeltaWidth) {
+        return std::unexpected(UuidColumnError::InvalidHeader);
+      }
+      if (offset + blockBytes(blockCount, width) > bytes.size()) {
+        return std::unexpected(UuidColumnError::Truncated);
+      }
+    }
+
+    return UuidV7Column(std::vector<uint8_t>(bytes.begin(), bytes.end()));
+  }
+
+  /// The encoded form
+  std::span<const uint8_t> bytes() const { return this->buf; }
+
+  /// Number of ids encoded
+  size_t size() const { return detail::loadLe<uint32_t>(this->buf.data() + 4); }
+
+  size_t numBlocks() const {
+    return detail::loadLe<uint32_t>(this->buf.data() + 12);
+  }
+
+  /// Number of ids in `block`, `blockSize` for all but the last
+  size_t blockCount(size_t block) const {
+    return detail::loadLe<uint32_t>(this->blockStart(block) + 8);
+  }
+
+  /// Decodes `block` into `out`, which must hold `blockCount(block)` ids
+  void decodeBlock(size_t block, std::span<Uuid> out) const {
+    assert(block < this->numBlocks());
+    const uint8_t* src = this->blockStart(block);
+    uint64_t first = detail::loadLe<uint64_t>(src);
+    uint32_t count = detail::loadLe<uint32_t>(src + 8);
+    uint32_t width = detail::loadLe<uint32_t>(src + 12);
+    assert(out.size() >= count);
+    src += blockHeaderSize;
+
+    uint64_t timestamps[blockSize];
+    timestamps[0] = first;
+    detail::unpackDeltas(src, width, count - 1, first, timestamps + 1);
+    src += packedSize(count, width);
+
+    const uint8_t* top = src;
+    const uint8_t* his = src + 2 * count;
+    for (uint32_t i = 0; i < count; i++) {
+      uint64_t lo = (timestamps[i] & Uuid::timestampMask) |
+                    (static_cast<uint64_t>(detail::loadLe<uint16_t>(top + 2 * i)) << 48);
+      out[i] = Uuid(lo, detail::loadLe<uint64_t>(his + 8 * i));
+    }
+  }
+
+  /// Decodes every id into `out`, which must hold `size()` ids
+  void decode(std::span<Uuid> out) const {
+    assert(out.size() >= this->size());
+    for (size_t block = 0; block < this->numBlocks(); block++) {
+      this->decodeBlock(block, out.subspan(block * blockSize));
+    }
+  }
+
+  /// Decodes the id at `idx`, only touching its block
+  Uuid at(size_t idx) const {
+    assert(idx < this->size());
+    const uint8_t* src = this->blockStart(idx / blockSize);
+    uint64_t first = detail::loadLe<uint64_t>(src);
+    uint32_t count = detail::loadLe<uint32_t>(src + 8);
+    uint32_t width = detail::loadLe<uint32_t>(src + 12);
+    size_t inBlock = idx % blockSize;
+    src += blockHeaderSize;
+
+    uint64_t timestamps[blockSize];
+    timestamps[0] = first;
+    detail::unpackDeltas(src, width, inBlock, first, timestamps + 1);
+    src += packedSize(count, width);
+
+    uint64_t lo = (timestamps[inBlock] & Uuid::timestampMask) |
+                  (static_cast<uint64_t>(detail::loadLe<uint16_t>(src + 2 * inBlock)) << 48);
+    return Uuid(lo, detail::loadLe<uint64_t>(src + 2 * count + 8 * inBlock));
+  }
+};
+
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_CODEC_H
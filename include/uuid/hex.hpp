@@ -0,0 +1,278 @@
+#ifndef OASIS_UUID_HEX_H
+#define OASIS_UUID_HEX_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace oasis {
+namespace uuid {
+namespace detail {
+
+// hex encoding and decoding of the 16 "display" bytes of a uuid, i.e. the
+// bytes in the order their hex digits appear in the string form. callers are
+// responsible for mapping a Uuid to and from its display bytes.
+//
+// the SSE2/AVX2 kernels are picked at compile time based on the target, with
+// a table driven scalar fallback for everything else.
+
+// positions of the dashes in the 36 char string form
+inline constexpr std::array<size_t, 4> dashPositions = {8, 13, 18, 23};
+
+inline constexpr char hexDigits[] = "0123456789abcdef";
+
+// maps an ascii char to its hex value, or -1 if it isn't a hex digit
+inline constexpr std::array<int8_t, 256> hexValues = []() {
+  std::array<int8_t, 256> table{};
+  for (int c = 0; c < 256; c++) {
+    if (c >= '0' && c <= '9') {
+      table[c] = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      table[c] = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      table[c] = c - 'A' + 10;
+    } else {
+      table[c] = -1;
+    }
+  }
+  return table;
+}();
+
+inline void storeBigEndian(uint64_t val, uint8_t* out) {
+  if constexpr (std::endian::native == std::endian::little) {
+    val = std::byteswap(val);
+  }
+  std::memcpy(out, &val, sizeof(val));
+}
+
+inline uint64_t loadBigEndian(const uint8_t* in) {
+  uint64_t val;
+  std::memcpy(&val, in, sizeof(val));
+  if constexpr (std::endian::native == std::endian::little) {
+    val = std::byteswap(val);
+  }
+  return val;
+}
+
+// copies 32 contiguous hex digits into the dashed 36 char layout
+inline void insertDashes(const char* digits, char* out) {
+  std::memcpy(out, digits, 8);
+  out[8] = '-';
+  std::memcpy(out + 9, digits + 8, 4);
+  out[13] = '-';
+  std::memcpy(out + 14, digits + 12, 4);
+  out[18] = '-';
+  std::memcpy(out + 19, digits + 16, 4);
+  out[23] = '-';
+  std::memcpy(out + 24, digits + 20, 12);
+}
+
+// the inverse of insertDashes, returns false if a dash is missing
+inline bool removeDashes(const char* in, char* digits) {
+  bool dashes = (in[8] == '-') & (in[13] == '-') & (in[18] == '-') &
+                (in[23] == '-');
+  std::memcpy(digits, in, 8);
+  std::memcpy(digits + 8, in + 9, 4);
+  std::memcpy(digits + 12, in + 14, 4);
+  std::memcpy(digits + 16, in + 19, 4);
+  std::memcpy(digits + 20, in + 24, 12);
+  return dashes;
+}
+
+inline void encodeHexScalar(const uint8_t* bytes, char* digits) {
+  for (size_t i = 0; i < 16; i++) {
+    digits[2 * i] = hexDigits[bytes[i] >> 4];
+    digits[2 * i + 1] = hexDigits[bytes[i] & 0x0F];
+  }
+}
+
+inline bool decodeHexScalar(const char* digits, uint8_t* bytes) {
+  int8_t invalid = 0;
+  for (size_t i = 0; i < 16; i++) {
+    int8_t hi = hexValues[static_cast<uint8_t>(digits[2 * i])];
+    int8_t lo = hexValues[static_cast<uint8_t>(digits[2 * i + 1])];
+    invalid |= hi | lo;
+    bytes[i] = static_cast<uint8_t>((hi << 4) | (lo & 0x0F));
+  }
+  // any -1 leaves the sign bit set
+  return invalid >= 0;
+}
+
+#if defined(__SSE2__)
+// nibbles (0 - 15) to lowercase ascii hex digits
+inline __m128i nibblesToAscii(__m128i nibbles) {
+  __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  __m128i ascii = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+  return _mm_add_epi8(ascii, _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+inline void encodeHexSse2(const uint8_t* bytes, char* digits) {
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+  __m128i lo = _mm_and_si128(v, mask);
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+
+  __m128i first = nibblesToAscii(_mm_unpacklo_epi8(hi, lo));
+  __m128i second = nibblesToAscii(_mm_unpackhi_epi8(hi, lo));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(digits), first);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + 16), second);
+}
+
+// ascii hex digits to nibbles, `valid` gets 0xFF in every lane that held a
+// hex digit
+inline __m128i asciiToNibbles(__m128i chars, __m128i& valid) {
+  __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+
+  // folding to lowercase only matters for letters; anything else that lands
+  // in 'a' - 'f' after the fold started out as one of them
+  __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  __m128i alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+  __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+  valid = _mm_or_si128(isDigit, isAlpha);
+  return _mm_or_si128(
+    _mm_and_si128(isDigit, digit),
+    _mm_and_si128(isAlpha, _mm_add_epi8(alpha, _mm_set1_epi8(10)))
+  );
+}
+
+// pairs of nibbles (high nibble first) to bytes, one byte per 16-bit lane
+inline __m128i combineNibbles(__m128i nibbles) {
+  __m128i hi = _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00F0));
+  __m128i lo = _mm_srli_epi16(nibbles, 8);
+  return _mm_or_si128(hi, lo);
+}
+
+inline bool decodeHexSse2(const char* digits, uint8_t* bytes) {
+  __m128i validFirst, validSecond;
+  __m128i first = asciiToNibbles(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits)), validFirst);
+  __m128i second = asciiToNibbles(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits + 16)), validSecond);
+
+  __m128i packed = _mm_packus_epi16(combineNibbles(first), combineNibbles(second));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), packed);
+
+  return _mm_movemask_epi8(_mm_and_si128(validFirst, validSecond)) == 0xFFFF;
+}
+#endif
+
+#if defined(__AVX2__)
+// encodes two uuids' display bytes (32 bytes) into 64 hex digits
+inline void encodeHexAvx2x2(const uint8_t* bytes, char* digits) {
+  const __m256i mask = _mm256_set1_epi8(0x0F);
+  __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+  __m256i lo = _mm256_and_si256(v, mask);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask);
+
+  // unpacks work within 128-bit lanes, so `first` holds the first 16 digits of
+  // each uuid and `second` the last 16
+  __m256i first = _mm256_unpacklo_epi8(hi, lo);
+  __m256i second = _mm256_unpackhi_epi8(hi, lo);
+
+  auto toAscii = [](__m256i nibbles) {
+    __m256i letters = _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9));
+    __m256i ascii = _mm256_add_epi8(nibbles, _mm256_set1_epi8('0'));
+    return _mm256_add_epi8(
+      ascii, _mm256_and_si256(letters, _mm256_set1_epi8('a' - '0' - 10)));
+  };
+  first = toAscii(first);
+  second = toAscii(second);
+
+  __m256i uuidA = _mm256_permute2x128_si256(first, second, 0x20);
+  __m256i uuidB = _mm256_permute2x128_si256(first, second, 0x31);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(digits), uuidA);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(digits + 32), uuidB);
+}
+#endif
+
+#if defined(__AVX2__)
+inline __m256i asciiToNibblesAvx2(__m256i chars, __m256i& valid) {
+  __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+  __m256i isDigit = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+
+  __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+  __m256i alpha = _mm256_sub_epi8(lower, _mm256_set1_epi8('a'));
+  __m256i isAlpha = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+  valid = _mm256_or_si256(isDigit, isAlpha);
+  return _mm256_or_si256(
+    _mm256_and_si256(isDigit, digit),
+    _mm256_and_si256(isAlpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10)))
+  );
+}
+
+inline __m256i combineNibblesAvx2(__m256i nibbles) {
+  __m256i hi = _mm256_and_si256(
+    _mm256_slli_epi16(nibbles, 4), _mm256_set1_epi16(0x00F0));
+  __m256i lo = _mm256_srli_epi16(nibbles, 8);
+  return _mm256_or_si256(hi, lo);
+}
+
+// decodes two uuids' worth of hex digits (64 chars) into 32 display bytes,
+// returning a 2 bit mask with bit i set if uuid i was all hex digits
+inline uint32_t decodeHexAvx2x2(const char* digits, uint8_t* bytes) {
+  __m256i validA, validB;
+  __m256i a = asciiToNibblesAvx2(
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits)), validA);
+  __m256i b = asciiToNibblesAvx2(
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + 32)), validB);
+
+  // packs work within 128-bit lanes, leaving the 8 byte halves interleaved as
+  // a[0:8] b[0:8] a[8:16] b[8:16], so put them back in order
+  __m256i packed = _mm256_packus_epi16(combineNibblesAvx2(a), combineNibblesAvx2(b));
+  packed = _mm256_permute4x64_epi64(packed, 0b11'01'10'00);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes), packed);
+
+  uint32_t okA = static_cast<uint32_t>(_mm256_movemask_epi8(validA)) == 0xFFFF'FFFF;
+  uint32_t okB = static_cast<uint32_t>(_mm256_movemask_epi8(validB)) == 0xFFFF'FFFF;
+  return okA | (okB << 1);
+}
+#endif
+
+inline void encodeHex(const uint8_t* bytes, char* digits) {
+#if defined(__SSE2__)
+  encodeHexSse2(bytes, digits);
+#else
+  encodeHexScalar(bytes, digits);
+#endif
+}
+
+inline bool decodeHex(const char* digits, uint8_t* bytes) {
+#if defined(__SSE2__)
+  return decodeHexSse2(digits, bytes);
+#else
+  return decodeHexScalar(digits, bytes);
+#endif
+}
+
+// decodes `count` uuids' worth of contiguous hex digits (32 chars each) into
+// contiguous display bytes, returning a mask with bit i set if uuid i was all
+// hex digits. count must be at most 32.
+inline uint32_t decodeHexMany(const char* digits, uint8_t* bytes, size_t count) {
+  uint32_t valid = 0;
+  size_t idx = 0;
+#if defined(__AVX2__)
+  for (; idx + 2 <= count; idx += 2) {
+    valid |= decodeHexAvx2x2(digits + 32 * idx, bytes + 16 * idx) << idx;
+  }
+#endif
+  for (; idx < count; idx++) {
+    valid |= static_cast<uint32_t>(decodeHex(digits + 32 * idx, bytes + 16 * idx)) << idx;
+  }
+  return valid;
+}
+
+}; // namespace detail
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_HEX_H
@@ -0,0 +1,155 @@
+#ifndef OASIS_UUID_INDEX_H
+#define OASIS_UUID_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../uuid.hpp"
+
+namespace oasis {
+namespace uuid {
+namespace detail {
+
+// branchless lower bound: the loop always runs log2(n) times and the compare
+// feeds a conditional move rather than a branch, so there are no mispredicts.
+// both candidates for the next probe are prefetched while we wait on this one.
+inline size_t lowerBound(const uint64_t* data, size_t n, uint64_t key) {
+  if (n == 0) {
+    return 0;
+  }
+
+  const uint64_t* base = data;
+  while (n > 1) {
+    size_t half = n / 2;
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+    base = (base[half] < key) ? base + half : base;
+    n -= half;
+  }
+  return (base - data) + (*base < key);
+}
+
+}; // namespace detail
+
+/// A sorted index of v7 ids that answers "which ids were created between t0
+/// and t1" without decoding every id.
+///
+/// Ids are stored sorted by their embedded timestamp, with the timestamps
+/// kept in a separate dense column so a search only touches 8 bytes per
+/// probe. Ids sharing a timestamp keep their insertion order.
+///
+/// Inserts are optimized for ids that arrive roughly in creation order: an
+/// id at or after the newest timestamp is a plain append, and an id that's a
+/// little late only shifts the handful of entries newer than it.
+class UuidV7Index {
+private:
+  std::vector<uint64_t> timestamps;
+  std::vector<Uuid> ids;
+
+public:
+  UuidV7Index() {}
+
+  size_t size() const { return this->ids.size(); }
+  bool empty() const { return this->ids.empty(); }
+
+  void reserve(size_t count) {
+    this->timestamps.reserve(count);
+    this->ids.reserve(count);
+  }
+
+  void clear() {
+    this->timestamps.clear();
+    this->ids.clear();
+  }
+
+  void insert(const Uuid& id) {
+    uint64_t ts = id.timestampMillis();
+    if (this->timestamps.empty() || this->timestamps.back() <= ts) {
+      this->timestamps.push_back(ts);
+      this->ids.push_back(id);
+      return;
+    }
+
+    // late arrival, walk back from the end since it's most likely close by
+    size_t pos = this->timestamps.size();
+    while (pos > 0 && this->timestamps[pos - 1] > ts) {
+      pos--;
+    }
+    this->timestamps.insert(this->timestamps.begin() + pos, ts);
+    this->ids.insert(this->ids.begin() + pos, id);
+  }
+
+  /// Inserts a batch of ids. Sorted batches that start at or after the newest
+  /// timestamp are appended, anything else is sorted and merged in.
+  void insertMany(std::span<const Uuid> batch) {
+    if (batch.empty()) {
+      return;
+    }
+
+    size_t oldSize = this->ids.size();
+    this->ids.insert(this->ids.end(), batch.begin(), batch.end());
+
+    auto byTimestamp = [](const Uuid& a, const Uuid& b) {
+      return a.timestampMillis() < b.timestampMillis();
+    };
+    auto mid = this->ids.begin() + oldSize;
+    if (!std::is_sorted(mid, this->ids.end(), byTimestamp)) {
+      std::stable_sort(mid, this->ids.end(), byTimestamp);
+    }
+
+    // only entries newer than the batch's oldest id move
+    size_t mergeStart = oldSize;
+    uint64_t oldest = this->ids[oldSize].timestampMillis();
+    if (oldSize != 0 && this->timestamps.back() > oldest) {
+      mergeStart = std::upper_bound(this->timestamps.begin(),
+                                    this->timestamps.end(), oldest) -
+                   this->timestamps.begin();
+      std::inplace_merge(this->ids.begin() + mergeStart, mid, this->ids.end(),
+                         byTimestamp);
+    }
+
+    this->timestamps.resize(this->ids.size());
+    for (size_t idx = mergeStart; idx < this->ids.size(); idx++) {
+      this->timestamps[idx] = this->ids[idx].timestampMillis();
+    }
+  }
+
+  /// Index of the first id created at or after `millis`
+  size_t lowerBound(uint64_t millis) const {
+    return detail::lowerBound(this->timestamps.data(), this->timestamps.size(),
+                              millis);
+  }
+
+  /// Ids created in [fromMillis, toMillis), oldest first. The span is
+  /// invalidated by the next insert.
+  std::span<const Uuid> range(uint64_t fromMillis, uint64_t toMillis) const {
+    if (fromMillis >= toMillis) {
+      return {};
+    }
+    size_t begin = this->lowerBound(fromMillis);
+    size_t end = this->lowerBound(toMillis);
+    return std::span<const Uuid>(this->ids).subspan(begin, end - begin);
+  }
+
+  /// Number of ids created in [fromMillis, toMillis)
+  size_t count(uint64_t fromMillis, uint64_t toMillis) const {
+    return this->range(fromMillis, toMillis).size();
+  }
+
+  /// Drops every id created before `millis`, e.g. to enforce retention
+  void eraseBefore(uint64_t millis) {
+    size_t end = this->lowerBound(millis);
+    this->timestamps.erase(this->timestamps.begin(), this->timestamps.begin() + end);
+    this->ids.erase(this->ids.begin(), this->ids.begin() + end);
+  }
+
+  /// All ids, oldest first
+  std::span<const Uuid> all() const { return this->ids; }
+};
+
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_INDEX_H
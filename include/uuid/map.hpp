@@ -0,0 +1,437 @@
+#ifndef OASIS_UUID_MAP_H
+#define OASIS_UUID_MAP_H
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "../uuid.hpp"
+
+namespace oasis {
+namespace uuid {
+namespace detail {
+
+// control bytes, one per slot. a full slot stores the low 7 bits of its key's
+// hash (so the top bit is clear), empty and deleted slots have it set.
+inline constexpr uint8_t ctrlEmpty = 0x80;
+inline constexpr uint8_t ctrlDeleted = 0xFE;
+
+inline constexpr size_t groupWidth = 16;
+
+// a group of 16 control bytes that can be matched against in one go
+class Group {
+private:
+#if defined(__SSE2__)
+  __m128i ctrl;
+#else
+  uint8_t ctrl[groupWidth];
+#endif
+
+public:
+  explicit Group(const uint8_t* pos) {
+#if defined(__SSE2__)
+    this->ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+    std::memcpy(this->ctrl, pos, groupWidth);
+#endif
+  }
+
+  // bit i is set if slot i holds a key whose hash ends in h2
+  inline uint32_t match(uint8_t h2) const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(this->ctrl, _mm_set1_epi8(h2)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < groupWidth; i++) {
+      mask |= static_cast<uint32_t>(this->ctrl[i] == h2) << i;
+    }
+    return mask;
+#endif
+  }
+
+  inline uint32_t matchEmpty() const { return this->match(ctrlEmpty); }
+
+  // empty or deleted, i.e. the top bit is set
+  inline uint32_t matchFree() const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(this->ctrl);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < groupWidth; i++) {
+      mask |= static_cast<uint32_t>(this->ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+  }
+};
+
+struct Empty {};
+
+}; // namespace detail
+
+/// A flat, open-addressing hash map keyed by Uuid.
+///
+/// Modeled after Swiss tables: slots are split into groups of 16, each with a
+/// control byte holding 7 bits of the key's hash. A lookup loads a group's
+/// control bytes and compares all 16 against the hash at once (SSE2 when
+/// available), so only slots whose hash bits match ever touch the keys.
+/// Groups are probed quadratically and the table grows at 7/8 load.
+///
+/// Keys and values are stored inline, there is no per-entry allocation.
+/// Pointers to values are invalidated by any insertion that grows the table.
+/// Iterators give access to the values, the keys are read-only.
+template <typename V> class UuidMap {
+public:
+  struct Slot {
+    // const, as in std::unordered_map, so iterating can't move a key away
+    // from where its hash put it
+    const Uuid key;
+    [[no_unique_address]] V value;
+  };
+
+  template <bool Const> class Iter {
+  private:
+    using MapPtr = std::conditional_t<Const, const UuidMap*, UuidMap*>;
+    using SlotRef = std::conditional_t<Const, const Slot&, Slot&>;
+
+    MapPtr map;
+    size_t idx;
+
+    void skipFree() {
+      while (this->idx < this->map->numSlots &&
+             (this->map->ctrl[this->idx] & 0x80) != 0) {
+        this->idx++;
+      }
+    }
+
+  public:
+    Iter(MapPtr map, size_t idx) : map(map), idx(idx) { this->skipFree(); }
+
+    SlotRef operator*() const { return this->map->slots[this->idx]; }
+    auto operator->() const { return &this->map->slots[this->idx]; }
+
+    Iter& operator++() {
+      this->idx++;
+      this->skipFree();
+      return *this;
+    }
+
+    bool operator==(const Iter& rhs) const { return this->idx == rhs.idx; }
+    bool operator!=(const Iter& rhs) const { return !operator==(rhs); }
+  };
+
+  using iterator = Iter<false>;
+  using const_iterator = Iter<true>;
+
+private:
+  std::unique_ptr<uint8_t[]> ctrl;
+  Slot* slots = nullptr;
+  // always 0 or a power of two that's at least groupWidth
+  size_t numSlots = 0;
+  size_t numFull = 0;
+  // free slots we can fill before needing to grow, deleted slots don't count
+  size_t growthLeft = 0;
+
+  static size_t h2(uint64_t hash) { return hash & 0x7F; }
+  static size_t h1(uint64_t hash) { return hash >> 7; }
+
+  size_t numGroups() const { return this->numSlots / detail::groupWidth; }
+
+  static size_t capacityToGrowth(size_t capacity) {
+    return capacity - capacity / 8;
+  }
+
+  // index of the slot holding `key`, or numSlots if it's not present
+  size_t findIndex(const Uuid& key, uint64_t hash) const {
+    if (this->numSlots == 0) {
+      return this->numSlots;
+    }
+
+    size_t groupMask = this->numGroups() - 1;
+    size_t group = h1(hash) & groupMask;
+    for (size_t probe = 1;; probe++) {
+      size_t base = group * detail::groupWidth;
+      detail::Group g(this->ctrl.get() + base);
+
+      for (uint32_t m = g.match(h2(hash)); m != 0; m &= m - 1) {
+        size_t idx = base + std::countr_zero(m);
+        if (this->slots[idx].key == key) {
+          return idx;
+        }
+      }
+
+      if (g.matchEmpty() != 0) {
+        return this->numSlots;
+      }
+
+      // triangular steps visit every group when the count is a power of two
+      assert(probe <= this->numGroups());
+      group = (group + probe) & groupMask;
+    }
+  }
+
+  // index of the first empty or deleted slot on `hash`'s probe sequence
+  size_t findFree(uint64_t hash) const {
+    size_t groupMask = this->numGroups() - 1;
+    size_t group = h1(hash) & groupMask;
+    for (size_t probe = 1;; probe++) {
+      size_t base = group * detail::groupWidth;
+      uint32_t free = detail::Group(this->ctrl.get() + base).matchFree();
+      if (free != 0) {
+        return base + std::countr_zero(free);
+      }
+      group = (group + probe) & groupMask;
+    }
+  }
+
+  void setCtrl(size_t idx, uint8_t val) { this->ctrl[idx] = val; }
+
+  void resize(size_t newNumSlots) {
+    std::unique_ptr<uint8_t[]> oldCtrl = std::move(this->ctrl);
+    Slot* oldSlots = this->slots;
+    size_t oldNumSlots = this->numSlots;
+
+    this->ctrl = std::make_unique<uint8_t[]>(newNumSlots);
+    std::memset(this->ctrl.get(), detail::ctrlEmpty, newNumSlots);
+    this->slots = std::allocator<Slot>().allocate(newNumSlots);
+    this->numSlots = newNumSlots;
+    this->growthLeft = capacityToGrowth(newNumSlots) - this->numFull;
+
+    for (size_t idx = 0; idx < oldNumSlots; idx++) {
+      if ((oldCtrl[idx] & 0x80) == 0) {
+        uint64_t hash = oldSlots[idx].key.hash();
+        size_t dst = this->findFree(hash);
+        this->setCtrl(dst, h2(hash));
+        new (&this->slots[dst]) Slot(std::move(oldSlots[idx]));
+        oldSlots[idx].~Slot();
+      }
+    }
+
+    if (oldSlots != nullptr) {
+      std::allocator<Slot>().deallocate(oldSlots, oldNumSlots);
+    }
+  }
+
+  void growIfFull() {
+    if (this->growthLeft == 0) {
+      // if it's mostly tombstones, rehashing in place (same size) frees them
+      size_t target = this->numSlots == 0 ? detail::groupWidth
+        : this->numFull * 2 < capacityToGrowth(this->numSlots)
+          ? this->numSlots
+          : this->numSlots * 2;
+      this->resize(target);
+    }
+  }
+
+  void destroyAll() {
+    for (size_t idx = 0; idx < this->numSlots; idx++) {
+      if ((this->ctrl[idx] & 0x80) == 0) {
+        this->slots[idx].~Slot();
+      }
+    }
+  }
+
+  void release() {
+    this->destroyAll();
+    if (this->slots != nullptr) {
+      std::allocator<Slot>().deallocate(this->slots, this->numSlots);
+    }
+    this->ctrl.reset();
+    this->slots = nullptr;
+    this->numSlots = 0;
+    this->numFull = 0;
+    this->growthLeft = 0;
+  }
+
+public:
+  UuidMap() {}
+
+  explicit UuidMap(size_t capacity) { this->reserve(capacity); }
+
+  UuidMap(const UuidMap& other) {
+    this->reserve(other.size());
+    for (const Slot& slot : other) {
+      this->insert(slot.key, slot.value);
+    }
+  }
+
+  UuidMap(UuidMap&& other) noexcept
+      : ctrl(std::move(other.ctrl)), slots(std::exchange(other.slots, nullptr)),
+        numSlots(std::exchange(other.numSlots, 0)),
+        numFull(std::exchange(other.numFull, 0)),
+        growthLeft(std::exchange(other.growthLeft, 0)) {}
+
+  UuidMap& operator=(UuidMap other) {
+    std::swap(this->ctrl, other.ctrl);
+    std::swap(this->slots, other.slots);
+    std::swap(this->numSlots, other.numSlots);
+    std::swap(this->numFull, other.numFull);
+    std::swap(this->growthLeft, other.growthLeft);
+    return *this;
+  }
+
+  ~UuidMap() { this->release(); }
+
+  size_t size() const { return this->numFull; }
+  bool empty() const { return this->numFull == 0; }
+
+  /// Number of entries the table can hold before it has to grow
+  size_t capacity() const { return capacityToGrowth(this->numSlots); }
+
+  /// Makes room for at least `count` entries without further growth
+  void reserve(size_t count) {
+    if (count <= this->capacity()) {
+      return;
+    }
+    size_t needed = std::bit_ceil(count + count / 7 + 1);
+    this->resize(std::max(needed, detail::groupWidth));
+  }
+
+  /// Removes every entry, keeping the allocated capacity
+  void clear() {
+    this->destroyAll();
+    if (this->numSlots != 0) {
+      std::memset(this->ctrl.get(), detail::ctrlEmpty, this->numSlots);
+    }
+    this->numFull = 0;
+    this->growthLeft = capacityToGrowth(this->numSlots);
+  }
+
+  /// Inserts `key` with a value constructed from `args` if it isn't present.
+  /// Returns the entry's value and whether it was inserted.
+  template <typename... Args>
+  std::pair<V*, bool> tryEmplace(const Uuid& key, Args&&... args) {
+    uint64_t hash = key.hash();
+    size_t idx = this->findIndex(key, hash);
+    if (idx != this->numSlots) {
+      return {&this->slots[idx].value, false};
+    }
+
+    this->growIfFull();
+    idx = this->findFree(hash);
+    // the slot is only marked full once the value is built, so a throwing
+    // constructor leaves the map as it was
+    new (&this->slots[idx]) Slot{key, V(std::forward<Args>(args)...)};
+    if (this->ctrl[idx] == detail::ctrlEmpty) {
+      // reusing a tombstone doesn't eat into our growth budget
+      this->growthLeft--;
+    }
+    this->setCtrl(idx, h2(hash));
+    this->numFull++;
+    return {&this->slots[idx].value, true};
+  }
+
+  /// Inserts `key` -> `value` if `key` isn't present, returns whether it was
+  bool insert(const Uuid& key, V value) {
+    return this->tryEmplace(key, std::move(value)).second;
+  }
+
+  /// Inserts or overwrites `key` -> `value`
+  void insertOrAssign(const Uuid& key, V value) {
+    auto [val, inserted] = this->tryEmplace(key, std::move(value));
+    if (!inserted) {
+      *val = std::move(value);
+    }
+  }
+
+  V& operator[](const Uuid& key) { return *this->tryEmplace(key).first; }
+
+  /// Pointer to the value for `key`, or nullptr if not present
+  V* find(const Uuid& key) {
+    size_t idx = this->findIndex(key, key.hash());
+    return idx == this->numSlots ? nullptr : &this->slots[idx].value;
+  }
+
+  const V* find(const Uuid& key) const {
+    size_t idx = this->findIndex(key, key.hash());
+    return idx == this->numSlots ? nullptr : &this->slots[idx].value;
+  }
+
+  bool contains(const Uuid& key) const {
+    return this->findIndex(key, key.hash()) != this->numSlots;
+  }
+
+  /// Removes `key`, returns whether it was present
+  bool erase(const Uuid& key) {
+    size_t idx = this->findIndex(key, key.hash());
+    if (idx == this->numSlots) {
+      return false;
+    }
+
+    this->slots[idx].~Slot();
+    this->numFull--;
+
+    // probes stop at the first group with an empty slot. if this group already
+    // has one, no probe sequence passes through it and the slot can go back to
+    // empty, otherwise it has to become a tombstone.
+    size_t base = idx & ~(detail::groupWidth - 1);
+    if (detail::Group(this->ctrl.get() + base).matchEmpty() != 0) {
+      this->setCtrl(idx, detail::ctrlEmpty);
+      this->growthLeft++;
+    } else {
+      this->setCtrl(idx, detail::ctrlDeleted);
+    }
+    return true;
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, this->numSlots); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, this->numSlots); }
+};
+
+/// A flat, open-addressing hash set of Uuids, see UuidMap
+class UuidSet {
+private:
+  UuidMap<detail::Empty> map;
+
+public:
+  class Iter {
+  private:
+    UuidMap<detail::Empty>::const_iterator inner;
+
+  public:
+    Iter(UuidMap<detail::Empty>::const_iterator inner) : inner(inner) {}
+
+    const Uuid& operator*() const { return (*this->inner).key; }
+    const Uuid* operator->() const { return &(*this->inner).key; }
+
+    Iter& operator++() {
+      ++this->inner;
+      return *this;
+    }
+
+    bool operator==(const Iter& rhs) const { return this->inner == rhs.inner; }
+    bool operator!=(const Iter& rhs) const { return !operator==(rhs); }
+  };
+
+  UuidSet() {}
+  explicit UuidSet(size_t capacity) : map(capacity) {}
+
+  size_t size() const { return this->map.size(); }
+  bool empty() const { return this->map.empty(); }
+  size_t capacity() const { return this->map.capacity(); }
+  void reserve(size_t count) { this->map.reserve(count); }
+  void clear() { this->map.clear(); }
+
+  /// Returns whether `key` was newly inserted
+  bool insert(const Uuid& key) { return this->map.tryEmplace(key).second; }
+  bool contains(const Uuid& key) const { return this->map.contains(key); }
+  bool erase(const Uuid& key) { return this->map.erase(key); }
+
+  Iter begin() const { return Iter(this->map.begin()); }
+  Iter end() const { return Iter(this->map.end()); }
+};
+
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_MAP_H
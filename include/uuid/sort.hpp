@@ -0,0 +1,337 @@
+#ifndef OASIS_UUID_SORT_H
+#define OASIS_UUID_SORT_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "../uuid.hpp"
+
+namespace oasis {
+namespace uuid {
+namespace detail {
+
+// radix sort over the 128-bit ordering key (see Uuid::operator<=>), a byte at
+// a time.
+//
+// a plain LSD sort over a large array is bound by its scatters, every pass
+// writes to 256 places spread over the whole array. so the array is first
+// split, in parallel, on its most significant varying byte:
+//   1. every thread counts every byte of the keys in its chunk of the array,
+//      which tells us which bytes are the same for every key (v7 ids made
+//      close together share most of their timestamp bytes)
+//   2. every thread counts the top varying byte in its chunk, works out where
+//      its keys land for each value of it (all keys with a smaller byte, plus
+//      the same byte in earlier chunks) and scatters its chunk there
+// after which the 256 buckets are in their final order relative to each
+// other. threads then claim buckets one at a time and LSD sort each on the
+// remaining bytes. a bucket that's still too big to stay in cache is split
+// again first.
+class UuidRadixSorter {
+private:
+  static constexpr size_t numDigits = 16;
+  static constexpr size_t numBuckets = 256;
+  // ranges up to this size are LSD sorted in place, ~512KB of ids
+  static constexpr size_t cacheSizedIds = 32 * 1024;
+  // ranges up to this size just use std::sort
+  static constexpr size_t smallIds = 64;
+
+  using Histogram = std::array<size_t, numBuckets>;
+  using DigitHistograms = std::array<Histogram, numDigits>;
+
+  std::span<Uuid> data;
+  std::span<Uuid> scratch;
+  size_t numThreads;
+  bool unique;
+
+  std::barrier<> barrier;
+
+  // per thread, counts of every digit, used to find the varying ones
+  std::vector<DigitHistograms> digitCounts;
+
+  // the digit the top level split is on, or numDigits if every key is equal
+  size_t topDigit = numDigits;
+  // where each top level bucket starts, with the end of the array at the end
+  std::array<size_t, numBuckets + 1> bucketStarts{};
+  std::atomic<size_t> nextBucket = 0;
+  // sortUnique, number of unique ids left at the front of each bucket
+  std::array<size_t, numBuckets> bucketUnique{};
+
+  size_t uniqueSize = 0;
+
+  static inline uint8_t digit(const Uuid& uuid, size_t d) {
+    uint64_t word = d < 8 ? uuid.hi : uuid.orderingHi();
+    return (word >> (8 * (d % 8))) & 0xFF;
+  }
+
+  static void countDigits(const Uuid* ids, size_t n, DigitHistograms& counts) {
+    for (auto& histogram : counts) {
+      histogram.fill(0);
+    }
+    for (size_t idx = 0; idx < n; idx++) {
+      uint64_t lo = ids[idx].hi;
+      uint64_t hi = ids[idx].orderingHi();
+      for (size_t d = 0; d < 8; d++) {
+        counts[d][(lo >> (8 * d)) & 0xFF]++;
+        counts[d + 8][(hi >> (8 * d)) & 0xFF]++;
+      }
+    }
+  }
+
+  static bool isConstant(const Histogram& histogram, size_t n) {
+    return std::ranges::any_of(histogram, [n](size_t c) { return c == n; });
+  }
+
+  // stable scatter of src[0, n) into dst on digit `d`, given its counts
+  static void scatter(const Uuid* src, Uuid* dst, size_t n, size_t d,
+                      const Histogram& counts) {
+    Histogram offsets;
+    size_t running = 0;
+    for (size_t b = 0; b < numBuckets; b++) {
+      offsets[b] = running;
+      running += counts[b];
+    }
+    for (size_t idx = 0; idx < n; idx++) {
+      dst[offsets[digit(src[idx], d)]++] = src[idx];
+    }
+  }
+
+  // sorts src[0, n) on the digits below `below`, every higher digit being
+  // equal across the range. `tmp` is scratch space of the same size. the
+  // sorted ids end up back in `src`.
+  static void sortRange(Uuid* src, Uuid* tmp, size_t n, size_t below) {
+    if (n <= smallIds) {
+      std::sort(src, src + n);
+      return;
+    }
+
+    DigitHistograms counts;
+    countDigits(src, n, counts);
+
+    size_t varying[numDigits];
+    size_t numVarying = 0;
+    for (size_t d = 0; d < below; d++) {
+      if (!isConstant(counts[d], n)) {
+        varying[numVarying++] = d;
+      }
+    }
+
+    if (numVarying == 0) {
+      return;
+    }
+
+    if (n <= cacheSizedIds) {
+      // counts of the whole range don't change as it's permuted, so one
+      // counting pass serves every LSD pass
+      Uuid* from = src;
+      Uuid* to = tmp;
+      for (size_t v = 0; v < numVarying; v++) {
+        scatter(from, to, n, varying[v], counts[varying[v]]);
+        std::swap(from, to);
+      }
+      if (from != src) {
+        std::copy(from, from + n, src);
+      }
+      return;
+    }
+
+    size_t top = varying[numVarying - 1];
+    scatter(src, tmp, n, top, counts[top]);
+    std::copy(tmp, tmp + n, src);
+
+    size_t start = 0;
+    for (size_t b = 0; b < numBuckets; b++) {
+      sortRange(src + start, tmp + start, counts[top][b], top);
+      start += counts[top][b];
+    }
+  }
+
+  std::pair<size_t, size_t> chunk(size_t threadIdx) const {
+    size_t per = (this->data.size() + this->numThreads - 1) / this->numThreads;
+    size_t begin = std::min(this->data.size(), threadIdx * per);
+    size_t end = std::min(this->data.size(), begin + per);
+    return {begin, end};
+  }
+
+  // run by thread 0 alone, between barriers
+  void findTopDigit() {
+    for (size_t d = numDigits; d-- > 0;) {
+      Histogram total{};
+      for (size_t t = 0; t < this->numThreads; t++) {
+        for (size_t b = 0; b < numBuckets; b++) {
+          total[b] += this->digitCounts[t][d][b];
+        }
+      }
+
+      if (!isConstant(total, this->data.size())) {
+        this->topDigit = d;
+        size_t running = 0;
+        for (size_t b = 0; b < numBuckets; b++) {
+          this->bucketStarts[b] = running;
+          running += total[b];
+        }
+        this->bucketStarts[numBuckets] = running;
+        return;
+      }
+    }
+  }
+
+  // the parallel top level split, data -> scratch. each thread's counts for
+  // its chunk were published by the barrier after counting.
+  void split(size_t threadIdx) {
+    auto [begin, end] = this->chunk(threadIdx);
+    size_t d = this->topDigit;
+
+    Histogram offsets;
+    for (size_t b = 0; b < numBuckets; b++) {
+      offsets[b] = this->bucketStarts[b];
+      for (size_t t = 0; t < threadIdx; t++) {
+        offsets[b] += this->digitCounts[t][d][b];
+      }
+    }
+
+    for (size_t idx = begin; idx < end; idx++) {
+      this->scratch[offsets[digit(this->data[idx], d)]++] = this->data[idx];
+    }
+    this->barrier.arrive_and_wait();
+  }
+
+  void sortBuckets() {
+    for (size_t b = this->nextBucket.fetch_add(1); b < numBuckets;
+         b = this->nextBucket.fetch_add(1)) {
+      size_t start = this->bucketStarts[b];
+      size_t n = this->bucketStarts[b + 1] - start;
+
+      // sort in scratch (where the split left it) while it's hot, then move
+      // it home
+      Uuid* sorted = this->scratch.data() + start;
+      sortRange(sorted, this->data.data() + start, n, this->topDigit);
+      std::copy(sorted, sorted + n, this->data.data() + start);
+
+      if (this->unique) {
+        Uuid* bucket = this->data.data() + start;
+        this->bucketUnique[b] = std::unique(bucket, bucket + n) - bucket;
+      }
+    }
+  }
+
+  // run by thread 0 alone once every bucket is sorted
+  void compactBuckets() {
+    size_t out = 0;
+    for (size_t b = 0; b < numBuckets; b++) {
+      Uuid* bucket = this->data.data() + this->bucketStarts[b];
+      std::memmove(this->data.data() + out, bucket,
+                   this->bucketUnique[b] * sizeof(Uuid));
+      out += this->bucketUnique[b];
+    }
+    this->uniqueSize = out;
+  }
+
+  void run(size_t threadIdx) {
+    auto [begin, end] = this->chunk(threadIdx);
+    countDigits(this->data.data() + begin, end - begin,
+                this->digitCounts[threadIdx]);
+    this->barrier.arrive_and_wait();
+    if (threadIdx == 0) {
+      this->findTopDigit();
+    }
+    this->barrier.arrive_and_wait();
+
+    if (this->topDigit == numDigits) {
+      // every id is the same
+      if (threadIdx == 0) {
+        this->uniqueSize = std::min<size_t>(this->data.size(), 1);
+      }
+      return;
+    }
+
+    this->split(threadIdx);
+    this->sortBuckets();
+
+    if (this->unique) {
+      this->barrier.arrive_and_wait();
+      if (threadIdx == 0) {
+        this->compactBuckets();
+      }
+    }
+  }
+
+public:
+  UuidRadixSorter(std::span<Uuid> data, std::span<Uuid> scratch,
+                  size_t numThreads, bool unique)
+      : data(data), scratch(scratch), numThreads(numThreads), unique(unique),
+        barrier(numThreads), digitCounts(numThreads) {}
+
+  /// Sorts, returning the number of ids left (the unique prefix if deduping)
+  size_t sort() {
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < this->numThreads; t++) {
+      threads.emplace_back(&UuidRadixSorter::run, this, t);
+    }
+    this->run(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    return this->unique ? this->uniqueSize : this->data.size();
+  }
+};
+
+// below this many ids per thread, extra threads cost more than they save
+inline constexpr size_t minIdsPerSortThread = 64 * 1024;
+// below this many ids, std::sort beats the fixed cost of the histograms
+inline constexpr size_t minIdsForRadixSort = 4 * 1024;
+
+inline size_t sortThreads(size_t size, size_t numThreads) {
+  if (numThreads == 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return std::clamp<size_t>(size / minIdsPerSortThread, 1, numThreads);
+}
+
+}; // namespace detail
+
+/// Sorts `uuids` (see Uuid::operator<=>) with a parallel radix sort: an MSD
+/// split on the top varying byte, then LSD passes over each bucket.
+/// `numThreads` of 0 uses every hardware thread; fewer are used for small
+/// inputs. Allocates a scratch buffer the size of the input.
+inline void radixSort(std::span<Uuid> uuids, size_t numThreads = 0) {
+  if (uuids.size() < detail::minIdsForRadixSort) {
+    std::sort(uuids.begin(), uuids.end());
+    return;
+  }
+
+  std::vector<Uuid> scratch(uuids.size());
+  detail::UuidRadixSorter sorter(uuids, scratch,
+                                 detail::sortThreads(uuids.size(), numThreads),
+                                 false);
+  sorter.sort();
+}
+
+/// Sorts `uuids` and removes duplicates in the same parallel job, leaving
+/// the unique ids in order at the front. Each bucket is deduplicated as soon
+/// as it's sorted, while it's still in cache, so the only extra pass is the
+/// final compaction. Returns how many unique ids there are; the contents
+/// past that are unspecified.
+inline size_t sortUnique(std::span<Uuid> uuids, size_t numThreads = 0) {
+  if (uuids.size() < detail::minIdsForRadixSort) {
+    std::sort(uuids.begin(), uuids.end());
+    return std::unique(uuids.begin(), uuids.end()) - uuids.begin();
+  }
+
+  std::vector<Uuid> scratch(uuids.size());
+  detail::UuidRadixSorter sorter(uuids, scratch,
+                                 detail::sortThreads(uuids.size(), numThreads),
+                                 true);
+  return sorter.sort();
+}
+
+}; // namespace uuid
+}; // namespace oasis
+
+#endif // OASIS_UUID_SORT_H
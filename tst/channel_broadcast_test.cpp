@@ -0,0 +1,180 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sync/broadcast.hpp"
+
+using oasis::sync::channel::ChannelError;
+using oasis::sync::channel::mkBroadcast;
+using oasis::sync::channel::Overflow;
+
+TEST(BroadcastTest, EverySubscriberSeesEveryMessage) {
+  auto [publisher, first] = mkBroadcast<std::string>(4);
+  auto second = publisher.subscribe();
+  publisher.publish("a");
+  publisher.emplace(2, 'b');
+
+  EXPECT_EQ("a", first.recv().value());
+  EXPECT_EQ("bb", first.recv().value());
+  EXPECT_EQ("a", second.recv().value());
+  EXPECT_EQ("bb", second.tryRecv().value().value());
+  EXPECT_FALSE(second.tryRecv().value().has_value());
+}
+
+TEST(BroadcastTest, SubscribersStartAtTheNextMessage) {
+  auto [publisher, first] = mkBroadcast<uint32_t>(4);
+  publisher.publish(1);
+  auto late = publisher.subscribe();
+  publisher.publish(2);
+
+  EXPECT_EQ(1, first.recv().value());
+  EXPECT_EQ(2, late.recv().value());
+}
+
+TEST(BroadcastTest, PollReadsInPlace) {
+  auto [publisher, subscriber] = mkBroadcast<uint32_t>(8);
+  std::vector<uint32_t> batch = {1, 2, 3, 4, 5};
+  publisher.publishMany(batch);
+
+  std::vector<uint32_t> seen;
+  EXPECT_EQ(3, subscriber.poll([&](const uint32_t& val) { seen.push_back(val); }, 3).value());
+  EXPECT_EQ(2, subscriber.poll([&](const uint32_t& val) { seen.push_back(val); }).value());
+  EXPECT_EQ(0, subscriber.poll([&](const uint32_t& val) { seen.push_back(val); }).value());
+  EXPECT_EQ(batch, seen);
+}
+
+TEST(BroadcastTest, DroppingPublisherDrainsThenShutsDown) {
+  auto [publisher, subscriber] = mkBroadcast<uint32_t>(4);
+  publisher.publish(1);
+  publisher = {};
+
+  EXPECT_EQ(1, subscriber.recv().value());
+  EXPECT_EQ(ChannelError::Shutdown, subscriber.recv().error());
+  EXPECT_EQ(ChannelError::Shutdown, subscriber.tryRecv().error());
+}
+
+TEST(BroadcastTest, RecvForTimesOut) {
+  auto [publisher, subscriber] = mkBroadcast<uint32_t>(4);
+  EXPECT_EQ(ChannelError::Timeout, subscriber.recvFor(std::chrono::milliseconds(5)).error());
+}
+
+TEST(BroadcastTest, BlockWaitsForSlowestSubscriber) {
+  auto [publisher, fast] = mkBroadcast<uint32_t>(2);
+  auto slow = publisher.subscribe();
+  std::atomic<uint32_t> sent = 0;
+  std::thread producer([&, publisher = std::move(publisher)]() mutable {
+    for (uint32_t i = 0; i < 4; i++) {
+      publisher.publish(i);
+      sent++;
+    }
+  });
+  for (uint32_t i = 0; i < 2; i++) {
+    EXPECT_EQ(i, fast.recv().value());
+  }
+  // the ring is full of what slow hasn't read
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(2, sent.load());
+
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_EQ(i, slow.recv().value());
+  }
+  for (uint32_t i = 2; i < 4; i++) {
+    EXPECT_EQ(i, fast.recv().value());
+  }
+  producer.join();
+  EXPECT_EQ(0, slow.dropped());
+}
+
+TEST(BroadcastTest, UnsubscribingReleasesBlockedPublisher) {
+  auto [publisher, subscriber] = mkBroadcast<uint32_t>(2);
+  std::thread producer([publisher = std::move(publisher)]() mutable {
+    for (uint32_t i = 0; i < 8; i++) {
+      publisher.publish(i);
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  subscriber = {};
+  producer.join();
+}
+
+TEST(BroadcastTest, DropOldestSkipsSlowSubscriber) {
+  auto [publisher, subscriber] = mkBroadcast<uint32_t, Overflow::DropOldest>(4);
+  for (uint32_t i = 0; i < 10; i++) {
+    publisher.publish(i);
+  }
+  EXPECT_EQ(6, subscriber.recv().value());
+  EXPECT_EQ(6, subscriber.dropped());
+  EXPECT_EQ(7, subscriber.recv().value());
+}
+
+TEST(BroadcastTest, DestroysMessagesLeftInRing) {
+  auto payload = std::make_shared<int>(0);
+  {
+    auto [publisher, subscriber] = mkBroadcast<std::shared_ptr<int>>(4);
+    publisher.publish(payload);
+    publisher.publish(payload);
+    EXPECT_EQ(3, payload.use_count());
+  }
+  EXPECT_EQ(1, payload.use_count());
+}
+
+// subscribers each see the whole stream in order, while a DropOldest one only
+// sees it in order, with the gaps counted
+TEST(BroadcastTest, ConcurrentSubscribers) {
+  const uint32_t count = 100000;
+  auto [publisher, first] = mkBroadcast<uint32_t>(64);
+  std::vector<decltype(first)> subscribers;
+  subscribers.push_back(std::move(first));
+  for (int i = 0; i < 3; i++) {
+    subscribers.push_back(publisher.subscribe());
+  }
+
+  std::vector<std::thread> readers;
+  for (auto& subscriber : subscribers) {
+    readers.emplace_back([&subscriber]() {
+      for (uint32_t i = 0; i < count; i++) {
+        ASSERT_EQ(i, subscriber.recv().value());
+      }
+      EXPECT_EQ(ChannelError::Shutdown, subscriber.recv().error());
+    });
+  }
+  std::vector<uint32_t> batch(16);
+  for (uint32_t i = 0; i < count; i += batch.size()) {
+    for (uint32_t j = 0; j < batch.size(); j++) {
+      batch[j] = i + j;
+    }
+    publisher.publishMany(batch);
+  }
+  publisher = {};
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+}
+
+TEST(BroadcastTest, ConcurrentDropOldest) {
+  const uint32_t count = 100000;
+  auto [publisher, subscriber] = mkBroadcast<uint32_t, Overflow::DropOldest>(16);
+  std::thread reader([&]() {
+    uint32_t received = 0;
+    int64_t last = -1;
+    while (true) {
+      std::expected<uint32_t, ChannelError> val = subscriber.recv();
+      if (!val) {
+        break;
+      }
+      ASSERT_LT(last, static_cast<int64_t>(*val));
+      last = *val;
+      received++;
+    }
+    EXPECT_EQ(count, received + subscriber.dropped());
+  });
+  for (uint32_t i = 0; i < count; i++) {
+    publisher.publish(i);
+  }
+  publisher = {};
+  reader.join();
+}
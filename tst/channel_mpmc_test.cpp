@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sync/mpmc.hpp"
+
+using oasis::sync::channel::ChannelError;
+using oasis::sync::channel::mkMpmcChannel;
+
+TEST(MpmcChannelTest, RecvInSendOrder) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(8);
+  for (uint32_t i = 0; i < 8; i++) {
+    sender.send(i);
+  }
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+  EXPECT_FALSE(receiver.tryRecv().value().has_value());
+}
+
+TEST(MpmcChannelTest, TrySendFailsWhenFull) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(4);
+  for (uint32_t i = 0; i < 4; i++) {
+    uint32_t val = i;
+    EXPECT_TRUE(sender.trySend(val));
+  }
+  uint32_t val = 4;
+  EXPECT_FALSE(sender.trySend(val));
+  EXPECT_EQ(0, receiver.recv().value());
+  EXPECT_TRUE(sender.trySend(val));
+}
+
+// every message is received exactly once, whichever threads race for it
+TEST(MpmcChannelTest, ManyProducersManyConsumers) {
+  auto [sender, receiver] = mkMpmcChannel<uint64_t>(64);
+  const uint64_t perProducer = 50'000;
+  const size_t producers = 4;
+  const size_t consumers = 4;
+
+  std::vector<std::vector<uint64_t>> received(consumers);
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; p++) {
+    threads.emplace_back([sender, p]() mutable {
+      for (uint64_t i = 0; i < perProducer; i++) {
+        sender.send(p * perProducer + i);
+      }
+    });
+  }
+  for (size_t c = 0; c < consumers; c++) {
+    threads.emplace_back([receiver, &received, c]() mutable {
+      for (uint64_t i = 0; i < perProducer * producers / consumers; i++) {
+        received[c].push_back(receiver.recv().value());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<uint64_t> all;
+  for (const auto& part : received) {
+    // a consumer sees each producer's messages in order
+    std::vector<uint64_t> last(producers, 0);
+    for (uint64_t val : part) {
+      EXPECT_GE(val + 1, last[val / perProducer]);
+      last[val / perProducer] = val + 1;
+    }
+    all.insert(all.end(), part.begin(), part.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(perProducer * producers, all.size());
+  for (uint64_t i = 0; i < all.size(); i++) {
+    ASSERT_EQ(i, all[i]);
+  }
+}
+
+TEST(MpmcChannelTest, ParkedReceiversAllWake) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(8);
+  std::atomic<uint32_t> sum = 0;
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 3; c++) {
+    consumers.emplace_back([receiver, &sum]() mutable { sum += receiver.recv().value(); });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  sender.send(1);
+  sender.send(2);
+  sender.send(3);
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  EXPECT_EQ(6, sum.load());
+}
+
+// built in place in its cell, slowly if asked, which holds the cell back
+// from being published while later ones are
+struct SlowToBuild {
+  uint32_t val;
+
+  SlowToBuild(uint32_t val, bool slow) noexcept : val(val) {
+    if (slow) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+};
+
+TEST(MpmcChannelTest, ParkedReceiversWakeForOutOfOrderPublishes) {
+  // every receiver parks for one message. the first sender claims the first
+  // cell and is slow to fill it, the others publish the cells behind it,
+  // and the receivers they wake find the first cell empty and sleep again.
+  // when the first message lands, every receiver still has to get one
+  const uint32_t receivers = 4;
+  for (uint32_t round = 0; round < 5; round++) {
+    auto [sender, receiver] = mkMpmcChannel<SlowToBuild>(8);
+    receiver.setWaitStrategy({});
+
+    std::atomic<uint32_t> received = 0;
+    std::vector<std::thread> consumers;
+    for (uint32_t r = 0; r < receivers; r++) {
+      consumers.emplace_back([receiver, &received]() mutable {
+        if (receiver.recv().has_value()) {
+          received.fetch_add(1);
+        }
+      });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::thread slow([sender]() mutable { sender.emplace(0, true); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    for (uint32_t i = 1; i < receivers; i++) {
+      sender.emplace(i, false);
+    }
+    slow.join();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received.load() < receivers && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(receivers, received.load()) << "round " << round;
+
+    sender.shutdown();
+    for (auto& consumer : consumers) {
+      consumer.join();
+    }
+  }
+}
+
+TEST(MpmcChannelTest, SendParksUntilSpaceFrees) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(2);
+  sender.send(1);
+  sender.send(2);
+  std::thread consumer([receiver]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(1, receiver.recv().value());
+  });
+  sender.send(3);
+  consumer.join();
+  EXPECT_EQ(2, receiver.recv().value());
+  EXPECT_EQ(3, receiver.recv().value());
+}
+
+TEST(MpmcChannelTest, ShutdownWakesEveryBlockedThread) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(2);
+  std::atomic<int> shutdowns = 0;
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 3; c++) {
+    consumers.emplace_back([receiver, &shutdowns]() mutable {
+      std::expected<uint32_t, ChannelError> t = receiver.recv();
+      if (!t.has_value() && t.error() == ChannelError::Shutdown) {
+        shutdowns++;
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  sender.shutdown();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  EXPECT_EQ(3, shutdowns.load());
+  EXPECT_FALSE(receiver.tryRecv().has_value());
+}
+
+TEST(MpmcChannelTest, DestroysQueuedMessages) {
+  auto payload = std::make_shared<int>(0);
+  {
+    auto [sender, receiver] = mkMpmcChannel<std::shared_ptr<int>>(4);
+    sender.send(payload);
+    sender.send(payload);
+    EXPECT_EQ(3, payload.use_count());
+  }
+  EXPECT_EQ(1, payload.use_count());
+}
+
+TEST(MpmcChannelTest, MoveOnlyPayloads) {
+  auto [sender, receiver] = mkMpmcChannel<std::unique_ptr<int>>(4);
+  sender.send(std::make_unique<int>(1));
+  sender.emplace(new int(2));
+  auto three = std::make_unique<int>(3);
+  EXPECT_TRUE(sender.trySend(three));
+  EXPECT_EQ(nullptr, three);
+
+  EXPECT_EQ(1, *receiver.recv().value());
+  EXPECT_EQ(2, *receiver.tryRecv().value().value());
+  EXPECT_EQ(3, *receiver.recv().value());
+}
+
+TEST(MpmcChannelTest, EmplaceWithThrowingConstructorLeavesChannelUsable) {
+  struct Picky {
+    int value;
+    explicit Picky(int value) : value(value) {
+      if (value < 0) {
+        throw std::invalid_argument("negative");
+      }
+    }
+  };
+  auto [sender, receiver] = mkMpmcChannel<Picky>(4);
+  EXPECT_THROW(sender.emplace(-1), std::invalid_argument);
+  sender.emplace(1);
+  EXPECT_EQ(1, receiver.recv().value().value);
+}
+
+TEST(MpmcChannelTest, DroppingSenderDrainsThenShutsDown) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(4);
+  sender.send(1);
+  sender.send(2);
+  sender = {};
+
+  EXPECT_EQ(1, receiver.recv().value());
+  EXPECT_EQ(2, receiver.tryRecv().value().value());
+  EXPECT_EQ(ChannelError::Shutdown, receiver.recv().error());
+  EXPECT_EQ(ChannelError::Shutdown, receiver.tryRecv().error());
+}
+
+TEST(MpmcChannelTest, DroppingSenderWakesBlockedReceiver) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(4);
+  std::thread producer([sender = std::move(sender)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sender.send(1);
+  });
+  EXPECT_EQ(1, receiver.recv().value());
+  EXPECT_EQ(ChannelError::Shutdown, receiver.recv().error());
+  producer.join();
+}
+
+TEST(MpmcChannelTest, DroppingReceiversWakesBlockedSender) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(2);
+  auto other = receiver;
+  sender.send(1);
+  sender.send(2);
+  std::thread blocked([&sender]() { sender.send(3); });
+
+  // the channel only shuts down once the last receiver is gone
+  receiver = {};
+  uint32_t val = 3;
+  EXPECT_FALSE(sender.trySend(val));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  other = {};
+  blocked.join();
+  EXPECT_FALSE(sender.trySend(val));
+}
+
+TEST(MpmcChannelTest, RecvForTimesOut) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(4);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(ChannelError::Timeout, receiver.recvFor(std::chrono::milliseconds(5)).error());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+
+  sender.send(1);
+  EXPECT_EQ(1, receiver.recvUntil(std::chrono::system_clock::now()).value());
+}
+
+TEST(MpmcChannelTest, RecvForWakesOnSend) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(4);
+  std::thread producer([sender]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sender.send(1);
+  });
+  EXPECT_EQ(1, receiver.recvFor(std::chrono::seconds(10)).value());
+  producer.join();
+}
+
+TEST(MpmcChannelTest, SpinningReceiver) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(4);
+  receiver.setWaitStrategy({.spins = 1 << 16, .yields = 1 << 4});
+  EXPECT_EQ(1 << 16, receiver.waitStrategy().spins);
+  std::thread producer([sender]() mutable {
+    for (uint32_t i = 0; i < 1000; i++) {
+      sender.send(i);
+    }
+  });
+  for (uint32_t i = 0; i < 1000; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+  producer.join();
+  EXPECT_EQ(ChannelError::Timeout, receiver.recvFor(std::chrono::milliseconds(1)).error());
+}
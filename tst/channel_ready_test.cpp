@@ -0,0 +1,172 @@
+#include <atomic>
+#include <chrono>
+#include <poll.h>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sync/channel.hpp"
+#include "sync/mpmc.hpp"
+#include "sync/ready.hpp"
+#include "sync/spsc.hpp"
+
+using oasis::sync::ReadyFd;
+using oasis::sync::channel::ChannelError;
+using oasis::sync::channel::mkChannel;
+using oasis::sync::channel::mkMpmcChannel;
+using oasis::sync::channel::mkSpscChannel;
+
+// whether `fd` polls readable within `timeoutMs`
+static bool readable(int fd, int timeoutMs = 0) {
+  struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+  return poll(&pfd, 1, timeoutMs) == 1 && (pfd.revents & POLLIN);
+}
+
+TEST(ReadyFdTest, SignalsUntilCleared) {
+  ReadyFd ready;
+  EXPECT_FALSE(readable(ready.fd()));
+  EXPECT_FALSE(ready.clear());
+
+  ready.signal();
+  ready.signal();
+  EXPECT_TRUE(readable(ready.fd()));
+  EXPECT_TRUE(ready.clear());
+  EXPECT_FALSE(readable(ready.fd()));
+
+  ready.signal();
+  EXPECT_TRUE(readable(ready.fd()));
+}
+
+TEST(ReadyFdTest, ClearRacingSignal) {
+  // a clear that lands between a signal raising the flag and its write
+  // mustn't leave the fd readable for good: once both sides are done, one
+  // more clear always makes it unreadable, and a signal readable again
+  ReadyFd ready;
+  for (uint32_t round = 0; round < 200; round++) {
+    std::thread signaller([&]() {
+      for (uint32_t i = 0; i < 2000; i++) {
+        ready.signal();
+      }
+    });
+    for (uint32_t i = 0; i < 2000; i++) {
+      ready.clear();
+    }
+    signaller.join();
+
+    bool wasReadable = readable(ready.fd());
+    bool cleared = ready.clear();
+    if (wasReadable) {
+      ASSERT_TRUE(cleared) << "round " << round;
+    }
+    ASSERT_FALSE(readable(ready.fd())) << "round " << round;
+    ready.signal();
+    ASSERT_TRUE(readable(ready.fd())) << "round " << round;
+    ready.clear();
+  }
+}
+
+// the same walk through for every kind of channel: readable once a message
+// arrives, until a receive finds it empty
+template <typename S, typename R> static void checkReadiness(S& sender, R& receiver) {
+  int fd = receiver.readyFd();
+  EXPECT_EQ(fd, receiver.readyFd());
+  EXPECT_FALSE(readable(fd));
+
+  sender.send(1);
+  sender.send(2);
+  EXPECT_TRUE(readable(fd));
+  EXPECT_EQ(1, receiver.tryRecv().value().value());
+  EXPECT_TRUE(readable(fd));
+  EXPECT_EQ(2, receiver.tryRecv().value().value());
+  EXPECT_TRUE(readable(fd));
+  EXPECT_FALSE(receiver.tryRecv().value().has_value());
+  EXPECT_FALSE(readable(fd));
+
+  sender.send(3);
+  EXPECT_TRUE(readable(fd));
+  EXPECT_EQ(3, receiver.recv().value());
+  EXPECT_FALSE(receiver.tryRecv().value().has_value());
+  EXPECT_FALSE(readable(fd));
+
+  sender.shutdown();
+  EXPECT_TRUE(readable(fd));
+}
+
+TEST(ReadyFdTest, Channel) {
+  auto [sender, receiver] = mkChannel<uint32_t>();
+  checkReadiness(sender, receiver);
+}
+
+TEST(ReadyFdTest, SpscChannel) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(8);
+  checkReadiness(sender, receiver);
+}
+
+TEST(ReadyFdTest, MpmcChannel) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(8);
+  checkReadiness(sender, receiver);
+}
+
+TEST(ReadyFdTest, ReadyIfMessagesQueuedBeforehand) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(8);
+  sender.send(1);
+  EXPECT_TRUE(readable(receiver.readyFd()));
+}
+
+TEST(ReadyFdTest, DrainIntoRearms) {
+  auto [sender, receiver] = mkChannel<uint32_t>();
+  int fd = receiver.readyFd();
+  sender.send(1);
+  sender.send(2);
+  std::vector<uint32_t> out;
+  EXPECT_EQ(2, receiver.drainInto(out).value());
+  EXPECT_FALSE(readable(fd));
+}
+
+TEST(ReadyFdTest, DroppingSenderSignals) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(8);
+  int fd = receiver.readyFd();
+  sender = {};
+  EXPECT_TRUE(readable(fd));
+  EXPECT_EQ(ChannelError::Shutdown, receiver.tryRecv().error());
+}
+
+// an event loop style consumer, waiting on the fd and draining with tryRecv,
+// has to get every message without a signal going missing
+template <typename S, typename R> static void checkEventLoop(S& sender, R& receiver) {
+  const uint32_t count = 100000;
+  int fd = receiver.readyFd();
+  std::thread producer([&sender, count]() {
+    for (uint32_t i = 0; i < count; i++) {
+      sender.send(i);
+    }
+  });
+  uint32_t next = 0;
+  while (next < count) {
+    ASSERT_TRUE(readable(fd, 10000));
+    while (true) {
+      std::expected<std::optional<uint32_t>, ChannelError> val = receiver.tryRecv();
+      if (!val.value().has_value()) {
+        break;
+      }
+      ASSERT_EQ(next++, **val);
+    }
+  }
+  producer.join();
+}
+
+TEST(ReadyFdTest, EventLoopChannel) {
+  auto [sender, receiver] = mkChannel<uint32_t>();
+  checkEventLoop(sender, receiver);
+}
+
+TEST(ReadyFdTest, EventLoopSpscChannel) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(64);
+  checkEventLoop(sender, receiver);
+}
+
+TEST(ReadyFdTest, EventLoopMpmcChannel) {
+  auto [sender, receiver] = mkMpmcChannel<uint32_t>(64);
+  checkEventLoop(sender, receiver);
+}
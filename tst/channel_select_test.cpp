@@ -0,0 +1,143 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sync/channel.hpp"
+#include "sync/mpmc.hpp"
+#include "sync/select.hpp"
+#include "sync/spsc.hpp"
+
+using oasis::sync::channel::ChannelError;
+using oasis::sync::channel::mkChannel;
+using oasis::sync::channel::mkMpmcChannel;
+using oasis::sync::channel::mkSpscChannel;
+using oasis::sync::channel::SelectOrder;
+using oasis::sync::channel::Selector;
+
+TEST(SelectTest, ReceivesFromReadyReceiver) {
+  auto [controlTx, control] = mkChannel<std::string>();
+  auto [dataTx, data] = mkSpscChannel<uint64_t>(8);
+  auto [timerTx, timers] = mkMpmcChannel<uint32_t>(8);
+  Selector select;
+
+  dataTx.send(7);
+  auto msg = select.recv(control, data, timers);
+  ASSERT_EQ(1, msg.index());
+  EXPECT_EQ(7, std::get<1>(msg).value());
+
+  controlTx.send("stop");
+  msg = select.recv(control, data, timers);
+  ASSERT_EQ(0, msg.index());
+  EXPECT_EQ("stop", std::get<0>(msg).value());
+}
+
+TEST(SelectTest, BlocksUntilAnySend) {
+  auto [aTx, a] = mkChannel<uint32_t>();
+  auto [bTx, b] = mkMpmcChannel<uint32_t>(8);
+  auto [cTx, c] = mkSpscChannel<uint32_t>(8);
+  std::thread producer([cTx = std::move(cTx)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    cTx.send(3);
+  });
+  Selector select;
+  auto msg = select.recv(a, b, c);
+  ASSERT_EQ(2, msg.index());
+  EXPECT_EQ(3, std::get<2>(msg).value());
+  producer.join();
+}
+
+TEST(SelectTest, FairOrderRotates) {
+  auto [aTx, a] = mkChannel<uint32_t>();
+  auto [bTx, b] = mkChannel<uint32_t>();
+  for (uint32_t i = 0; i < 4; i++) {
+    aTx.send(i);
+    bTx.send(i);
+  }
+  Selector select(SelectOrder::Fair);
+  std::vector<size_t> order;
+  for (int i = 0; i < 4; i++) {
+    order.push_back(select.recv(a, b).index());
+  }
+  EXPECT_EQ((std::vector<size_t>{0, 1, 0, 1}), order);
+}
+
+TEST(SelectTest, PriorityOrderPrefersFirst) {
+  auto [aTx, a] = mkChannel<uint32_t>();
+  auto [bTx, b] = mkChannel<uint32_t>();
+  aTx.send(1);
+  aTx.send(2);
+  bTx.send(3);
+  Selector select(SelectOrder::Priority);
+  EXPECT_EQ(0, select.recv(a, b).index());
+  EXPECT_EQ(0, select.recv(a, b).index());
+  EXPECT_EQ(1, select.recv(a, b).index());
+}
+
+TEST(SelectTest, TimesOut) {
+  auto [aTx, a] = mkChannel<uint32_t>();
+  auto [bTx, b] = mkSpscChannel<uint32_t>(8);
+  Selector select;
+  auto start = std::chrono::steady_clock::now();
+  auto msg = select.recvFor(std::chrono::milliseconds(5), a, b);
+  EXPECT_EQ(ChannelError::Timeout, msg.error());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+
+  bTx.send(1);
+  msg = select.recvUntil(std::chrono::system_clock::now(), a, b);
+  ASSERT_EQ(1, msg.value().index());
+}
+
+TEST(SelectTest, ReportsShutdown) {
+  auto [aTx, a] = mkChannel<uint32_t>();
+  auto [bTx, b] = mkMpmcChannel<uint32_t>(8);
+  std::thread closer([bTx = std::move(bTx)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bTx = {};
+  });
+  Selector select;
+  auto msg = select.recv(a, b);
+  ASSERT_EQ(1, msg.index());
+  EXPECT_EQ(ChannelError::Shutdown, std::get<1>(msg).error());
+  closer.join();
+}
+
+// producers on every kind of channel, the selector has to get every message
+// without a wakeup going missing along the way
+TEST(SelectTest, NoLostWakeups) {
+  const uint32_t perChannel = 20000;
+  auto [aTx, a] = mkChannel<uint32_t>();
+  auto [bTx, b] = mkSpscChannel<uint32_t>(4);
+  auto [cTx, c] = mkMpmcChannel<uint32_t>(4);
+  std::vector<std::thread> producers;
+  producers.emplace_back([aTx]() mutable {
+    for (uint32_t i = 0; i < perChannel; i++) {
+      aTx.send(i);
+    }
+  });
+  producers.emplace_back([&bTx]() {
+    for (uint32_t i = 0; i < perChannel; i++) {
+      bTx.send(i);
+    }
+  });
+  producers.emplace_back([cTx]() mutable {
+    for (uint32_t i = 0; i < perChannel; i++) {
+      cTx.send(i);
+    }
+  });
+
+  Selector select;
+  std::vector<uint32_t> expected(3, 0);
+  for (uint32_t n = 0; n < 3 * perChannel; n++) {
+    auto msg = select.recvFor(std::chrono::seconds(10), a, b, c);
+    ASSERT_TRUE(msg.has_value());
+    size_t idx = msg->index();
+    uint32_t val = std::visit([](auto& v) { return static_cast<uint32_t>(v.value()); }, *msg);
+    EXPECT_EQ(expected[idx]++, val);
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+}
@@ -0,0 +1,233 @@
+#include <chrono>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sync/spsc.hpp"
+
+using oasis::sync::channel::ChannelError;
+using oasis::sync::channel::mkSpscChannel;
+using oasis::sync::channel::SpscReceiver;
+using oasis::sync::channel::SpscSender;
+
+// one sending and one receiving thread: a copy would be a second
+static_assert(!std::is_copy_constructible_v<SpscSender<uint32_t>>);
+static_assert(!std::is_copy_assignable_v<SpscSender<uint32_t>>);
+static_assert(!std::is_copy_constructible_v<SpscReceiver<uint32_t>>);
+static_assert(!std::is_copy_assignable_v<SpscReceiver<uint32_t>>);
+static_assert(std::is_nothrow_move_constructible_v<SpscSender<uint32_t>>);
+static_assert(std::is_nothrow_move_constructible_v<SpscReceiver<uint32_t>>);
+
+// the batch operations are Channel only, and don't show up here at all
+template <typename R> concept CanDrain = requires(R &rx, std::vector<uint32_t> &out) { rx.drainInto(out); };
+template <typename R> concept CanRecvMany = requires(R &rx, uint32_t *out) { rx.recvMany(out, 1); };
+template <typename S> concept CanSendMany = requires(S &tx, std::span<uint32_t> vals) { tx.sendMany(vals); };
+template <typename S> concept CanTrySend = requires(S &tx, uint32_t &val) { tx.trySend(val); };
+static_assert(!CanDrain<SpscReceiver<uint32_t>>);
+static_assert(!CanRecvMany<SpscReceiver<uint32_t>>);
+static_assert(!CanSendMany<SpscSender<uint32_t>>);
+static_assert(CanTrySend<SpscSender<uint32_t>>);
+
+TEST(SpscChannelTest, RecvInSendOrder) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(8);
+  for (uint32_t i = 0; i < 5; i++) {
+    sender.send(i);
+  }
+  for (uint32_t i = 0; i < 5; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+}
+
+TEST(SpscChannelTest, TryRecvReturnsEmptyOptionalIfEmpty) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(8);
+  std::expected<std::optional<uint32_t>, ChannelError> t = receiver.tryRecv();
+  ASSERT_TRUE(t.has_value());
+  EXPECT_FALSE(t.value().has_value());
+
+  sender.send(42);
+  t = receiver.tryRecv();
+  ASSERT_TRUE(t.has_value());
+  EXPECT_EQ(42, t.value().value());
+}
+
+TEST(SpscChannelTest, TrySendFailsWhenFull) {
+  // rounded up to 4
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(3);
+  for (uint32_t i = 0; i < 4; i++) {
+    uint32_t val = i;
+    EXPECT_TRUE(sender.trySend(val));
+  }
+  uint32_t val = 4;
+  EXPECT_FALSE(sender.trySend(val));
+
+  EXPECT_EQ(0, receiver.recv().value());
+  EXPECT_TRUE(sender.trySend(val));
+  for (uint32_t i = 1; i <= 4; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+}
+
+TEST(SpscChannelTest, StreamsAcrossThreads) {
+  auto [sender, receiver] = mkSpscChannel<uint64_t>(64);
+  const uint64_t count = 1'000'000;
+  std::thread producer([sender = std::move(sender)]() mutable {
+    for (uint64_t i = 0; i < count; i++) {
+      sender.send(i);
+    }
+  });
+  for (uint64_t i = 0; i < count; i++) {
+    ASSERT_EQ(i, receiver.recv().value());
+  }
+  producer.join();
+}
+
+TEST(SpscChannelTest, RecvParksUntilSomethingSent) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(8);
+  std::thread producer([sender = std::move(sender)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    sender.send(42);
+  });
+  EXPECT_EQ(42, receiver.recv().value());
+  producer.join();
+}
+
+TEST(SpscChannelTest, SendParksUntilSpaceFrees) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(2);
+  sender.send(1);
+  sender.send(2);
+  std::thread consumer([&receiver]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(1, receiver.recv().value());
+  });
+  sender.send(3);
+  consumer.join();
+  EXPECT_EQ(2, receiver.recv().value());
+  EXPECT_EQ(3, receiver.recv().value());
+}
+
+TEST(SpscChannelTest, ShutdownWakesBlockedReceiver) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(8);
+  std::thread shutdown([&sender]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    sender.shutdown();
+  });
+  std::expected<uint32_t, ChannelError> t = receiver.recv();
+  ASSERT_FALSE(t.has_value());
+  EXPECT_EQ(ChannelError::Shutdown, t.error());
+  EXPECT_FALSE(receiver.tryRecv().has_value());
+  shutdown.join();
+}
+
+TEST(SpscChannelTest, ShutdownWakesBlockedSender) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(2);
+  sender.send(1);
+  sender.send(2);
+  std::thread blocked([&sender]() { sender.send(3); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  sender.shutdown();
+  blocked.join();
+  uint32_t val = 4;
+  EXPECT_FALSE(sender.trySend(val));
+}
+
+TEST(SpscChannelTest, DestroysQueuedMessages) {
+  auto payload = std::make_shared<int>(0);
+  {
+    auto [sender, receiver] = mkSpscChannel<std::shared_ptr<int>>(4);
+    sender.send(payload);
+    sender.send(payload);
+    EXPECT_EQ(3, payload.use_count());
+  }
+  EXPECT_EQ(1, payload.use_count());
+}
+
+TEST(SpscChannelTest, MoveOnlyPayloads) {
+  auto [sender, receiver] = mkSpscChannel<std::unique_ptr<int>>(4);
+  sender.send(std::make_unique<int>(1));
+  sender.emplace(new int(2));
+  auto three = std::make_unique<int>(3);
+  EXPECT_TRUE(sender.trySend(three));
+  EXPECT_EQ(nullptr, three);
+
+  EXPECT_EQ(1, *receiver.recv().value());
+  EXPECT_EQ(2, *receiver.tryRecv().value().value());
+  EXPECT_EQ(3, *receiver.recv().value());
+}
+
+TEST(SpscChannelTest, DroppingSenderDrainsThenShutsDown) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(4);
+  sender.send(1);
+  sender.send(2);
+  sender = {};
+
+  EXPECT_EQ(1, receiver.recv().value());
+  EXPECT_EQ(2, receiver.tryRecv().value().value());
+  EXPECT_EQ(ChannelError::Shutdown, receiver.recv().error());
+  EXPECT_EQ(ChannelError::Shutdown, receiver.tryRecv().error());
+}
+
+TEST(SpscChannelTest, DroppingSenderWakesBlockedReceiver) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(4);
+  std::thread producer([sender = std::move(sender)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sender.send(1);
+  });
+  EXPECT_EQ(1, receiver.recv().value());
+  EXPECT_EQ(ChannelError::Shutdown, receiver.recv().error());
+  producer.join();
+}
+
+TEST(SpscChannelTest, DroppingReceiverWakesBlockedSender) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(2);
+  sender.send(1);
+  sender.send(2);
+  std::thread dropper([receiver = std::move(receiver)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    receiver = {};
+  });
+  sender.send(3);
+  dropper.join();
+  uint32_t val = 4;
+  EXPECT_FALSE(sender.trySend(val));
+}
+
+TEST(SpscChannelTest, RecvForTimesOut) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(4);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(ChannelError::Timeout, receiver.recvFor(std::chrono::milliseconds(5)).error());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+
+  sender.send(1);
+  EXPECT_EQ(1, receiver.recvUntil(std::chrono::system_clock::now()).value());
+}
+
+TEST(SpscChannelTest, RecvForWakesOnSend) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(4);
+  std::thread producer([sender = std::move(sender)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sender.send(1);
+  });
+  EXPECT_EQ(1, receiver.recvFor(std::chrono::seconds(10)).value());
+  producer.join();
+}
+
+TEST(SpscChannelTest, SpinningReceiver) {
+  auto [sender, receiver] = mkSpscChannel<uint32_t>(4);
+  receiver.setWaitStrategy({.spins = 1 << 16, .yields = 1 << 4});
+  EXPECT_EQ(1 << 16, receiver.waitStrategy().spins);
+  // by reference, so the channel stays open for the timeout below
+  std::thread producer([&sender]() {
+    for (uint32_t i = 0; i < 1000; i++) {
+      sender.send(i);
+    }
+  });
+  for (uint32_t i = 0; i < 1000; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+  producer.join();
+  EXPECT_EQ(ChannelError::Timeout, receiver.recvFor(std::chrono::milliseconds(1)).error());
+}
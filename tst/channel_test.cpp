@@ -1,10 +1,24 @@
 #include <chrono>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <span>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "sync/channel.hpp"
 
+// the batch operations are here, trySend() is for bounded channels
+template <typename R> concept CanDrain = requires(R &rx, std::vector<uint32_t> &out) { rx.drainInto(out); };
+template <typename S> concept CanSendMany = requires(S &tx, std::span<uint32_t> vals) { tx.sendMany(vals); };
+template <typename S> concept CanTrySend = requires(S &tx, uint32_t &val) { tx.trySend(val); };
+static_assert(CanDrain<oasis::sync::channel::Receiver<uint32_t>>);
+static_assert(CanSendMany<oasis::sync::channel::Sender<uint32_t>>);
+static_assert(!CanTrySend<oasis::sync::channel::Sender<uint32_t>>);
+
 TEST(ChannelTest, CanConstructSenderAndReceiver) {
   std::pair<
     oasis::sync::channel::Sender<uint32_t>,
@@ -194,3 +208,236 @@ TEST(ChannelTest, ChannelTryRecvReturnsFrontIfNonEmpty) {
   EXPECT_EQ(true, t.has_value());
   EXPECT_EQ(42, t.value());
 }
+
+TEST(ChannelTest, SendManyThenRecvInOrder) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::vector<uint32_t> batch = {1, 2, 3};
+  sender.sendMany(batch);
+  std::list<uint32_t> more = {4, 5};
+  sender.sendMany(more.begin(), more.end());
+
+  for (uint32_t i = 1; i <= 5; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+}
+
+TEST(ChannelTest, RecvManyTakesUpToMaxN) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::vector<uint32_t> batch = {1, 2, 3, 4, 5};
+  sender.sendMany(batch);
+
+  std::vector<uint32_t> out;
+  EXPECT_EQ(3, receiver.recvMany(std::back_inserter(out), 3).value());
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 3}), out);
+  EXPECT_EQ(2, receiver.recvMany(std::back_inserter(out), 10).value());
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 3, 4, 5}), out);
+}
+
+TEST(ChannelTest, RecvManyBlocksUntilSomethingSent) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::thread delayed([sender]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(sender_sleep_duration_ms));
+    std::vector<uint32_t> batch = {7, 8};
+    sender.sendMany(batch);
+  });
+
+  std::vector<uint32_t> out;
+  while (out.size() < 2) {
+    EXPECT_TRUE(receiver.recvMany(std::back_inserter(out), 8).has_value());
+  }
+  EXPECT_EQ((std::vector<uint32_t>{7, 8}), out);
+  delayed.join();
+}
+
+TEST(ChannelTest, SendManyWakesEveryWaiter) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::atomic<uint32_t> sum = 0;
+  std::vector<std::thread> waiters;
+  for (int i = 0; i < 3; i++) {
+    waiters.emplace_back([receiver, &sum]() mutable { sum += receiver.recv().value(); });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(sender_sleep_duration_ms));
+  std::vector<uint32_t> batch = {1, 2, 3};
+  sender.sendMany(batch);
+  for (auto& waiter : waiters) {
+    waiter.join();
+  }
+  EXPECT_EQ(6, sum.load());
+}
+
+TEST(ChannelTest, DrainIntoTakesEverythingWithoutWaiting) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::deque<uint32_t> out;
+  EXPECT_EQ(0, receiver.drainInto(out).value());
+
+  std::vector<uint32_t> batch = {1, 2, 3};
+  sender.sendMany(batch);
+  EXPECT_EQ(3, receiver.drainInto(out).value());
+  EXPECT_EQ((std::deque<uint32_t>{1, 2, 3}), out);
+  EXPECT_FALSE(receiver.tryRecv().value().has_value());
+
+  sender.shutdown();
+  EXPECT_FALSE(receiver.drainInto(out).has_value());
+  EXPECT_FALSE(receiver.recvMany(std::back_inserter(out), 1).has_value());
+}
+
+// counts how often it's copied, to check messages are only ever moved
+struct CopyCounted {
+  static inline int copies = 0;
+  int value;
+
+  explicit CopyCounted(int value) : value(value) {}
+  CopyCounted(const CopyCounted &other) : value(other.value) { copies++; }
+  CopyCounted(CopyCounted &&other) noexcept = default;
+  CopyCounted &operator=(const CopyCounted &other) {
+    value = other.value;
+    copies++;
+    return *this;
+  }
+  CopyCounted &operator=(CopyCounted &&other) noexcept = default;
+};
+
+TEST(ChannelTest, MoveOnlyPayloads) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<std::unique_ptr<int>>();
+  sender.send(std::make_unique<int>(1));
+  sender.emplace(new int(2));
+  std::vector<std::unique_ptr<int>> batch;
+  batch.push_back(std::make_unique<int>(3));
+  sender.sendMany(batch);
+  EXPECT_EQ(nullptr, batch[0]);
+
+  EXPECT_EQ(1, *receiver.recv().value());
+  EXPECT_EQ(2, *receiver.tryRecv().value().value());
+  std::vector<std::unique_ptr<int>> out;
+  EXPECT_EQ(1, receiver.drainInto(out).value());
+  EXPECT_EQ(3, *out[0]);
+}
+
+TEST(ChannelTest, MessagesAreNeverCopied) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<CopyCounted>();
+  CopyCounted::copies = 0;
+  sender.send(CopyCounted(1));
+  sender.emplace(2);
+  std::vector<CopyCounted> batch;
+  batch.emplace_back(3);
+  sender.sendMany(batch);
+
+  EXPECT_EQ(1, receiver.recv().value().value);
+  EXPECT_EQ(2, receiver.tryRecv().value().value().value);
+  std::vector<CopyCounted> out;
+  receiver.recvMany(std::back_inserter(out), 1);
+  EXPECT_EQ(3, out[0].value);
+  EXPECT_EQ(0, CopyCounted::copies);
+}
+
+TEST(ChannelTest, DroppingLastSenderDrainsThenShutsDown) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  oasis::sync::channel::Sender<uint32_t> other = sender;
+  sender.send(1);
+  other.send(2);
+
+  // a sender is left, so the channel stays open once empty
+  sender = {};
+  EXPECT_EQ(1, receiver.recv().value());
+  EXPECT_EQ(2, receiver.tryRecv().value().value());
+  EXPECT_FALSE(receiver.tryRecv().value().has_value());
+
+  other.send(3);
+  other = {};
+  std::vector<uint32_t> out;
+  EXPECT_EQ(1, receiver.drainInto(out).value());
+  EXPECT_EQ(3, out[0]);
+  EXPECT_EQ(oasis::sync::channel::ChannelError::Shutdown, receiver.recv().error());
+  EXPECT_EQ(oasis::sync::channel::ChannelError::Shutdown, receiver.tryRecv().error());
+}
+
+TEST(ChannelTest, DroppingLastSenderWakesBlockedReceivers) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::atomic<int> shutdowns = 0;
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 3; i++) {
+    consumers.emplace_back([receiver, &shutdowns]() mutable {
+      if (!receiver.recv().has_value()) {
+        shutdowns++;
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  sender = {};
+  for (std::thread &consumer : consumers) {
+    consumer.join();
+  }
+  EXPECT_EQ(3, shutdowns.load());
+}
+
+TEST(ChannelTest, LastHandleDestroysQueuedMessages) {
+  auto payload = std::make_shared<int>(0);
+  {
+    auto [sender, receiver] = oasis::sync::channel::mkChannel<std::shared_ptr<int>>();
+    oasis::sync::channel::Receiver<std::shared_ptr<int>> other = receiver;
+    sender.send(payload);
+    sender.send(payload);
+    receiver = {};
+    sender = {};
+    EXPECT_EQ(3, payload.use_count());
+  }
+  EXPECT_EQ(1, payload.use_count());
+}
+
+TEST(ChannelTest, DroppingLastReceiverShutsDown) {
+  auto payload = std::make_shared<int>(0);
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<std::shared_ptr<int>>();
+  oasis::sync::channel::Receiver<std::shared_ptr<int>> other = receiver;
+  receiver = {};
+  sender.send(payload);
+  EXPECT_EQ(2, payload.use_count());
+
+  // nobody left to receive, so what's sent now is dropped
+  other = {};
+  sender.send(payload);
+  EXPECT_EQ(2, payload.use_count());
+}
+
+TEST(ChannelTest, ControlBlocksAreReused) {
+  using Pool = oasis::sync::channel::detail::BlockPool<64, 8>;
+  void *block = Pool::take();
+  Pool::give(block);
+  EXPECT_EQ(block, Pool::take());
+  Pool::give(block);
+}
+
+TEST(ChannelTest, RecvForTimesOut) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(oasis::sync::channel::ChannelError::Timeout, receiver.recvFor(std::chrono::milliseconds(5)).error());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+
+  sender.send(1);
+  EXPECT_EQ(1, receiver.recvUntil(std::chrono::system_clock::now()).value());
+}
+
+TEST(ChannelTest, RecvForWakesOnSend) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  std::thread producer([sender]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sender.send(1);
+  });
+  EXPECT_EQ(1, receiver.recvFor(std::chrono::seconds(10)).value());
+  producer.join();
+}
+
+TEST(ChannelTest, SpinningReceiver) {
+  auto [sender, receiver] = oasis::sync::channel::mkChannel<uint32_t>();
+  receiver.setWaitStrategy({.spins = 1 << 16, .yields = 1 << 4});
+  EXPECT_EQ(1 << 16, receiver.waitStrategy().spins);
+  std::thread producer([sender]() mutable {
+    for (uint32_t i = 0; i < 1000; i++) {
+      sender.send(i);
+    }
+  });
+  for (uint32_t i = 0; i < 1000; i++) {
+    EXPECT_EQ(i, receiver.recv().value());
+  }
+  producer.join();
+  EXPECT_EQ(oasis::sync::channel::ChannelError::Timeout, receiver.recvFor(std::chrono::milliseconds(1)).error());
+}
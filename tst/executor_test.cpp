@@ -0,0 +1,236 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sync/executor.hpp"
+
+using oasis::sync::Executor;
+using oasis::sync::TaskGroup;
+
+static uint64_t fib(Executor& exec, uint32_t n) {
+  if (n < 2) {
+    return n;
+  }
+  uint64_t left = 0;
+  uint64_t right = 0;
+  TaskGroup group(exec);
+  group.spawn([&]() { left = fib(exec, n - 1); });
+  right = fib(exec, n - 2);
+  group.wait();
+  return left + right;
+}
+
+TEST(ExecutorTest, RunsEveryTask) {
+  std::atomic<uint32_t> count = 0;
+  {
+    Executor exec(4);
+    EXPECT_EQ(4, exec.size());
+    for (uint32_t i = 0; i < 10000; i++) {
+      exec.spawn([&]() { count.fetch_add(1, std::memory_order_relaxed); });
+    }
+  }
+  EXPECT_EQ(10000, count.load());
+}
+
+TEST(ExecutorTest, DestructorRunsTasksSpawnedByTasks) {
+  std::atomic<uint32_t> count = 0;
+  {
+    Executor exec(3);
+    for (uint32_t i = 0; i < 100; i++) {
+      exec.spawn([&]() {
+        for (uint32_t j = 0; j < 100; j++) {
+          exec.spawn([&]() { count.fetch_add(1, std::memory_order_relaxed); });
+        }
+      });
+    }
+  }
+  EXPECT_EQ(10000, count.load());
+}
+
+TEST(ExecutorTest, DequeGrowsWhileStolenFrom) {
+  // far more than a worker's deque starts with room for, pushed while the
+  // other workers steal from it
+  Executor exec(4);
+  std::atomic<uint32_t> count = 0;
+  TaskGroup outer(exec);
+  outer.spawn([&]() {
+    TaskGroup group(exec);
+    for (uint32_t i = 0; i < 20000; i++) {
+      group.spawn([&]() { count.fetch_add(1, std::memory_order_relaxed); });
+    }
+    group.wait();
+  });
+  outer.wait();
+  EXPECT_EQ(20000, count.load());
+}
+
+TEST(ExecutorTest, ForkJoin) {
+  Executor exec(4);
+  EXPECT_EQ(6765, fib(exec, 20));
+
+  // and again from inside the pool, where wait() helps instead of blocking
+  std::atomic<uint64_t> result = 0;
+  {
+    TaskGroup group(exec);
+    group.spawn([&]() { result = fib(exec, 22); });
+  }
+  EXPECT_EQ(17711, result.load());
+}
+
+TEST(ExecutorTest, ForkJoinOnOneWorker) {
+  // every level of the recursion waits on the single worker, which only
+  // finishes because waiting runs the pending tasks
+  Executor exec(1);
+  std::atomic<uint64_t> result = 0;
+  {
+    TaskGroup group(exec);
+    group.spawn([&]() { result = fib(exec, 15); });
+  }
+  EXPECT_EQ(610, result.load());
+}
+
+TEST(ExecutorTest, WorkerIndex) {
+  std::mutex lock;
+  std::set<ptrdiff_t> seen;
+  {
+    Executor exec(2);
+    EXPECT_EQ(-1, exec.workerIndex());
+    for (uint32_t i = 0; i < 100; i++) {
+      exec.spawn([&]() {
+        std::lock_guard<std::mutex> guard(lock);
+        seen.insert(exec.workerIndex());
+      });
+    }
+  }
+  EXPECT_FALSE(seen.empty());
+  for (ptrdiff_t idx : seen) {
+    EXPECT_TRUE(idx == 0 || idx == 1);
+  }
+}
+
+TEST(ExecutorTest, LargeAndMoveOnlyTasks) {
+  Executor exec(2);
+  std::atomic<uint64_t> sum = 0;
+  TaskGroup group(exec);
+
+  // too big to store inline
+  std::array<uint64_t, 64> big;
+  big.fill(1);
+  group.spawn([&sum, big]() {
+    for (uint64_t v : big) {
+      sum.fetch_add(v);
+    }
+  });
+
+  auto owned = std::make_unique<uint64_t>(1000);
+  group.spawn([&sum, owned = std::move(owned)]() { sum.fetch_add(*owned); });
+
+  group.wait();
+  EXPECT_EQ(1064, sum.load());
+}
+
+TEST(ExecutorTest, CapturesDestroyedBeforeWaitReturns) {
+  Executor exec(2);
+  auto tracked = std::make_shared<int>(0);
+  {
+    TaskGroup group(exec);
+    for (uint32_t i = 0; i < 100; i++) {
+      group.spawn([tracked]() {});
+    }
+    group.wait();
+    EXPECT_EQ(1, tracked.use_count());
+  }
+}
+
+TEST(ExecutorTest, WaitsWhileTasksRunElsewhere) {
+  Executor exec(2);
+  std::atomic<bool> release = false;
+  std::atomic<bool> finished = false;
+
+  TaskGroup group(exec);
+  group.spawn([&]() {
+    while (!release.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    finished = true;
+  });
+  std::thread releaser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release = true;
+  });
+
+  // nothing to help with, so this parks until the task finishes
+  group.wait();
+  EXPECT_TRUE(finished.load());
+  releaser.join();
+
+  // a group can be waited on again
+  group.spawn([&]() { finished = false; });
+  group.wait();
+  EXPECT_FALSE(finished.load());
+}
+
+TEST(ExecutorTest, WakesParkedWorkers) {
+  Executor exec(4);
+  for (uint32_t round = 0; round < 20; round++) {
+    // long enough for every worker to give up spinning and park
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    // and nobody to help, so only woken workers run these
+    std::atomic<uint32_t> count = 0;
+    for (uint32_t i = 0; i < 64; i++) {
+      exec.spawn([&]() { count.fetch_add(1); });
+    }
+    while (count.load() < 64) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+}
+
+TEST(ExecutorTest, ManyExternalSpawners) {
+  std::atomic<uint32_t> count = 0;
+  {
+    Executor exec(2);
+    std::vector<std::thread> spawners;
+    for (uint32_t t = 0; t < 4; t++) {
+      spawners.emplace_back([&]() {
+        for (uint32_t i = 0; i < 2000; i++) {
+          exec.spawn([&]() { count.fetch_add(1, std::memory_order_relaxed); });
+        }
+      });
+    }
+    for (auto& t : spawners) {
+      t.join();
+    }
+  }
+  EXPECT_EQ(8000, count.load());
+}
+
+TEST(ExecutorTest, OutsideSpawnersReuseNodes) {
+  using Pool = oasis::sync::detail::TaskNode::Pool;
+  // start with nothing cached on this thread, which never runs a task, so
+  // any blocks found here later were handed back by the workers
+  while (void* block = Pool::tryTake()) {
+    ::operator delete(block, std::align_val_t(alignof(oasis::sync::detail::TaskNode)));
+  }
+
+  Executor exec(2);
+  std::atomic<uint32_t> count = 0;
+  for (uint32_t round = 0; round < 5; round++) {
+    TaskGroup group(exec);
+    for (uint32_t i = 0; i < 100; i++) {
+      group.spawn([&]() { count.fetch_add(1, std::memory_order_relaxed); });
+    }
+    group.wait();
+  }
+  EXPECT_EQ(500, count.load());
+  EXPECT_GT(Pool::cached(), 0);
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "time/histogram.hpp"
+
+using oasis::time::Histogram;
+
+TEST(HistogramTest, BucketsCoverEveryValueOnce) {
+  EXPECT_EQ(0, Histogram::bucketLowest(0));
+  EXPECT_EQ(UINT64_MAX, Histogram::bucketHighest(Histogram::numBuckets - 1));
+  for (size_t idx = 0; idx + 1 < Histogram::numBuckets; idx++) {
+    ASSERT_EQ(Histogram::bucketHighest(idx) + 1, Histogram::bucketLowest(idx + 1)) << idx;
+    ASSERT_EQ(idx, Histogram::bucketIndex(Histogram::bucketLowest(idx)));
+    ASSERT_EQ(idx, Histogram::bucketIndex(Histogram::bucketHighest(idx)));
+  }
+}
+
+TEST(HistogramTest, BucketsStayWithinPrecision) {
+  std::mt19937_64 rng(7);
+  for (int i = 0; i < 100'000; i++) {
+    uint64_t value = rng() >> (rng() % 64);
+    size_t idx = Histogram::bucketIndex(value);
+    ASSERT_LE(Histogram::bucketLowest(idx), value);
+    ASSERT_GE(Histogram::bucketHighest(idx), value);
+    uint64_t width = Histogram::bucketHighest(idx) - Histogram::bucketLowest(idx);
+    ASSERT_LE(width, value / Histogram::subBuckets);
+  }
+}
+
+TEST(HistogramTest, Empty) {
+  Histogram histogram;
+  EXPECT_EQ(0, histogram.count());
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(0, histogram.max());
+  EXPECT_EQ(0, histogram.mean());
+  EXPECT_EQ(0, histogram.percentile(50));
+}
+
+TEST(HistogramTest, PercentilesMatchSortedValues) {
+  std::mt19937_64 rng(1);
+  std::lognormal_distribution< double > latency(10, 1.5);
+  std::vector< uint64_t > values(200'000);
+  Histogram histogram;
+  for (auto& value : values) {
+    value = static_cast<uint64_t>(latency(rng));
+    histogram.record(value);
+  }
+  std::sort(values.begin(), values.end());
+
+  EXPECT_EQ(values.size(), histogram.count());
+  EXPECT_EQ(values.front(), histogram.min());
+  EXPECT_EQ(values.back(), histogram.max());
+  EXPECT_EQ(values.back(), histogram.percentile(100));
+
+  for (double p : {1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99}) {
+    uint64_t exact = values[static_cast<size_t>(std::ceil(p / 100 * values.size())) - 1];
+    uint64_t reported = histogram.percentile(p);
+    EXPECT_GE(reported, exact) << p;
+    EXPECT_LE(reported, exact + exact / Histogram::subBuckets) << p;
+  }
+}
+
+TEST(HistogramTest, SmallValuesAreExact) {
+  Histogram histogram;
+  for (uint64_t value = 1; value <= 100; value++) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(50, histogram.percentile(50));
+  EXPECT_EQ(99, histogram.percentile(99));
+  EXPECT_DOUBLE_EQ(50.5, histogram.mean());
+}
+
+TEST(HistogramTest, MergeAndReset) {
+  Histogram a, b;
+  a.record(10, 3);
+  b.record(1'000'000);
+  a.merge(b);
+  EXPECT_EQ(4, a.count());
+  EXPECT_EQ(10, a.min());
+  EXPECT_EQ(1'000'000, a.max());
+  EXPECT_EQ(10, a.percentile(75));
+  EXPECT_EQ(1'000'000, a.percentile(76));
+
+  a.reset();
+  EXPECT_EQ(0, a.count());
+  EXPECT_EQ(0, a.percentile(50));
+}
+
+TEST(LatencyRecorderTest, SnapshotSumsThreads) {
+  oasis::time::LatencyRecorder recorder;
+  std::vector< std::thread > threads;
+  for (uint64_t t = 0; t < 4; t++) {
+    threads.emplace_back([&recorder, t]() {
+      for (uint64_t i = 0; i < 10'000; i++) {
+        recorder.record(t * 10'000 + i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  Histogram histogram = recorder.snapshot();
+  EXPECT_EQ(40'000, histogram.count());
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(39'999, histogram.max());
+  EXPECT_DOUBLE_EQ(19'999.5, histogram.mean());
+}
+
+TEST(LatencyRecorderTest, SnapshotWhileRecording) {
+  oasis::time::LatencyRecorder recorder;
+  std::atomic< bool > done = false;
+  std::thread writer([&]() {
+    for (uint64_t i = 0; i < 200'000; i++) {
+      recorder.record(i % 1'000);
+    }
+    done = true;
+  });
+
+  uint64_t last = 0;
+  while (!done) {
+    Histogram histogram = recorder.snapshot();
+    EXPECT_GE(histogram.count(), last);
+    last = histogram.count();
+  }
+  writer.join();
+  EXPECT_EQ(200'000, recorder.snapshot().count());
+}
+
+TEST(LatencyRecorderTest, RecordersAreIndependent) {
+  // more recorders than a thread's shard cache has entries
+  std::vector< std::unique_ptr< oasis::time::LatencyRecorder > > recorders;
+  for (int r = 0; r < 40; r++) {
+    recorders.push_back(std::make_unique< oasis::time::LatencyRecorder >());
+  }
+  for (int round = 0; round < 3; round++) {
+    for (size_t r = 0; r < recorders.size(); r++) {
+      recorders[r]->record(r);
+    }
+  }
+  for (size_t r = 0; r < recorders.size(); r++) {
+    Histogram histogram = recorders[r]->snapshot();
+    EXPECT_EQ(3, histogram.count());
+    EXPECT_EQ(r, histogram.max());
+  }
+}
+
+TEST(LatencyRecorderTest, ScopedLatencyRecordsElapsed) {
+  oasis::time::LatencyRecorder recorder;
+  {
+    oasis::time::ScopedLatency< oasis::time::MonotonicClock > timed(recorder);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  Histogram histogram = recorder.snapshot();
+  EXPECT_EQ(1, histogram.count());
+  EXPECT_GE(histogram.max(), 2'000'000);
+}
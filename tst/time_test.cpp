@@ -0,0 +1,127 @@
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "time.hpp"
+
+static_assert(oasis::time::WallClock< oasis::time::RealtimeClock >);
+static_assert(oasis::time::WallClock< oasis::time::CoarseRealtimeClock >);
+static_assert(oasis::time::WallClock< oasis::time::TscClock >);
+static_assert(oasis::time::WallClock< oasis::time::CachedClock >);
+static_assert(oasis::time::Clock< oasis::time::MonotonicClock >);
+static_assert(!oasis::time::WallClock< oasis::time::MonotonicClock >);
+
+static uint64_t systemClockNanos() {
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+template <typename C>
+static void expectNearSystemClock(uint64_t toleranceNanos) {
+  uint64_t before = systemClockNanos();
+  uint64_t now = C::nowNanos();
+  uint64_t after = systemClockNanos();
+  EXPECT_LE(before, now + toleranceNanos);
+  EXPECT_GE(after + toleranceNanos, now);
+}
+
+TEST(TimeTest, WallClocksAgreeWithSystemClock) {
+  expectNearSystemClock< oasis::time::RealtimeClock >(0);
+  // a tick behind at most
+  expectNearSystemClock< oasis::time::CoarseRealtimeClock >(20'000'000);
+  expectNearSystemClock< oasis::time::TscClock >(2'000'000);
+}
+
+TEST(TimeTest, MonotonicClockNeverGoesBackwards) {
+  uint64_t last = oasis::time::MonotonicClock::nowNanos();
+  for (int i = 0; i < 100'000; i++) {
+    uint64_t now = oasis::time::MonotonicClock::nowNanos();
+    ASSERT_GE(now, last);
+    last = now;
+  }
+}
+
+TEST(TimeTest, TscClockMeasuresIntervals) {
+  oasis::time::TscClock::calibrate();
+
+  uint64_t tscBefore = oasis::time::TscClock::nowNanos();
+  uint64_t monoBefore = oasis::time::MonotonicClock::nowNanos();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  uint64_t tscElapsed = oasis::time::TscClock::nowNanos() - tscBefore;
+  uint64_t monoElapsed = oasis::time::MonotonicClock::nowNanos() - monoBefore;
+
+  EXPECT_NEAR(static_cast<double>(monoElapsed), static_cast<double>(tscElapsed), 100'000);
+}
+
+TEST(TimeTest, MillisSinceEpochUsesTheGivenClock) {
+  uint64_t before = oasis::time::millisSinceEpoch();
+  uint64_t coarse = oasis::time::millisSinceEpoch< oasis::time::CoarseRealtimeClock >();
+  uint64_t tsc = oasis::time::millisSinceEpoch< oasis::time::TscClock >();
+  uint64_t after = oasis::time::millisSinceEpoch();
+
+  EXPECT_LE(before, coarse + 20);
+  EXPECT_GE(after, coarse);
+  EXPECT_NEAR(before, tsc, 2);
+  EXPECT_NEAR(after, tsc, 2);
+}
+
+TEST(TimeTest, CachedClockFallsBackWhenStopped) {
+  ASSERT_FALSE(oasis::time::CachedClock::running());
+  uint64_t before = oasis::time::millisSinceEpoch();
+  uint64_t cached = oasis::time::CachedClock::nowMillis();
+  uint64_t after = oasis::time::millisSinceEpoch();
+  EXPECT_LE(before, cached);
+  EXPECT_GE(after, cached);
+}
+
+TEST(TimeTest, CachedClockFollowsTheWallClock) {
+  oasis::time::CachedClock::Session session;
+  ASSERT_TRUE(oasis::time::CachedClock::running());
+
+  uint64_t first = oasis::time::millisSinceEpoch< oasis::time::CachedClock >();
+  EXPECT_NEAR(oasis::time::millisSinceEpoch(), first, 2);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  uint64_t later = oasis::time::CachedClock::nowMillis();
+  // the ticker may lag a little behind on a busy machine
+  EXPECT_GE(later, first + 15);
+  EXPECT_NEAR(oasis::time::millisSinceEpoch(), later, 5);
+  EXPECT_EQ(later * 1'000'000, oasis::time::CachedClock::nowNanos());
+}
+
+TEST(TimeTest, CachedClockStartAndStopNest) {
+  oasis::time::CachedClock::start();
+  oasis::time::CachedClock::start();
+  oasis::time::CachedClock::stop();
+  EXPECT_TRUE(oasis::time::CachedClock::running());
+  oasis::time::CachedClock::stop();
+  EXPECT_FALSE(oasis::time::CachedClock::running());
+
+  // unmatched stops are ignored
+  oasis::time::CachedClock::stop();
+  EXPECT_FALSE(oasis::time::CachedClock::running());
+
+  // and it can be started again
+  for (int i = 0; i < 10; i++) {
+    oasis::time::CachedClock::Session session;
+    EXPECT_TRUE(oasis::time::CachedClock::running());
+  }
+  EXPECT_FALSE(oasis::time::CachedClock::running());
+}
+
+TEST(TimeTest, CachedClockStartStopFromManyThreads) {
+  std::vector< std::thread > threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([]() {
+      for (int i = 0; i < 100; i++) {
+        oasis::time::CachedClock::Session session;
+        EXPECT_NE(0, oasis::time::CachedClock::nowMillis());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(oasis::time::CachedClock::running());
+}
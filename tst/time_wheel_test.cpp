@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "time/wheel.hpp"
+
+struct Fired {
+  std::vector< uint64_t > ticks = {};
+  oasis::time::TimerWheel* wheel = nullptr;
+};
+
+static void recordFire(oasis::time::Timer&, void* ctx) {
+  auto* fired = static_cast< Fired* >(ctx);
+  fired->ticks.push_back(fired->wheel->now());
+}
+
+TEST(TimerWheelTest, FiresAtDeadline) {
+  oasis::time::TimerWheel wheel(1'000);
+  Fired fired{.wheel = &wheel};
+  oasis::time::Timer timer(recordFire, &fired);
+
+  wheel.schedule(timer, 1'010);
+  EXPECT_TRUE(timer.scheduled());
+  EXPECT_EQ(1, wheel.size());
+
+  for (uint64_t tick = 1'001; tick <= 1'020; tick++) {
+    wheel.advance(tick);
+  }
+  EXPECT_EQ(std::vector< uint64_t >{1'010}, fired.ticks);
+  EXPECT_FALSE(timer.scheduled());
+  EXPECT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheelTest, PastDeadlineFiresOnNextAdvance) {
+  oasis::time::TimerWheel wheel(50);
+  Fired fired{.wheel = &wheel};
+  oasis::time::Timer timer(recordFire, &fired);
+
+  wheel.schedule(timer, 10);
+  EXPECT_EQ(0, wheel.advance(50));
+  EXPECT_EQ(1, wheel.advance(51));
+  EXPECT_EQ(std::vector< uint64_t >{51}, fired.ticks);
+}
+
+TEST(TimerWheelTest, CancelledTimersDontFire) {
+  oasis::time::TimerWheel wheel(0);
+  Fired fired{.wheel = &wheel};
+  oasis::time::Timer a(recordFire, &fired);
+  oasis::time::Timer b(recordFire, &fired);
+
+  wheel.schedule(a, 100);
+  wheel.schedule(b, 100'000);
+  EXPECT_TRUE(wheel.cancel(a));
+  EXPECT_FALSE(wheel.cancel(a));
+  {
+    // destroying a scheduled timer cancels it
+    oasis::time::Timer c(recordFire, &fired);
+    wheel.schedule(c, 50);
+  }
+  EXPECT_EQ(1, wheel.size());
+  EXPECT_TRUE(wheel.cancel(b));
+
+  wheel.advance(1'000'000);
+  EXPECT_TRUE(fired.ticks.empty());
+}
+
+TEST(TimerWheelTest, RescheduleMovesTheDeadline) {
+  oasis::time::TimerWheel wheel(0);
+  Fired fired{.wheel = &wheel};
+  oasis::time::Timer timer(recordFire, &fired);
+
+  wheel.schedule(timer, 10);
+  wheel.schedule(timer, 5'000);
+  EXPECT_EQ(1, wheel.size());
+  EXPECT_EQ(5'000, timer.deadline());
+
+  wheel.advance(4'999);
+  EXPECT_TRUE(fired.ticks.empty());
+  wheel.advance(5'000);
+  EXPECT_EQ(std::vector< uint64_t >{5'000}, fired.ticks);
+}
+
+struct Periodic {
+  oasis::time::TimerWheel* wheel;
+  uint64_t period;
+  size_t count = 0;
+};
+
+TEST(TimerWheelTest, CallbacksCanReschedule) {
+  oasis::time::TimerWheel wheel(0);
+  Periodic periodic{&wheel, 7};
+  oasis::time::Timer timer([](oasis::time::Timer& timer, void* ctx) {
+    auto* periodic = static_cast< Periodic* >(ctx);
+    periodic->count++;
+    periodic->wheel->scheduleAfter(timer, periodic->period);
+  }, &periodic);
+
+  wheel.scheduleAfter(timer, 7);
+  for (uint64_t tick = 1; tick <= 700; tick++) {
+    wheel.advance(tick);
+  }
+  EXPECT_EQ(100, periodic.count);
+  EXPECT_EQ(707, timer.deadline());
+}
+
+TEST(TimerWheelTest, CallbacksCanCancelPendingTimersInTheSameBatch) {
+  oasis::time::TimerWheel wheel(0);
+  std::vector< std::unique_ptr< oasis::time::Timer > > timers;
+  size_t fired = 0;
+  struct Ctx {
+    std::vector< std::unique_ptr< oasis::time::Timer > >* timers;
+    oasis::time::TimerWheel* wheel;
+    size_t* fired;
+  } ctx{&timers, &wheel, &fired};
+
+  // whichever fires first cancels all the others
+  for (int i = 0; i < 10; i++) {
+    timers.push_back(std::make_unique< oasis::time::Timer >([](oasis::time::Timer&, void* ctx) {
+      auto* c = static_cast< Ctx* >(ctx);
+      (*c->fired)++;
+      for (auto& timer : *c->timers) {
+        c->wheel->cancel(*timer);
+      }
+    }, &ctx));
+    wheel.schedule(*timers.back(), 100 + i);
+  }
+
+  EXPECT_EQ(1, wheel.advance(200));
+  EXPECT_EQ(1, fired);
+  EXPECT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheelTest, DeadlinesBeyondTheRangeStillFire) {
+  oasis::time::TimerWheel wheel(123);
+  Fired fired{.wheel = &wheel};
+  oasis::time::Timer timer(recordFire, &fired);
+
+  uint64_t deadline = 123 + (1LLU << 40) + 17;
+  wheel.schedule(timer, deadline);
+
+  // in large steps, then tick by tick over the deadline
+  uint64_t tick = 123;
+  while (tick + (1LLU << 33) < deadline) {
+    tick += 1LLU << 33;
+    wheel.advance(tick);
+  }
+  EXPECT_TRUE(fired.ticks.empty());
+  for (tick = deadline - 100; tick <= deadline + 100; tick++) {
+    wheel.advance(tick);
+  }
+  EXPECT_EQ(std::vector< uint64_t >{deadline}, fired.ticks);
+}
+
+TEST(TimerWheelTest, NextExpiryIsALowerBound) {
+  oasis::time::TimerWheel wheel(1'000);
+  EXPECT_EQ(UINT64_MAX, wheel.nextExpiry());
+
+  Fired fired{.wheel = &wheel};
+  oasis::time::Timer near(recordFire, &fired);
+  oasis::time::Timer far(recordFire, &fired);
+  wheel.schedule(far, 500'000);
+  EXPECT_LE(wheel.nextExpiry(), 500'000);
+  EXPECT_GT(wheel.nextExpiry(), 1'000);
+
+  wheel.schedule(near, 1'020);
+  EXPECT_EQ(1'020, wheel.nextExpiry());
+}
+
+TEST(TimerWheelTest, DestroyingTheWheelUnschedulesTimers) {
+  Fired fired;
+  oasis::time::Timer timer(recordFire, &fired);
+  {
+    oasis::time::TimerWheel wheel(0);
+    wheel.schedule(timer, 10);
+  }
+  EXPECT_FALSE(timer.scheduled());
+}
+
+// every timer fires exactly once, on the first advance() that reaches its
+// deadline, whatever mix of deadlines and step sizes
+TEST(TimerWheelTest, MatchesReferenceUnderRandomSchedules) {
+  std::mt19937_64 rng(3);
+  for (uint64_t maxDelay : {100LLU, 10'000LLU, 1'000'000LLU, 1LLU << 40, 1LLU << 40, 1LLU << 40}) {
+    const size_t numTimers = 20'000;
+    uint64_t start = rng() >> 8;
+    oasis::time::TimerWheel wheel(start);
+
+    struct Entry {
+      oasis::time::TimerWheel* wheel;
+      uint64_t firedAt = 0;
+      size_t fires = 0;
+    };
+    std::vector< Entry > entries(numTimers, Entry{&wheel});
+    std::vector< std::unique_ptr< oasis::time::Timer > > timers;
+    std::vector< uint64_t > deadlines;
+    for (size_t i = 0; i < numTimers; i++) {
+      timers.push_back(std::make_unique< oasis::time::Timer >([](oasis::time::Timer&, void* ctx) {
+        auto* entry = static_cast< Entry* >(ctx);
+        entry->firedAt = entry->wheel->now();
+        entry->fires++;
+      }, &entries[i]));
+      deadlines.push_back(start + 1 + rng() % maxDelay);
+      wheel.schedule(*timers[i], deadlines[i]);
+    }
+
+    // steps of every size up to the whole range
+    std::vector< uint64_t > advancedTo;
+    uint64_t tick = start;
+    while (wheel.size() > 0) {
+      uint64_t scale = rng() % 12;
+      uint64_t step = 1 + rng() % std::max< uint64_t >(1, maxDelay >> scale);
+      tick += step;
+      wheel.advance(tick);
+      advancedTo.push_back(tick);
+    }
+
+    for (size_t i = 0; i < numTimers; i++) {
+      ASSERT_EQ(1, entries[i].fires);
+      // the first tick advanced to at or after the deadline
+      uint64_t expected = *std::lower_bound(advancedTo.begin(), advancedTo.end(), deadlines[i]);
+      ASSERT_EQ(expected, entries[i].firedAt) << "max delay " << maxDelay;
+    }
+  }
+}
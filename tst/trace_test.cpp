@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "sync/channel.hpp"
+#include "trace.hpp"
+
+// tracing is process wide, every test starts and ends with it off and empty
+class TraceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    oasis::trace::disable();
+    oasis::trace::clear();
+  }
+
+  void TearDown() override {
+    oasis::trace::disable();
+    oasis::trace::clear();
+  }
+};
+
+static std::vector< oasis::trace::Event > named(const char* name) {
+  std::vector< oasis::trace::Event > events;
+  for (const auto& event : oasis::trace::collect()) {
+    if (std::strcmp(event.name, name) == 0) {
+      events.push_back(event);
+    }
+  }
+  return events;
+}
+
+TEST_F(TraceTest, NothingRecordedWhileDisabled) {
+  {
+    oasis::trace::Span span("disabled");
+  }
+  oasis::trace::instant("disabled");
+  EXPECT_TRUE(named("disabled").empty());
+}
+
+TEST_F(TraceTest, SpanRecordsDuration) {
+  oasis::trace::enable();
+  uint64_t before = oasis::time::TscClock::nowNanos();
+  {
+    oasis::trace::Span span("sleep");
+    span.setArg(42);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  uint64_t after = oasis::time::TscClock::nowNanos();
+
+  auto events = named("sleep");
+  ASSERT_EQ(1, events.size());
+  EXPECT_GE(events[0].startNanos, before);
+  EXPECT_GE(events[0].durationNanos, 2'000'000);
+  EXPECT_LE(events[0].startNanos + events[0].durationNanos, after);
+  EXPECT_EQ(42, events[0].arg);
+}
+
+TEST_F(TraceTest, InstantHasNoDuration) {
+  oasis::trace::enable();
+  oasis::trace::instant("mark", 7);
+  auto events = named("mark");
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(oasis::trace::instantEvent, events[0].durationNanos);
+  EXPECT_EQ(7, events[0].arg);
+}
+
+TEST_F(TraceTest, RingKeepsNewestEvents) {
+  oasis::trace::enable();
+  size_t total = oasis::trace::eventsPerThread * 2 + 5;
+  for (size_t i = 0; i < total; i++) {
+    oasis::trace::instant("ring", i);
+  }
+  auto events = named("ring");
+  ASSERT_EQ(oasis::trace::eventsPerThread, events.size());
+  for (size_t i = 0; i < events.size(); i++) {
+    EXPECT_EQ(total - oasis::trace::eventsPerThread + i, events[i].arg);
+  }
+}
+
+TEST_F(TraceTest, ClearDiscardsEvents) {
+  oasis::trace::enable();
+  oasis::trace::instant("cleared");
+  oasis::trace::clear();
+  EXPECT_TRUE(named("cleared").empty());
+  oasis::trace::instant("cleared");
+  EXPECT_EQ(1, named("cleared").size());
+}
+
+TEST_F(TraceTest, ThreadsRecordSeparately) {
+  oasis::trace::enable();
+  std::vector< std::thread > threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([]() {
+      for (int i = 0; i < 100; i++) {
+        oasis::trace::Span span("worker");
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto events = named("worker");
+  EXPECT_EQ(400, events.size());
+  std::vector< uint32_t > ids;
+  for (const auto& event : events) {
+    ids.push_back(event.thread);
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  EXPECT_EQ(4, ids.size());
+}
+
+TEST_F(TraceTest, CollectWhileRecording) {
+  oasis::trace::enable();
+  std::atomic< bool > done = false;
+  std::thread writer([&]() {
+    for (uint64_t i = 0; i < 100'000; i++) {
+      oasis::trace::instant("racing", i);
+    }
+    done = true;
+  });
+
+  while (!done) {
+    auto events = named("racing");
+    // whatever survives is in order and untorn
+    for (size_t i = 1; i < events.size(); i++) {
+      ASSERT_EQ(events[i - 1].arg + 1, events[i].arg);
+    }
+  }
+  writer.join();
+}
+
+TEST_F(TraceTest, ChannelIsInstrumented) {
+  oasis::trace::enable();
+  auto [tx, rx] = oasis::sync::channel::mkChannel< int >();
+  tx.send(1);
+  EXPECT_EQ(1, rx.recv().value());
+  EXPECT_EQ(1, named("channel.send").size());
+  EXPECT_EQ(1, named("channel.recv").size());
+}
+
+TEST_F(TraceTest, ChromeJson) {
+  oasis::trace::enable();
+  std::thread([]() {
+    oasis::trace::setThreadName("poller \"one\"");
+    oasis::trace::Span span("json.span");
+    span.setArg(3);
+  }).join();
+  oasis::trace::instant("json.instant");
+
+  std::ostringstream out;
+  oasis::trace::writeChromeJson(out);
+  std::string json = out.str();
+
+  EXPECT_EQ(0, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+  EXPECT_EQ("]}\n", json.substr(json.size() - 3));
+  EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"poller \\\"one\\\"\"}"));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"json.span\",\"cat\":\"oasis\""));
+  EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\",\"dur\":"));
+  EXPECT_NE(std::string::npos, json.find("\"args\":{\"arg\":3}"));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"json.instant\""));
+  EXPECT_NE(std::string::npos, json.find("\"ph\":\"i\""));
+  EXPECT_EQ(std::count(json.begin(), json.end(), '{'), std::count(json.begin(), json.end(), '}'));
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "uuid.hpp"
+#include "uuid/bloom.hpp"
+
+static std::vector< oasis::uuid::Uuid > v7Ids(size_t count) {
+  std::vector< oasis::uuid::Uuid > uuids(count);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  return uuids;
+}
+
+TEST(UuidBloomTest, EmptyFilterContainsNothing) {
+  auto filter = oasis::uuid::UuidBloomFilter::withMemoryBudget(4096);
+  for (auto& uuid : v7Ids(1'000)) {
+    EXPECT_FALSE(filter.mayContain(uuid));
+  }
+}
+
+TEST(UuidBloomTest, NoFalseNegatives) {
+  auto filter = oasis::uuid::UuidBloomFilter::withMemoryBudget(64 * 1024);
+  auto uuids = v7Ids(50'000);
+  for (auto& uuid : uuids) {
+    filter.insert(uuid);
+  }
+  for (auto& uuid : uuids) {
+    ASSERT_TRUE(filter.mayContain(uuid));
+  }
+
+  filter.clear();
+  EXPECT_FALSE(filter.mayContain(uuids[0]));
+}
+
+TEST(UuidBloomTest, MemoryBudgetIsRespected) {
+  EXPECT_EQ(32, oasis::uuid::UuidBloomFilter::withMemoryBudget(0).sizeBytes());
+  EXPECT_EQ(1024, oasis::uuid::UuidBloomFilter::withMemoryBudget(1024).sizeBytes());
+  EXPECT_EQ(1024, oasis::uuid::UuidBloomFilter::withMemoryBudget(1055).sizeBytes());
+
+  auto capped = oasis::uuid::UuidBloomFilter::forCapacity(1'000'000, 0.0001, 4096);
+  EXPECT_EQ(4096, capped.sizeBytes());
+}
+
+TEST(UuidBloomTest, ForCapacityPicksSmallestFilter) {
+  auto filter = oasis::uuid::UuidBloomFilter::forCapacity(100'000, 0.01);
+  EXPECT_LE(filter.expectedFalsePositiveRate(100'000), 0.01);
+
+  // about 10-11 bits per id for 1%
+  EXPECT_GT(filter.sizeBytes() * 8, 100'000 * 9);
+  EXPECT_LT(filter.sizeBytes() * 8, 100'000 * 13);
+
+  auto smaller = oasis::uuid::UuidBloomFilter::withMemoryBudget(filter.sizeBytes() - 32);
+  EXPECT_GT(smaller.expectedFalsePositiveRate(100'000), 0.01);
+}
+
+// the observed rate of ids never inserted should be close to the estimate
+TEST(UuidBloomTest, FalsePositiveRateMatchesEstimate) {
+  for (double target : {0.05, 0.01, 0.001}) {
+    const size_t inserted = 200'000;
+    const size_t probes = 1'000'000;
+    auto filter = oasis::uuid::UuidBloomFilter::forCapacity(inserted, target);
+    filter.insertMany(v7Ids(inserted));
+
+    auto others = v7Ids(probes);
+    auto out = std::make_unique< bool[] >(probes);
+    size_t positives = filter.mayContainMany(others, std::span(out.get(), probes));
+
+    double expected = filter.expectedFalsePositiveRate(inserted);
+    double observed = static_cast<double>(positives) / probes;
+    EXPECT_LT(observed, expected * 1.3) << "target " << target;
+    EXPECT_GT(observed, expected * 0.7) << "target " << target;
+  }
+}
+
+// v7 ids from one burst differ mostly in their counter bits
+TEST(UuidBloomTest, FalsePositiveRateOfIdsFromOneGenerator) {
+  oasis::uuid::UuidV7Generator generator(17);
+  std::vector< oasis::uuid::Uuid > uuids(300'000);
+  generator.fill(uuids);
+
+  auto filter = oasis::uuid::UuidBloomFilter::forCapacity(100'000, 0.01);
+  filter.insertMany(std::span(uuids).first(100'000));
+
+  size_t positives = 0;
+  for (auto& uuid : std::span(uuids).subspan(100'000)) {
+    positives += filter.mayContain(uuid);
+  }
+  EXPECT_LT(static_cast<double>(positives) / 200'000, 0.013);
+}
+
+TEST(UuidBloomTest, BatchMatchesScalar) {
+  auto filter = oasis::uuid::UuidBloomFilter::withMemoryBudget(8 * 1024);
+  auto uuids = v7Ids(10'000);
+  filter.insertMany(std::span(uuids).first(5'000));
+
+  auto out = std::make_unique< bool[] >(uuids.size());
+  size_t positives = filter.mayContainMany(uuids, std::span(out.get(), uuids.size()));
+
+  size_t expected = 0;
+  for (size_t i = 0; i < uuids.size(); i++) {
+    EXPECT_EQ(filter.mayContain(uuids[i]), out[i]);
+    expected += out[i];
+  }
+  EXPECT_EQ(expected, positives);
+}
+
+TEST(UuidBloomTest, TestAndInsertReportsRepeats) {
+  auto filter = oasis::uuid::UuidBloomFilter::withMemoryBudget(64 * 1024);
+  auto uuids = v7Ids(1'000);
+  uuids.push_back(uuids[10]);
+  uuids.push_back(uuids[500]);
+
+  auto out = std::make_unique< bool[] >(uuids.size());
+  size_t repeats = filter.testAndInsertMany(uuids, std::span(out.get(), uuids.size()));
+  EXPECT_TRUE(out[1'000]);
+  EXPECT_TRUE(out[1'001]);
+  // 1000 ids in 2048 blocks, a false positive among them is very unlikely
+  EXPECT_EQ(2, repeats);
+
+  EXPECT_TRUE(filter.testAndInsert(uuids[0]));
+  EXPECT_FALSE(filter.testAndInsert(oasis::uuid::Uuid::v7()));
+}
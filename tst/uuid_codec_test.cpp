@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "uuid.hpp"
+#include "uuid/codec.hpp"
+
+std::vector< oasis::uuid::Uuid > parseAll(const std::vector< std::string >& strs) {
+  std::vector< oasis::uuid::Uuid > uuids;
+  for (auto& str : strs) {
+    uuids.push_back(oasis::uuid::Uuid::fromChars(str).value());
+  }
+  return uuids;
+}
+
+TEST(UuidCodecTest, EmptyColumnRoundTrips) {
+  oasis::uuid::UuidV7Column column(std::span< const oasis::uuid::Uuid >{});
+  EXPECT_EQ(0, column.size());
+  EXPECT_EQ(0, column.numBlocks());
+
+  auto decoded = oasis::uuid::UuidV7Column::fromBytes(column.bytes());
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(0, decoded.value().size());
+}
+
+TEST(UuidCodecTest, RoundTripsV7Ids) {
+  // several full blocks and a partial one
+  for (size_t count : {1, 2, 5, 128, 129, 1'000}) {
+    std::vector< oasis::uuid::Uuid > uuids(count);
+    oasis::uuid::Uuid::v7Batch(uuids);
+
+    oasis::uuid::UuidV7Column column(uuids);
+    EXPECT_EQ(count, column.size());
+    EXPECT_EQ((count + 127) / 128, column.numBlocks());
+
+    std::vector< oasis::uuid::Uuid > decoded(count);
+    column.decode(decoded);
+    EXPECT_EQ(uuids, decoded);
+  }
+}
+
+TEST(UuidCodecTest, RoundTripsUnsortedAndNonV7Ids) {
+  std::vector< oasis::uuid::Uuid > uuids = parseAll({
+    "ffffffff-ffff-ffff-ffff-ffffffffffff",
+    "00000000-0000-0000-0000-000000000000",
+    "f81d4fae-7dec-11d0-a765-00a0c91e6bf6",
+    "00000001-0000-0007-0002-000000000000",
+    "ffffffff-ffff-0007-0002-000000000000",
+  });
+
+  std::mt19937_64 rng(3);
+  for (int i = 0; i < 300; i++) {
+    uuids.push_back(uuids[rng() % 5]);
+  }
+
+  oasis::uuid::UuidV7Column column(uuids);
+  std::vector< oasis::uuid::Uuid > decoded(uuids.size());
+  column.decode(decoded);
+  EXPECT_EQ(uuids, decoded);
+}
+
+TEST(UuidCodecTest, BlocksAndIdsAreRandomlyAccessible) {
+  std::vector< oasis::uuid::Uuid > uuids(1'000);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::UuidV7Column column(uuids);
+
+  std::vector< oasis::uuid::Uuid > block(oasis::uuid::UuidV7Column::blockSize);
+  column.decodeBlock(3, block);
+  EXPECT_TRUE(std::equal(block.begin(), block.end(), uuids.begin() + 3 * 128));
+
+  EXPECT_EQ(1'000 - 7 * 128, column.blockCount(7));
+  column.decodeBlock(7, block);
+  EXPECT_TRUE(std::equal(block.begin(), block.begin() + column.blockCount(7),
+                         uuids.begin() + 7 * 128));
+
+  for (size_t idx : {0, 1, 127, 128, 500, 999}) {
+    EXPECT_EQ(uuids[idx], column.at(idx));
+  }
+}
+
+TEST(UuidCodecTest, SortedV7IdsCompress) {
+  std::vector< oasis::uuid::Uuid > uuids(100'000);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::UuidV7Column column(uuids);
+
+  // 10 bytes of random bits per id plus a few bits of timestamp delta
+  EXPECT_LT(column.bytes().size(), uuids.size() * 11);
+}
+
+TEST(UuidCodecTest, FromBytesRoundTrips) {
+  std::vector< oasis::uuid::Uuid > uuids(300);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::UuidV7Column column(uuids);
+
+  std::vector< uint8_t > bytes(column.bytes().begin(), column.bytes().end());
+  auto copy = oasis::uuid::UuidV7Column::fromBytes(bytes);
+  ASSERT_TRUE(copy.has_value());
+
+  std::vector< oasis::uuid::Uuid > decoded(uuids.size());
+  copy.value().decode(decoded);
+  EXPECT_EQ(uuids, decoded);
+}
+
+TEST(UuidCodecTest, FromBytesRejectsCorruptInput) {
+  std::vector< oasis::uuid::Uuid > uuids(300);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::UuidV7Column column(uuids);
+  std::vector< uint8_t > bytes(column.bytes().begin(), column.bytes().end());
+
+  auto truncated = oasis::uuid::UuidV7Column::fromBytes(
+    std::span< const uint8_t >(bytes).first(bytes.size() - 1));
+  EXPECT_EQ(oasis::uuid::UuidColumnError::Truncated, truncated.error());
+
+  auto tooShort = oasis::uuid::UuidV7Column::fromBytes(
+    std::span< const uint8_t >(bytes).first(8));
+  EXPECT_EQ(oasis::uuid::UuidColumnError::Truncated, tooShort.error());
+
+  std::vector< uint8_t > badMagic = bytes;
+  badMagic[0] ^= 0xFF;
+  EXPECT_EQ(oasis::uuid::UuidColumnError::InvalidHeader,
+            oasis::uuid::UuidV7Column::fromBytes(badMagic).error());
+
+  std::vector< uint8_t > badCount = bytes;
+  badCount[4] += 1;
+  EXPECT_EQ(oasis::uuid::UuidColumnError::InvalidHeader,
+            oasis::uuid::UuidV7Column::fromBytes(badCount).error());
+}
+
+TEST(UuidCodecTest, UnpackDeltasMatchesScalar) {
+  std::mt19937_64 rng(11);
+  for (uint32_t width = 0; width <= oasis::uuid::detail::maxDeltaWidth; width++) {
+    size_t count = 37;
+    std::vector< uint8_t > packed((count * width + 7) / 8 + 8);
+    for (auto& byte : packed) {
+      byte = rng();
+    }
+
+    std::vector< uint64_t > expected(count), actual(count);
+    oasis::uuid::detail::unpackDeltasScalar(packed.data(), width, count, 1'000, expected.data());
+    oasis::uuid::detail::unpackDeltas(packed.data(), width, count, 1'000, actual.data());
+    EXPECT_EQ(expected, actual);
+  }
+}
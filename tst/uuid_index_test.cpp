@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "uuid.hpp"
+#include "uuid/index.hpp"
+
+// builds a v7 id with the given timestamp, `tag` lands in rand_b so ids that
+// share a timestamp can be told apart
+oasis::uuid::Uuid uuidAt(uint64_t millis, uint32_t tag = 0) {
+  char str[37];
+  std::snprintf(str, sizeof(str), "%08x-%04x-%04x-%04x-%012llx",
+                static_cast<uint32_t>(millis & 0xFFFF'FFFF),
+                static_cast<uint32_t>((millis >> 32) & 0xFFFF), 0x0007, 0x0002,
+                static_cast<unsigned long long>(tag));
+  return oasis::uuid::Uuid::fromChars(std::string_view(str, 36)).value();
+}
+
+TEST(UuidIndexTest, TimestampMatchesGenerationTime) {
+  uint64_t before = oasis::time::millisSinceEpoch();
+  oasis::uuid::Uuid uuid = oasis::uuid::Uuid::v7();
+  uint64_t after = oasis::time::millisSinceEpoch();
+
+  EXPECT_LE(before, uuid.timestampMillis());
+  EXPECT_GE(after, uuid.timestampMillis());
+  EXPECT_EQ(7, uuid.version());
+  EXPECT_EQ(1234, uuidAt(1234).timestampMillis());
+}
+
+TEST(UuidIndexTest, EmptyIndexReturnsEmptyRanges) {
+  oasis::uuid::UuidV7Index index;
+  EXPECT_EQ(0, index.size());
+  EXPECT_TRUE(index.range(0, UINT64_MAX).empty());
+  EXPECT_EQ(0, index.lowerBound(42));
+}
+
+TEST(UuidIndexTest, RangeIsHalfOpen) {
+  oasis::uuid::UuidV7Index index;
+  for (uint64_t ts = 10; ts < 20; ts++) {
+    index.insert(uuidAt(ts));
+  }
+
+  auto range = index.range(12, 15);
+  ASSERT_EQ(3, range.size());
+  EXPECT_EQ(12, range[0].timestampMillis());
+  EXPECT_EQ(14, range[2].timestampMillis());
+
+  EXPECT_EQ(10, index.count(0, 100));
+  EXPECT_EQ(0, index.count(15, 15));
+  EXPECT_EQ(0, index.count(15, 12));
+  EXPECT_EQ(0, index.count(20, 30));
+}
+
+TEST(UuidIndexTest, LateInsertsStaySorted) {
+  oasis::uuid::UuidV7Index index;
+  std::vector< uint64_t > arrivals = {5, 6, 8, 7, 9, 9, 3, 10, 8};
+  for (uint32_t i = 0; i < arrivals.size(); i++) {
+    index.insert(uuidAt(arrivals[i], i));
+  }
+
+  auto all = index.all();
+  EXPECT_TRUE(std::ranges::is_sorted(all, {}, &oasis::uuid::Uuid::timestampMillis));
+
+  // equal timestamps keep their arrival order
+  auto eights = index.range(8, 9);
+  ASSERT_EQ(2, eights.size());
+  EXPECT_EQ(uuidAt(8, 2), eights[0]);
+  EXPECT_EQ(uuidAt(8, 8), eights[1]);
+}
+
+TEST(UuidIndexTest, InsertManyMatchesSortedReference) {
+  std::mt19937_64 rng(7);
+  oasis::uuid::UuidV7Index index;
+  std::vector< uint64_t > reference;
+
+  for (int batch = 0; batch < 20; batch++) {
+    std::vector< oasis::uuid::Uuid > ids;
+    for (int i = 0; i < 100; i++) {
+      // mostly increasing with some jitter backwards
+      uint64_t ts = 100 + batch * 50 + i - (rng() % 60);
+      ids.push_back(uuidAt(ts));
+      reference.push_back(ts);
+    }
+    index.insertMany(ids);
+  }
+  std::ranges::sort(reference);
+
+  ASSERT_EQ(reference.size(), index.size());
+  for (size_t i = 0; i < reference.size(); i++) {
+    EXPECT_EQ(reference[i], index.all()[i].timestampMillis());
+  }
+
+  for (uint64_t from = 0; from < 1'200; from += 37) {
+    size_t expected = std::lower_bound(reference.begin(), reference.end(), from + 100)
+      - std::lower_bound(reference.begin(), reference.end(), from);
+    EXPECT_EQ(expected, index.count(from, from + 100));
+  }
+}
+
+TEST(UuidIndexTest, LowerBoundMatchesStd) {
+  std::vector< uint64_t > values = {1, 3, 3, 3, 7, 8, 12, 12, 40};
+  for (size_t n = 0; n <= values.size(); n++) {
+    for (uint64_t key = 0; key < 45; key++) {
+      size_t expected = std::lower_bound(values.begin(), values.begin() + n, key)
+        - values.begin();
+      EXPECT_EQ(expected, oasis::uuid::detail::lowerBound(values.data(), n, key));
+    }
+  }
+}
+
+TEST(UuidIndexTest, EraseBeforeDropsOldIds) {
+  oasis::uuid::UuidV7Index index;
+  for (uint64_t ts = 0; ts < 10; ts++) {
+    index.insert(uuidAt(ts));
+  }
+
+  index.eraseBefore(4);
+  EXPECT_EQ(6, index.size());
+  EXPECT_EQ(4, index.all().front().timestampMillis());
+  EXPECT_EQ(0, index.count(0, 4));
+}
@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "uuid.hpp"
+#include "uuid/map.hpp"
+
+TEST(UuidMapTest, EmptyMapHasNoEntries) {
+  oasis::uuid::UuidMap< uint64_t > map;
+  EXPECT_EQ(0, map.size());
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(oasis::uuid::Uuid::v7()));
+  EXPECT_FALSE(map.erase(oasis::uuid::Uuid::v7()));
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(UuidMapTest, CanInsertAndFind) {
+  oasis::uuid::UuidMap< std::string > map;
+  oasis::uuid::Uuid a = oasis::uuid::Uuid::v7();
+  oasis::uuid::Uuid b = oasis::uuid::Uuid::v7();
+
+  EXPECT_TRUE(map.insert(a, "a"));
+  EXPECT_TRUE(map.insert(b, "b"));
+  EXPECT_FALSE(map.insert(a, "not a"));
+  EXPECT_EQ(2, map.size());
+
+  ASSERT_NE(nullptr, map.find(a));
+  EXPECT_EQ("a", *map.find(a));
+  ASSERT_NE(nullptr, map.find(b));
+  EXPECT_EQ("b", *map.find(b));
+  EXPECT_FALSE(map.contains(oasis::uuid::Uuid::v7()));
+}
+
+TEST(UuidMapTest, InsertOrAssignAndSubscriptOverwrite) {
+  oasis::uuid::UuidMap< int > map;
+  oasis::uuid::Uuid a = oasis::uuid::Uuid::v7();
+
+  map[a] = 1;
+  EXPECT_EQ(1, *map.find(a));
+  map.insertOrAssign(a, 2);
+  EXPECT_EQ(2, *map.find(a));
+  map[a]++;
+  EXPECT_EQ(3, *map.find(a));
+  EXPECT_EQ(1, map.size());
+}
+
+TEST(UuidMapTest, MatchesUnorderedMapUnderChurn) {
+  oasis::uuid::UuidMap< uint64_t > map;
+  std::unordered_map< oasis::uuid::Uuid, uint64_t > expected;
+
+  std::vector< oasis::uuid::Uuid > keys(50'000);
+  oasis::uuid::Uuid::v7Batch(keys);
+
+  for (uint64_t i = 0; i < keys.size(); i++) {
+    map.insert(keys[i], i);
+    expected.insert({keys[i], i});
+  }
+  // erase every third key, enough to leave tombstones in full groups
+  for (uint64_t i = 0; i < keys.size(); i += 3) {
+    EXPECT_TRUE(map.erase(keys[i]));
+    expected.erase(keys[i]);
+  }
+  // and reinsert some of them
+  for (uint64_t i = 0; i < keys.size(); i += 6) {
+    map.insert(keys[i], i * 2);
+    expected.insert({keys[i], i * 2});
+  }
+
+  EXPECT_EQ(expected.size(), map.size());
+  for (auto& [key, value] : expected) {
+    ASSERT_NE(nullptr, map.find(key));
+    EXPECT_EQ(value, *map.find(key));
+  }
+
+  size_t iterated = 0;
+  for (auto& slot : map) {
+    EXPECT_EQ(expected.at(slot.key), slot.value);
+    iterated++;
+  }
+  EXPECT_EQ(expected.size(), iterated);
+}
+
+TEST(UuidMapTest, ReserveAvoidsGrowth) {
+  oasis::uuid::UuidMap< uint64_t > map;
+  map.reserve(1'000);
+  size_t capacity = map.capacity();
+  EXPECT_GE(capacity, 1'000);
+
+  for (uint64_t i = 0; i < 1'000; i++) {
+    map.insert(oasis::uuid::Uuid::v7(), i);
+  }
+  EXPECT_EQ(capacity, map.capacity());
+}
+
+TEST(UuidMapTest, ClearKeepsCapacity) {
+  oasis::uuid::UuidMap< uint64_t > map;
+  for (uint64_t i = 0; i < 100; i++) {
+    map.insert(oasis::uuid::Uuid::v7(), i);
+  }
+  size_t capacity = map.capacity();
+
+  map.clear();
+  EXPECT_EQ(0, map.size());
+  EXPECT_EQ(capacity, map.capacity());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(UuidMapTest, CopyAndMove) {
+  oasis::uuid::UuidMap< uint64_t > map;
+  oasis::uuid::Uuid a = oasis::uuid::Uuid::v7();
+  map.insert(a, 42);
+
+  oasis::uuid::UuidMap< uint64_t > copy(map);
+  *copy.find(a) = 43;
+  EXPECT_EQ(42, *map.find(a));
+  EXPECT_EQ(43, *copy.find(a));
+
+  oasis::uuid::UuidMap< uint64_t > moved(std::move(map));
+  EXPECT_EQ(42, *moved.find(a));
+  EXPECT_EQ(0, map.size());
+
+  map = moved;
+  EXPECT_EQ(42, *map.find(a));
+}
+
+static_assert(std::is_nothrow_move_constructible_v< oasis::uuid::UuidMap< std::string > >);
+
+// iterating can change a value but not the key it's stored under
+using MapIter = oasis::uuid::UuidMap< uint64_t >::iterator;
+static_assert(!std::is_assignable_v< decltype((std::declval< MapIter >()->key)), oasis::uuid::Uuid >);
+static_assert(!std::is_assignable_v< decltype(((*std::declval< MapIter >()).key)), oasis::uuid::Uuid >);
+static_assert(std::is_assignable_v< decltype((std::declval< MapIter >()->value)), uint64_t >);
+
+struct ThrowsOnBuild {
+  explicit ThrowsOnBuild(bool fail) {
+    if (fail) {
+      throw std::runtime_error("no");
+    }
+  }
+};
+
+TEST(UuidMapTest, ThrowingConstructorLeavesMapUnchanged) {
+  oasis::uuid::UuidMap< ThrowsOnBuild > map;
+  oasis::uuid::Uuid a = oasis::uuid::Uuid::v7();
+  oasis::uuid::Uuid b = oasis::uuid::Uuid::v7();
+  EXPECT_TRUE(map.tryEmplace(a, false).second);
+
+  EXPECT_THROW(map.tryEmplace(b, true), std::runtime_error);
+  EXPECT_EQ(1, map.size());
+  EXPECT_FALSE(map.contains(b));
+  size_t seen = 0;
+  for (auto& slot : map) {
+    EXPECT_EQ(a, slot.key);
+    seen++;
+  }
+  EXPECT_EQ(1, seen);
+
+  // and the slot is still free for the next insert
+  EXPECT_TRUE(map.tryEmplace(b, false).second);
+  EXPECT_EQ(2, map.size());
+  EXPECT_TRUE(map.contains(b));
+}
+
+TEST(UuidSetTest, CanInsertContainsAndErase) {
+  oasis::uuid::UuidSet set;
+  oasis::uuid::Uuid a = oasis::uuid::Uuid::v7();
+  oasis::uuid::Uuid b = oasis::uuid::Uuid::v7();
+
+  EXPECT_TRUE(set.insert(a));
+  EXPECT_FALSE(set.insert(a));
+  EXPECT_TRUE(set.insert(b));
+  EXPECT_EQ(2, set.size());
+  EXPECT_TRUE(set.contains(a));
+
+  EXPECT_TRUE(set.erase(a));
+  EXPECT_FALSE(set.contains(a));
+  EXPECT_TRUE(set.contains(b));
+
+  size_t iterated = 0;
+  for (const oasis::uuid::Uuid& uuid : set) {
+    EXPECT_EQ(b, uuid);
+    iterated++;
+  }
+  EXPECT_EQ(1, iterated);
+}
+
+TEST(UuidSetTest, SlotsHaveNoValueOverhead) {
+  EXPECT_EQ(sizeof(oasis::uuid::Uuid),
+            sizeof(oasis::uuid::UuidMap< oasis::uuid::detail::Empty >::Slot));
+}
+
+TEST(UuidHashTest, SequentialV7IdsSpreadAcrossBuckets) {
+  std::vector< oasis::uuid::Uuid > keys(1 << 16);
+  oasis::uuid::Uuid::v7Batch(keys);
+
+  // sequential ids differ in a handful of low bits, a weak hash leaves most of
+  // 2^16 buckets empty
+  std::vector< uint32_t > buckets(keys.size());
+  for (auto& key : keys) {
+    buckets[std::hash< oasis::uuid::Uuid >()(key) & (buckets.size() - 1)]++;
+  }
+  size_t used = std::ranges::count_if(buckets, [](uint32_t n) { return n != 0; });
+
+  // a uniform hash fills 1 - 1/e (~63%) of the buckets
+  EXPECT_GT(used, buckets.size() * 6 / 10);
+}
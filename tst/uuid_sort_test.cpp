@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "uuid.hpp"
+#include "uuid/sort.hpp"
+
+TEST(UuidSortTest, OrderingFollowsGenerationOrder) {
+  std::vector< oasis::uuid::Uuid > uuids(10'000);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  EXPECT_TRUE(std::ranges::is_sorted(uuids));
+
+  oasis::uuid::Uuid a = oasis::uuid::Uuid::v7();
+  oasis::uuid::Uuid b = oasis::uuid::Uuid::v7();
+  EXPECT_LT(a, b);
+  EXPECT_GT(b, a);
+  EXPECT_LE(a, a);
+  EXPECT_EQ(std::strong_ordering::equal, a <=> a);
+}
+
+TEST(UuidSortTest, OrderingComparesTimestampFirst) {
+  // later timestamp, but every other bit smaller
+  auto earlier = oasis::uuid::Uuid::fromChars("00000001-0000-fff7-ffff-ffffffffffff").value();
+  auto later = oasis::uuid::Uuid::fromChars("00000002-0000-0007-0000-000000000000").value();
+  EXPECT_LT(earlier, later);
+}
+
+std::vector< oasis::uuid::Uuid > shuffledIds(size_t count, size_t copies) {
+  std::vector< oasis::uuid::Uuid > uuids(count);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  for (size_t c = 1; c < copies; c++) {
+    uuids.insert(uuids.end(), uuids.begin(), uuids.begin() + count);
+  }
+  std::shuffle(uuids.begin(), uuids.end(), std::mt19937_64(5));
+  return uuids;
+}
+
+TEST(UuidSortTest, RadixSortMatchesStdSort) {
+  for (size_t numThreads : {1, 2, 3, 8}) {
+    for (size_t count : {0, 1, 100, 5'000, 300'000}) {
+      auto uuids = shuffledIds(count, 1);
+      auto expected = uuids;
+      std::ranges::sort(expected);
+
+      oasis::uuid::radixSort(uuids, numThreads);
+      EXPECT_EQ(expected, uuids);
+    }
+  }
+}
+
+TEST(UuidSortTest, RadixSortHandlesArbitraryBits) {
+  std::mt19937_64 rng(9);
+  std::vector< std::string > strs;
+  std::vector< oasis::uuid::Uuid > uuids;
+  for (size_t i = 0; i < 50'000; i++) {
+    char str[37];
+    std::snprintf(str, sizeof(str), "%08llx-%04llx-%04llx-%04llx-%012llx",
+                  static_cast<unsigned long long>(rng() & 0xFFFF'FFFF),
+                  static_cast<unsigned long long>(rng() & 0xFFFF),
+                  static_cast<unsigned long long>(rng() & 0xFFFF),
+                  static_cast<unsigned long long>(rng() & 0xFFFF),
+                  static_cast<unsigned long long>(rng() & 0xFFFF'FFFF'FFFF));
+    uuids.push_back(oasis::uuid::Uuid::fromChars(std::string_view(str, 36)).value());
+  }
+  auto expected = uuids;
+  std::ranges::sort(expected);
+
+  oasis::uuid::radixSort(uuids, 4);
+  EXPECT_EQ(expected, uuids);
+}
+
+TEST(UuidSortTest, SortUniqueRemovesDuplicates) {
+  for (size_t numThreads : {1, 2, 4}) {
+    for (size_t copies : {1, 2, 3}) {
+      auto uuids = shuffledIds(200'000, copies);
+      auto expected = uuids;
+      std::ranges::sort(expected);
+      expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+      size_t size = oasis::uuid::sortUnique(uuids, numThreads);
+      ASSERT_EQ(expected.size(), size);
+      uuids.resize(size);
+      EXPECT_EQ(expected, uuids);
+    }
+  }
+}
+
+TEST(UuidSortTest, SortUniqueOfIdenticalIds) {
+  std::vector< oasis::uuid::Uuid > uuids(200'000, oasis::uuid::Uuid::v7());
+  EXPECT_EQ(1, oasis::uuid::sortUnique(uuids, 2));
+}
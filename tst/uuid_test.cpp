@@ -1,9 +1,15 @@
 #include <algorithm>
 #include <charconv>
+#include <cstring>
 #include <gtest/gtest.h>
 #include <sstream>
 #include <string_view>
+#include <thread>
 #include <unordered_set>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "uuid.hpp"
 #include "time.hpp"
@@ -30,8 +36,30 @@ bool vtonum(const std::string_view &view, T& value, int base = 10) {
   return true;
 }
 
+// recovers the (timestamp, rand_a, rand_b) ordering key of a uuid from its
+// string form, see Uuid::toDisplayBytes for the layout
+std::pair<uint64_t, uint64_t> orderingKey(const oasis::uuid::Uuid& uuid) {
+  std::stringstream ss;
+  ss << uuid;
+  std::string str = ss.str();
+  std::string_view view(str);
+
+  uint64_t first, second, third, fourth, fifth;
+  vtonum(view.substr(0, 8), first, 16);
+  vtonum(view.substr(9, 4), second, 16);
+  vtonum(view.substr(14, 4), third, 16);
+  vtonum(view.substr(19, 4), fourth, 16);
+  vtonum(view.substr(24, 12), fifth, 16);
+
+  uint64_t timestamp = first | (second << 32);
+  uint64_t randA = third >> 4;
+  uint64_t hi = fourth | (fifth << 16);
+  return { (timestamp << 12) | randA, hi };
+}
+
 TEST(UuidTest, CanConstructV7Uuid) {
   oasis::uuid::Uuid v7 = oasis::uuid::Uuid::v7();
+  EXPECT_NE(oasis::uuid::Uuid(), v7);
 }
 
 TEST(UuidTest, CanFormatUuid) {
@@ -93,3 +121,393 @@ TEST(UuidTest, CanUseUuidsInMap) {
 
   EXPECT_EQ(3, uuids.size());
 }
+
+TEST(UuidTest, V7UuidsFromOneThreadAreStrictlyIncreasing) {
+  std::vector< oasis::uuid::Uuid > uuids;
+  for (int i = 0; i < 100'000; i++) {
+    uuids.push_back(oasis::uuid::Uuid::v7());
+  }
+
+  for (size_t i = 1; i < uuids.size(); i++) {
+    EXPECT_LT(orderingKey(uuids[i - 1]), orderingKey(uuids[i]));
+  }
+}
+
+TEST(UuidTest, V7GeneratorSetsVersionAndVariant) {
+  oasis::uuid::UuidV7Generator generator(42);
+  for (int i = 0; i < 1'000; i++) {
+    std::stringstream ss;
+    ss << generator.next();
+    std::string uuidStr = ss.str();
+
+    uint64_t third, fourth;
+    EXPECT_TRUE(vtonum(std::string_view(uuidStr).substr(14, 4), third, 16));
+    EXPECT_TRUE(vtonum(std::string_view(uuidStr).substr(19, 4), fourth, 16));
+    EXPECT_EQ(7, third & 0b1111);
+    EXPECT_EQ(0b10, fourth & 0b11);
+  }
+}
+
+TEST(UuidTest, V7UuidsAreUniqueAcrossThreads) {
+  const int numThreads = 4;
+  const int perThread = 10'000;
+  std::vector< std::vector< oasis::uuid::Uuid > > results(numThreads);
+
+  std::vector< std::thread > threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([&results, t]() {
+      for (int i = 0; i < perThread; i++) {
+        results[t].push_back(oasis::uuid::Uuid::v7());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::unordered_set< oasis::uuid::Uuid > uuids;
+  for (auto& result : results) {
+    uuids.insert(result.begin(), result.end());
+  }
+  EXPECT_EQ(numThreads * perThread, uuids.size());
+}
+
+TEST(UuidTest, V7UuidsStayIncreasingAcrossClocks) {
+  // the coarse and cached clocks lag the others by up to a tick
+  oasis::time::CachedClock::Session session;
+  std::vector< oasis::uuid::Uuid > uuids;
+  for (int i = 0; i < 10'000; i++) {
+    uuids.push_back(oasis::uuid::Uuid::v7< oasis::time::CoarseRealtimeClock >());
+    uuids.push_back(oasis::uuid::Uuid::v7());
+    uuids.push_back(oasis::uuid::Uuid::v7< oasis::time::TscClock >());
+    uuids.push_back(oasis::uuid::Uuid::v7< oasis::time::CachedClock >());
+  }
+
+  for (size_t i = 1; i < uuids.size(); i++) {
+    EXPECT_LT(orderingKey(uuids[i - 1]), orderingKey(uuids[i]));
+  }
+}
+
+TEST(UuidTest, V7BatchFillsSpanInIncreasingOrder) {
+  // spans several generator blocks, with a partial block at the end
+  std::vector< oasis::uuid::Uuid > uuids(5'000);
+  oasis::uuid::Uuid::v7Batch(uuids);
+
+  for (size_t i = 1; i < uuids.size(); i++) {
+    EXPECT_LT(orderingKey(uuids[i - 1]), orderingKey(uuids[i]));
+  }
+}
+
+TEST(UuidTest, V7BatchContinuesOrderFromPerCallIds) {
+  oasis::uuid::Uuid before = oasis::uuid::Uuid::v7();
+  std::vector< oasis::uuid::Uuid > uuids(3);
+  oasis::uuid::Uuid::v7Batch(uuids);
+  oasis::uuid::Uuid after = oasis::uuid::Uuid::v7();
+
+  EXPECT_LT(orderingKey(before), orderingKey(uuids.front()));
+  EXPECT_LT(orderingKey(uuids.back()), orderingKey(after));
+}
+
+// RFC 8439 section 2.3.2
+TEST(UuidTest, ChaChaBlockMatchesRfcTestVector) {
+  uint32_t key[8];
+  for (uint32_t w = 0; w < 8; w++) {
+    key[w] = (4 * w) | ((4 * w + 1) << 8) | ((4 * w + 2) << 16) | ((4 * w + 3) << 24);
+  }
+  // the RFC's 32-bit counter of 1 and 96-bit nonce, split 64/64
+  uint64_t counter = (0x0900'0000LLU << 32) | 1;
+  uint64_t nonce = 0x4A00'0000LLU;
+
+  const uint32_t expected[16] = {
+    0xE4E7'F110, 0x1559'3BD1, 0x1FDD'0F50, 0xC471'20A3,
+    0xC7F4'D1C7, 0x0368'C033, 0x9AAA'2204, 0x4E6C'D4C3,
+    0x4664'82D2, 0x09AA'9F07, 0x05D7'C214, 0xA202'8BD9,
+    0xD19C'12B5, 0xB94E'16DE, 0xE883'D0CB, 0x4E3C'50A2,
+  };
+  uint32_t out[16];
+  oasis::uuid::detail::chachaBlockScalar(key, counter, nonce, out);
+  EXPECT_TRUE(std::equal(out, out + 16, expected));
+}
+
+TEST(UuidTest, ChaChaKernelsMatchScalar) {
+  uint32_t key[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  // 8 + 4 + 1 blocks, with the counter crossing into its high word
+  const size_t n = 13;
+  uint64_t counter = 0xFFFF'FFFALLU;
+
+  std::vector< uint32_t > expected(n * 16);
+  for (size_t b = 0; b < n; b++) {
+    oasis::uuid::detail::chachaBlockScalar(key, counter + b, 77, expected.data() + b * 16);
+  }
+  std::vector< uint32_t > actual(n * 16);
+  oasis::uuid::detail::chachaBlocks(key, counter, 77, actual.data(), n);
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(UuidTest, V4GeneratorSetsVersionAndVariant) {
+  oasis::uuid::UuidV4Generator generator;
+  for (int i = 0; i < 1'000; i++) {
+    oasis::uuid::Uuid uuid = generator.next();
+    EXPECT_EQ(4, uuid.version());
+
+    char str[oasis::uuid::Uuid::stringLength];
+    uuid.toChars(str);
+    uint64_t third, fourth;
+    EXPECT_TRUE(vtonum(std::string_view(str + 14, 4), third, 16));
+    EXPECT_TRUE(vtonum(std::string_view(str + 19, 4), fourth, 16));
+    EXPECT_EQ(4, third & 0b1111);
+    EXPECT_EQ(0b10, fourth & 0b11);
+  }
+}
+
+TEST(UuidTest, V4BitsAreBalanced) {
+  std::vector< oasis::uuid::Uuid > uuids(20'000);
+  oasis::uuid::Uuid::v4Batch(uuids);
+
+  size_t ones[128] = {};
+  for (auto& uuid : uuids) {
+    char str[oasis::uuid::Uuid::stringLength];
+    uuid.toChars(str);
+    size_t bit = 0;
+    for (char c : str) {
+      if (c == '-') {
+        continue;
+      }
+      int value = c <= '9' ? c - '0' : c - 'a' + 10;
+      for (int b = 3; b >= 0; b--) {
+        ones[bit++] += (value >> b) & 1;
+      }
+    }
+  }
+
+  for (size_t bit = 0; bit < 128; bit++) {
+    // the version and variant bits, at the end of the third and fourth
+    // groups of the string form
+    bool fixed = (bit >= 60 && bit < 64) || bit == 78 || bit == 79;
+    if (!fixed) {
+      EXPECT_NEAR(10'000, ones[bit], 600) << "bit " << bit;
+    }
+  }
+}
+
+TEST(UuidTest, V4GeneratorWithKeyIsReproducible) {
+  const uint32_t key[8] = {8, 7, 6, 5, 4, 3, 2, 1};
+  oasis::uuid::UuidV4Generator a(key);
+  oasis::uuid::UuidV4Generator b(key);
+
+  // next() and fill() hand out the same stream, across several refills
+  std::vector< oasis::uuid::Uuid > expected;
+  for (int i = 0; i < 500; i++) {
+    expected.push_back(a.next());
+  }
+  std::vector< oasis::uuid::Uuid > actual(500);
+  b.fill(std::span(actual).first(7));
+  b.fill(std::span(actual).subspan(7));
+  EXPECT_EQ(expected, actual);
+
+  std::unordered_set< oasis::uuid::Uuid > unique(actual.begin(), actual.end());
+  EXPECT_EQ(500, unique.size());
+}
+
+TEST(UuidTest, V4UuidsDifferAfterFork) {
+  // make sure the generator is initialized before the fork
+  oasis::uuid::Uuid::v4();
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    oasis::uuid::Uuid uuid = oasis::uuid::Uuid::v4();
+    ssize_t written = write(fds[1], &uuid, sizeof(uuid));
+    _exit(written == sizeof(uuid) ? 0 : 1);
+  }
+
+  oasis::uuid::Uuid parent = oasis::uuid::Uuid::v4();
+  oasis::uuid::Uuid child;
+  ASSERT_EQ(sizeof(child), read(fds[0], &child, sizeof(child)));
+  int status;
+  waitpid(pid, &status, 0);
+  close(fds[0]);
+  close(fds[1]);
+
+  EXPECT_NE(parent, child);
+}
+
+// a wall clock stuck in one millisecond, so ids made after a fork can only
+// differ in their counter and random bits
+struct FrozenClock {
+  static constexpr bool sinceEpoch = true;
+
+  static uint64_t nowNanos() { return 1'700'000'000'000'000'000; }
+};
+
+TEST(UuidTest, V7UuidsDifferAfterFork) {
+  oasis::uuid::UuidV7Generator generator(42);
+  generator.next<FrozenClock>();
+
+  oasis::uuid::Uuid ids[2];
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    ids[0] = generator.next<FrozenClock>();
+    generator.fill<FrozenClock>(std::span(ids + 1, 1));
+    ssize_t written = write(fds[1], ids, sizeof(ids));
+    _exit(written == sizeof(ids) ? 0 : 1);
+  }
+
+  oasis::uuid::Uuid parent[2];
+  parent[0] = generator.next<FrozenClock>();
+  generator.fill<FrozenClock>(std::span(parent + 1, 1));
+  ASSERT_EQ(sizeof(ids), read(fds[0], ids, sizeof(ids)));
+  int status;
+  waitpid(pid, &status, 0);
+  close(fds[0]);
+  close(fds[1]);
+
+  EXPECT_NE(parent[0], ids[0]);
+  EXPECT_NE(parent[1], ids[1]);
+}
+
+TEST(UuidTest, DefaultConstructedUuidIsNil) {
+  std::stringstream ss;
+  ss << oasis::uuid::Uuid();
+  EXPECT_EQ("00000000-0000-0000-0000-000000000000", ss.str());
+}
+
+TEST(UuidTest, ToCharsMatchesStreamFormatting) {
+  for (int i = 0; i < 1'000; i++) {
+    oasis::uuid::Uuid uuid = oasis::uuid::Uuid::v7();
+    std::stringstream ss;
+    ss << uuid;
+
+    char str[oasis::uuid::Uuid::stringLength];
+    uuid.toChars(str);
+    EXPECT_EQ(ss.str(), std::string_view(str, sizeof(str)));
+  }
+}
+
+TEST(UuidTest, FromCharsRoundTrips) {
+  for (int i = 0; i < 1'000; i++) {
+    oasis::uuid::Uuid uuid = oasis::uuid::Uuid::v7();
+    char str[oasis::uuid::Uuid::stringLength];
+    uuid.toChars(str);
+
+    auto parsed = oasis::uuid::Uuid::fromChars(std::string_view(str, sizeof(str)));
+    EXPECT_TRUE(parsed.has_value());
+    EXPECT_EQ(uuid, parsed.value());
+  }
+}
+
+TEST(UuidTest, FromCharsAcceptsUppercase) {
+  auto lower = oasis::uuid::Uuid::fromChars("f81d4fae-7dec-11d0-a765-00a0c91e6bf6");
+  auto upper = oasis::uuid::Uuid::fromChars("F81D4FAE-7DEC-11D0-A765-00A0C91E6BF6");
+  EXPECT_TRUE(lower.has_value());
+  EXPECT_TRUE(upper.has_value());
+  EXPECT_EQ(lower.value(), upper.value());
+
+  std::stringstream ss;
+  ss << upper.value();
+  EXPECT_EQ("f81d4fae-7dec-11d0-a765-00a0c91e6bf6", ss.str());
+}
+
+TEST(UuidTest, FromCharsRejectsMalformedInput) {
+  using oasis::uuid::Uuid;
+  using oasis::uuid::UuidParseError;
+
+  EXPECT_EQ(UuidParseError::InvalidLength,
+            Uuid::fromChars("f81d4fae-7dec-11d0-a765-00a0c91e6bf").error());
+  EXPECT_EQ(UuidParseError::InvalidLength,
+            Uuid::fromChars("f81d4fae-7dec-11d0-a765-00a0c91e6bf60").error());
+  EXPECT_EQ(UuidParseError::MissingSeparator,
+            Uuid::fromChars("f81d4fae07dec-11d0-a765-00a0c91e6bf6").error());
+  EXPECT_EQ(UuidParseError::MissingSeparator,
+            Uuid::fromChars("f81d4fae-7dec-11d0-a765000a0c91e6bf6").error());
+  EXPECT_EQ(UuidParseError::InvalidHexDigit,
+            Uuid::fromChars("g81d4fae-7dec-11d0-a765-00a0c91e6bf6").error());
+  EXPECT_EQ(UuidParseError::InvalidHexDigit,
+            Uuid::fromChars("f81d4fae-7dec-11d0-a765-00a0c91e6bf:").error());
+  EXPECT_EQ(UuidParseError::InvalidHexDigit,
+            Uuid::fromChars("f81d4fae-7dec-11d0-a765-00a0c91e6b f").error());
+}
+
+TEST(UuidTest, ToCharsManyAndFromCharsManyRoundTrip) {
+  // odd count so the vectorized pairs and the scalar tail are both exercised
+  std::vector< oasis::uuid::Uuid > uuids(33);
+  oasis::uuid::Uuid::v7Batch(uuids);
+
+  std::vector< char > str(oasis::uuid::Uuid::stringLength * uuids.size());
+  oasis::uuid::toCharsMany(uuids, str);
+
+  for (size_t i = 0; i < uuids.size(); i++) {
+    char expected[oasis::uuid::Uuid::stringLength];
+    uuids[i].toChars(expected);
+    EXPECT_EQ(0, std::memcmp(expected, str.data() + i * sizeof(expected), sizeof(expected)));
+  }
+
+  std::vector< oasis::uuid::Uuid > parsed(uuids.size());
+  EXPECT_EQ(uuids.size(), oasis::uuid::fromCharsMany(str, parsed));
+  EXPECT_EQ(uuids, parsed);
+}
+
+TEST(UuidTest, FromCharsManyStopsAtFirstInvalid) {
+  std::vector< oasis::uuid::Uuid > uuids(4);
+  oasis::uuid::Uuid::v7Batch(uuids);
+
+  std::vector< char > str(oasis::uuid::Uuid::stringLength * uuids.size());
+  oasis::uuid::toCharsMany(uuids, str);
+  str[2 * oasis::uuid::Uuid::stringLength + 3] = 'x';
+
+  std::vector< oasis::uuid::Uuid > parsed(uuids.size());
+  EXPECT_EQ(2, oasis::uuid::fromCharsMany(str, parsed));
+}
+
+TEST(UuidTest, ParseManyParsesValidStrings) {
+  std::vector< oasis::uuid::Uuid > uuids(37);
+  oasis::uuid::Uuid::v7Batch(uuids);
+
+  std::vector< std::string > strs;
+  for (auto& uuid : uuids) {
+    std::stringstream ss;
+    ss << uuid;
+    strs.push_back(ss.str());
+  }
+  std::vector< std::string_view > views(strs.begin(), strs.end());
+
+  std::vector< oasis::uuid::Uuid > parsed(uuids.size());
+  std::vector< oasis::uuid::UuidParseFailure > failures;
+  EXPECT_EQ(uuids.size(), oasis::uuid::parseMany(views, parsed, failures));
+  EXPECT_TRUE(failures.empty());
+  EXPECT_EQ(uuids, parsed);
+}
+
+TEST(UuidTest, ParseManyReportsFailingIndices) {
+  std::vector< std::string > strs(40, "f81d4fae-7dec-11d0-a765-00a0c91e6bf6");
+  strs[3] = "f81d4fae-7dec-11d0-a765-00a0c91e6bf";
+  strs[17] = "f81d4fae-7dec-11d0+a765-00a0c91e6bf6";
+  strs[18] = "f81d4fae-7dec-11d0-a765-00a0c91e6bfz";
+  strs[39] = "";
+  std::vector< std::string_view > views(strs.begin(), strs.end());
+
+  std::vector< oasis::uuid::Uuid > parsed(strs.size());
+  std::vector< oasis::uuid::UuidParseFailure > failures;
+  EXPECT_EQ(36, oasis::uuid::parseMany(views, parsed, failures));
+
+  ASSERT_EQ(4, failures.size());
+  EXPECT_EQ(3, failures[0].index);
+  EXPECT_EQ(oasis::uuid::UuidParseError::InvalidLength, failures[0].error);
+  EXPECT_EQ(17, failures[1].index);
+  EXPECT_EQ(oasis::uuid::UuidParseError::MissingSeparator, failures[1].error);
+  EXPECT_EQ(18, failures[2].index);
+  EXPECT_EQ(oasis::uuid::UuidParseError::InvalidHexDigit, failures[2].error);
+  EXPECT_EQ(39, failures[3].index);
+  EXPECT_EQ(oasis::uuid::UuidParseError::InvalidLength, failures[3].error);
+
+  oasis::uuid::Uuid expected = oasis::uuid::Uuid::fromChars(strs[0]).value();
+  EXPECT_EQ(expected, parsed[0]);
+  EXPECT_EQ(oasis::uuid::Uuid(), parsed[3]);
+  EXPECT_EQ(oasis::uuid::Uuid(), parsed[18]);
+  EXPECT_EQ(expected, parsed[38]);
+}